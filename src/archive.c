@@ -0,0 +1,995 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, archive.c, contains the implementation of the game archive
+  functions used in Star Traders.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  A game archive consists of an eight-byte header (ARCHIVE_MAGIC),
+  followed by one or more blocks, followed by an index of those blocks.
+  The last sixteen bytes of the file give the offset of the index (eight
+  bytes, least significant first) and ARCHIVE_INDEX_MAGIC.  There may be
+  unused space (superseded blocks and indexes) between blocks and before
+  the index.
+
+  Each block holds up to ARCHIVE_BLOCK_GAMES games.  It starts with a
+  directory: the number of games and of columns, then the column number,
+  number of values and length in bytes of each column.  The columns
+  themselves follow, one after the other, so that any one column can be
+  decoded without touching the others.  The index lists the offset,
+  length and number of games of every block.
+
+  All numbers in directories and in the index are unsigned LEB128
+  varints.  Within a column, integers are stored as the zigzag-encoded
+  difference from the previous value; floating-point numbers are stored
+  as their bits XORed with those of the previous value, which for
+  similar values leaves mostly zero bits: one byte gives the number of
+  trailing zero bits, then a varint gives the remaining bits.
+
+  New games are added to the last block until it is full.  The new or
+  enlarged block, a new index and a new trailer are always appended to
+  the end of the file, so that the archive stays valid (with its old
+  contents) if the program is interrupted at any point.  Once more than
+  half the file is unused space, the archive is copied without it to a
+  temporary file that then replaces the original.
+*/
+
+
+/************************************************************************
+*                        Module-specific macros                         *
+************************************************************************/
+
+#define ARCHIVE_MAGIC		"STRARC01"	// Start of every game archive
+#define ARCHIVE_INDEX_MAGIC	"STRIDX01"	// End of every game archive
+#define ARCHIVE_MAGIC_LEN	8		// Length of both magic strings
+#define ARCHIVE_TRAILER_LEN	16		// Index offset and index magic
+
+#define ARCHIVE_MAX_SIZE	(256 * 1024 * 1024)	// Sanity limit for reads
+#define ARCHIVE_TMP_SUFFIX	".tmp"		// Used while compacting
+
+#define DOUBLE_ZERO_XOR		64		// Trailing zeros if XOR is zero
+
+#define ACOL_FIXED		ARCHIVE_NUM_COLUMNS	// No count column
+
+
+/************************************************************************
+*            Module-specific constants and type declarations            *
+************************************************************************/
+
+// How the values in a column are encoded
+typedef enum column_type {
+    CTYPE_INT,				// Zigzag-encoded differences
+    CTYPE_DOUBLE			// Bits XORed with previous value
+} column_type_t;
+
+// Description of each column
+typedef struct column_desc {
+    const char		*name;		// Name used on the command line
+    column_type_t	type;		// How values are encoded
+    int			width;		// Values per game (or per count)
+    archive_column_t	count_col;	// Column giving count, or ACOL_FIXED
+} column_desc_t;
+
+// Description of every column, in the same order as archive_column_t
+static const column_desc_t column_desc[ARCHIVE_NUM_COLUMNS] = {
+    { "time",          CTYPE_INT,    1,             ACOL_FIXED      },
+    { "seed",          CTYPE_INT,    1,             ACOL_FIXED      },
+    { "loaded",        CTYPE_INT,    1,             ACOL_FIXED      },
+    { "max_turn",      CTYPE_INT,    1,             ACOL_FIXED      },
+    { "turns",         CTYPE_INT,    1,             ACOL_FIXED      },
+    { "players",       CTYPE_INT,    1,             ACOL_FIXED      },
+    { "first_player",  CTYPE_INT,    1,             ACOL_FIXED      },
+    { "interest_rate", CTYPE_DOUBLE, 1,             ACOL_FIXED      },
+    { "move_count",    CTYPE_INT,    1,             ACOL_FIXED      },
+    { "moves",         CTYPE_INT,    1,             ACOL_MOVE_COUNT },
+    { "cash",          CTYPE_DOUBLE, 1,             ACOL_PLAYERS    },
+    { "debt",          CTYPE_DOUBLE, 1,             ACOL_PLAYERS    },
+    { "in_game",       CTYPE_INT,    1,             ACOL_PLAYERS    },
+    { "stock_owned",   CTYPE_INT,    MAX_COMPANIES, ACOL_PLAYERS    },
+    { "share_price",   CTYPE_DOUBLE, MAX_COMPANIES, ACOL_FIXED      },
+    { "share_return",  CTYPE_DOUBLE, MAX_COMPANIES, ACOL_FIXED      },
+    { "stock_issued",  CTYPE_INT,    MAX_COMPANIES, ACOL_FIXED      },
+    { "max_stock",     CTYPE_INT,    MAX_COMPANIES, ACOL_FIXED      },
+    { "on_map",        CTYPE_INT,    MAX_COMPANIES, ACOL_FIXED      }
+};
+
+// The values of one column, as integers or as the bits of doubles
+typedef struct column_buf {
+    uint64_t		*val;
+    size_t		count;
+    size_t		alloc;
+} column_buf_t;
+
+// One block of the archive, fully decoded
+typedef struct archive_block {
+    uint64_t		ngames;
+    column_buf_t	col[ARCHIVE_NUM_COLUMNS];
+} archive_block_t;
+
+// Where a column is stored within a raw block
+typedef struct column_dir {
+    bool		present;
+    uint64_t		count;		// Number of values
+    const unsigned char	*data;		// Start of encoded values
+    size_t		len;		// Length of encoded values
+} column_dir_t;
+
+// Entry in the archive index
+typedef struct block_info {
+    uint64_t		offset;
+    uint64_t		len;
+    uint64_t		ngames;
+} block_info_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static unsigned char *recorded_moves = NULL;	// Selections, in order
+static size_t num_recorded_moves = 0;
+static size_t alloc_recorded_moves = 0;
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   add_value - Add a value to a column buffer
+  Parameters: col       - Column buffer
+              val       - Value (integer or bits of a double)
+  Returns:    (nothing)
+*/
+static void add_value (column_buf_t *col, uint64_t val);
+
+
+/*
+  Function:   add_int    - Add an integer value to a column buffer
+  Function:   add_double - Add a floating-point value to a column buffer
+  Parameters: col        - Column buffer
+              val        - Value to add
+  Returns:    (nothing)
+*/
+static void add_int (column_buf_t *col, int64_t val);
+static void add_double (column_buf_t *col, double val);
+
+
+/*
+  Function:   encode_column - Encode the values of a column
+  Parameters: buf           - Buffer to append the encoded values to
+              type          - How the values are to be encoded
+              col           - Values to encode
+  Returns:    (nothing)
+*/
+static void encode_column (byte_buf_t *restrict buf, column_type_t type,
+			   const column_buf_t *restrict col);
+
+
+/*
+  Function:   decode_column - Decode the values of a column
+  Parameters: dir           - Location of the encoded values
+              type          - How the values were encoded
+              col           - Column buffer to append values to
+  Returns:    bool          - True if the values could be decoded
+*/
+static bool decode_column (const column_dir_t *restrict dir,
+			   column_type_t type, column_buf_t *restrict col);
+
+
+/*
+  Function:   read_index - Read the index of a game archive
+  Parameters: file       - Game archive, open for reading
+              filename   - Name of the game archive, for messages
+              index_off  - Offset of the index (output)
+              nblocks    - Number of blocks (output)
+  Returns:    block_info_t * - Newly allocated array of blocks
+
+  This function reads and checks the index of a game archive.  The
+  program is terminated with a message if it is not valid.
+*/
+static block_info_t *read_index (FILE *restrict file,
+				 const char *restrict filename,
+				 uint64_t *restrict index_off,
+				 size_t *restrict nblocks);
+
+
+/*
+  Function:   read_block - Read a block of a game archive
+  Parameters: file       - Game archive, open for reading
+              filename   - Name of the game archive, for messages
+              info       - Which block to read
+              dir        - Where each column is stored (output)
+  Returns:    unsigned char * - Newly allocated raw block
+
+  This function reads a block into memory and fills in dir[] from the
+  block's directory; columns in dir[] point into the returned block.  The
+  program is terminated with a message if the block is not valid.
+*/
+static unsigned char *read_block (FILE *restrict file,
+				  const char *restrict filename,
+				  const block_info_t *restrict info,
+				  column_dir_t dir[ARCHIVE_NUM_COLUMNS]);
+
+
+/*
+  Function:   encode_block - Encode a block of a game archive
+  Parameters: buf          - Buffer to append the encoded block to
+              block        - Block to encode
+  Returns:    (nothing)
+*/
+static void encode_block (byte_buf_t *restrict buf,
+			  const archive_block_t *restrict block);
+
+
+/*
+  Function:   encode_index - Encode the index and trailer of an archive
+  Parameters: buf          - Buffer to append the index and trailer to
+              blocks       - Blocks in the archive
+              nblocks      - Number of blocks
+              index_off    - Offset at which the index will be written
+  Returns:    (nothing)
+*/
+static void encode_index (byte_buf_t *restrict buf,
+			  const block_info_t *restrict blocks,
+			  size_t nblocks, uint64_t index_off);
+
+
+/*
+  Function:   compact_archive - Remove unused space from a game archive
+  Parameters: file            - Game archive, open for reading
+              filename        - Name of the game archive
+              blocks          - Blocks in the archive
+              nblocks         - Number of blocks
+  Returns:    (nothing)
+
+  This function copies each block in turn to a temporary file, followed
+  by a new index, then renames the temporary file to filename.  If any
+  of this fails, the temporary file is removed and the game archive is
+  left as it was: it is still valid, just larger than it need be.
+*/
+static void compact_archive (FILE *restrict file,
+			     const char *restrict filename,
+			     const block_info_t *restrict blocks,
+			     size_t nblocks);
+
+
+/*
+  Function:   add_current_game - Add the current game to a block
+  Parameters: block            - Block to add the game to
+  Returns:    (nothing)
+*/
+static void add_current_game (archive_block_t *block);
+
+
+/************************************************************************
+*                   Game archive function definitions                   *
+************************************************************************/
+
+/* These functions are documented either in the file "archive.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// archive_record_move: Remember a move for the game archive
+
+void archive_record_move (selection_t selection)
+{
+    if (option_archive == NULL) {
+	return;
+    }
+
+    if (num_recorded_moves == alloc_recorded_moves) {
+	alloc_recorded_moves = (alloc_recorded_moves == 0) ?
+	    (size_t) DEFAULT_MAX_TURN * MAX_PLAYERS : alloc_recorded_moves * 2;
+	recorded_moves = xrealloc(recorded_moves, alloc_recorded_moves);
+    }
+
+    assert(selection >= 0 && selection <= UCHAR_MAX);
+    recorded_moves[num_recorded_moves++] = selection;
+}
+
+
+/***********************************************************************/
+// archive_game: Append the current game to the game archive
+
+void archive_game (void)
+{
+    const char *filename = option_archive;
+    FILE *file;
+    block_info_t *blocks;
+    size_t nblocks;
+    uint64_t index_off, live_len;
+    off_t end_off;
+    archive_block_t block;
+    byte_buf_t buf;
+    int saved_errno;
+    int i;
+
+
+    if (filename == NULL || abort_game) {
+	return;
+    }
+
+    memset(&block, 0, sizeof(block));
+    memset(&buf, 0, sizeof(buf));
+
+    file = fopen(filename, "r+b");
+    if (file == NULL && errno == ENOENT) {
+	// Start a new game archive
+	file = fopen(filename, "w+b");
+	if (file == NULL) {
+	    errno_exit("%s", filename);
+	}
+	if (fwrite(ARCHIVE_MAGIC, 1, ARCHIVE_MAGIC_LEN, file)
+	    != ARCHIVE_MAGIC_LEN) {
+	    errno_exit("%s", filename);
+	}
+
+	blocks = NULL;
+	nblocks = 0;
+	index_off = ARCHIVE_MAGIC_LEN;
+    } else if (file == NULL) {
+	errno_exit("%s", filename);
+    } else {
+	blocks = read_index(file, filename, &index_off, &nblocks);
+    }
+
+    // Add to the last block if it is not yet full
+    if (nblocks > 0 && blocks[nblocks - 1].ngames < ARCHIVE_BLOCK_GAMES) {
+	column_dir_t dir[ARCHIVE_NUM_COLUMNS];
+	unsigned char *data;
+
+	data = read_block(file, filename, &blocks[nblocks - 1], dir);
+	for (i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	    if (! decode_column(&dir[i], column_desc[i].type, &block.col[i])) {
+		err_exit(_("%s: corrupt game archive"), filename);
+	    }
+	}
+	free(data);
+
+	block.ngames = blocks[nblocks - 1].ngames;
+	nblocks--;
+    }
+
+    add_current_game(&block);
+
+    /* Append the (new or enlarged) block, then the index and trailer,
+       to the end of the file.  Nothing already in the file is touched:
+       until the new trailer is complete, the old one is still the last
+       thing in the file. */
+    if (fseeko(file, 0, SEEK_END) != 0 || (end_off = ftello(file)) < 0) {
+	errno_exit("%s", filename);
+    }
+
+    encode_block(&buf, &block);
+
+    blocks = xrealloc(blocks, (nblocks + 1) * sizeof(block_info_t));
+    blocks[nblocks].offset = end_off;
+    blocks[nblocks].len    = buf.len;
+    blocks[nblocks].ngames = block.ngames;
+    nblocks++;
+
+    index_off = end_off + buf.len;
+    encode_index(&buf, blocks, nblocks, index_off);
+
+    if (fwrite(buf.data, 1, buf.len, file) != buf.len
+	|| fflush(file) != 0) {
+	// Leave the archive as it was before this game, if possible
+	saved_errno = errno;
+	fclose(file);
+	if (truncate(filename, end_off) == 0) {
+	    errno = saved_errno;
+	}
+	errno_exit("%s", filename);
+    }
+
+    // Reclaim the unused space once it takes up most of the file
+    for (live_len = 0, i = 0; (size_t) i < nblocks; i++) {
+	live_len += blocks[i].len;
+    }
+    if (index_off - ARCHIVE_MAGIC_LEN - live_len > live_len) {
+	compact_archive(file, filename, blocks, nblocks);
+    }
+
+    if (fclose(file) == EOF) {
+	errno_exit("%s", filename);
+    }
+
+    for (i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	free(block.col[i].val);
+    }
+    free(buf.data);
+    free(blocks);
+
+    // Moves for any following game start afresh
+    num_recorded_moves = 0;
+}
+
+
+/***********************************************************************/
+// archive_print_column: Print one column of a game archive
+
+void archive_print_column (const char *filename, const char *name)
+{
+    FILE *file;
+    block_info_t *blocks;
+    size_t nblocks;
+    uint64_t index_off;
+    archive_column_t colnum;
+    const column_desc_t *desc;
+    char dbuf[DTOSTR_BUFSIZE];
+
+
+    assert(filename != NULL);
+    assert(name != NULL);
+
+    for (colnum = 0; colnum < ARCHIVE_NUM_COLUMNS; colnum++) {
+	if (strcmp(column_desc[colnum].name, name) == 0) {
+	    break;
+	}
+    }
+    if (colnum == ARCHIVE_NUM_COLUMNS) {
+	err_exit(_("unknown game archive column '%s'"), name);
+    }
+    desc = &column_desc[colnum];
+
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+	errno_exit("%s", filename);
+    }
+
+    blocks = read_index(file, filename, &index_off, &nblocks);
+
+    for (size_t n = 0; n < nblocks; n++) {
+	column_dir_t dir[ARCHIVE_NUM_COLUMNS];
+	column_buf_t col, counts;
+	unsigned char *data;
+	size_t v;
+
+	memset(&col, 0, sizeof(col));
+	memset(&counts, 0, sizeof(counts));
+
+	// Decode only the requested column and its count column
+	data = read_block(file, filename, &blocks[n], dir);
+	if (! decode_column(&dir[colnum], desc->type, &col)
+	    || (desc->count_col != ACOL_FIXED
+		&& ! decode_column(&dir[desc->count_col],
+				   column_desc[desc->count_col].type,
+				   &counts))) {
+	    err_exit(_("%s: corrupt game archive"), filename);
+	}
+
+	v = 0;
+	for (uint64_t g = 0; g < blocks[n].ngames; g++) {
+	    uint64_t num;
+
+	    if (! dir[colnum].present) {
+		// Column was not written by this version of Star Traders
+		num = 0;
+	    } else if (desc->count_col == ACOL_FIXED) {
+		num = desc->width;
+	    } else if (g < counts.count) {
+		num = counts.val[g] * desc->width;
+	    } else {
+		err_exit(_("%s: corrupt game archive"), filename);
+	    }
+
+	    if (num > col.count - v) {
+		err_exit(_("%s: corrupt game archive"), filename);
+	    }
+
+	    for (uint64_t j = 0; j < num; j++, v++) {
+		if (j > 0) {
+		    putchar(' ');
+		}
+		if (desc->type == CTYPE_DOUBLE) {
+		    double d;
+
+		    memcpy(&d, &col.val[v], sizeof(d));
+		    fputs(xdtostr(dbuf, sizeof(dbuf), d), stdout);
+		} else {
+		    printf("%" PRId64, (int64_t) col.val[v]);
+		}
+	    }
+	    putchar('\n');
+	}
+
+	free(col.val);
+	free(counts.val);
+	free(data);
+    }
+
+    if (fclose(file) == EOF) {
+	errno_exit("%s", filename);
+    }
+    free(blocks);
+}
+
+
+/***********************************************************************/
+// add_value: Add a value to a column buffer
+
+void add_value (column_buf_t *col, uint64_t val)
+{
+    if (col->count == col->alloc) {
+	col->alloc = (col->alloc == 0) ? BUFSIZE : col->alloc * 2;
+	col->val = xrealloc(col->val, col->alloc * sizeof(uint64_t));
+    }
+
+    col->val[col->count++] = val;
+}
+
+
+/***********************************************************************/
+// add_int: Add an integer value to a column buffer
+
+void add_int (column_buf_t *col, int64_t val)
+{
+    add_value(col, (uint64_t) val);
+}
+
+
+/***********************************************************************/
+// add_double: Add a floating-point value to a column buffer
+
+void add_double (column_buf_t *col, double val)
+{
+    uint64_t bits;
+
+
+    assert(sizeof(bits) == sizeof(val));
+    memcpy(&bits, &val, sizeof(bits));
+    add_value(col, bits);
+}
+
+
+/***********************************************************************/
+// encode_column: Encode the values of a column
+
+void encode_column (byte_buf_t *restrict buf, column_type_t type,
+		    const column_buf_t *restrict col)
+{
+    uint64_t prev = 0;
+
+
+    for (size_t i = 0; i < col->count; i++) {
+	uint64_t v = col->val[i];
+
+	if (type == CTYPE_INT) {
+	    uint64_t d = v - prev;
+
+	    // Zigzag encoding: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+	    put_varint(buf, (d << 1) ^ (0 - (d >> 63)));
+	} else {
+	    uint64_t x = v ^ prev;
+	    unsigned char tz = 0;
+
+	    if (x == 0) {
+		tz = DOUBLE_ZERO_XOR;
+		put_bytes(buf, &tz, 1);
+	    } else {
+		while ((x & 1) == 0) {
+		    x >>= 1;
+		    tz++;
+		}
+		put_bytes(buf, &tz, 1);
+		put_varint(buf, x);
+	    }
+	}
+
+	prev = v;
+    }
+}
+
+
+/***********************************************************************/
+// decode_column: Decode the values of a column
+
+bool decode_column (const column_dir_t *restrict dir, column_type_t type,
+		    column_buf_t *restrict col)
+{
+    const unsigned char *p, *end;
+    uint64_t prev = 0;
+
+
+    if (! dir->present) {
+	return true;
+    }
+
+    p = dir->data;
+    end = dir->data + dir->len;
+
+    for (uint64_t i = 0; i < dir->count; i++) {
+	uint64_t v;
+
+	if (type == CTYPE_INT) {
+	    uint64_t z;
+
+	    if (! get_varint(&p, end, &z)) {
+		return false;
+	    }
+	    v = prev + ((z >> 1) ^ (0 - (z & 1)));
+	} else {
+	    unsigned char tz;
+	    uint64_t x;
+
+	    if (p >= end) {
+		return false;
+	    }
+	    tz = *p++;
+
+	    if (tz == DOUBLE_ZERO_XOR) {
+		x = 0;
+	    } else if (tz < DOUBLE_ZERO_XOR && get_varint(&p, end, &x)) {
+		x <<= tz;
+	    } else {
+		return false;
+	    }
+	    v = prev ^ x;
+	}
+
+	add_value(col, v);
+	prev = v;
+    }
+
+    return p == end;
+}
+
+
+/***********************************************************************/
+// read_index: Read the index of a game archive
+
+block_info_t *read_index (FILE *restrict file, const char *restrict filename,
+			  uint64_t *restrict index_off,
+			  size_t *restrict nblocks)
+{
+    unsigned char header[ARCHIVE_MAGIC_LEN];
+    unsigned char trailer[ARCHIVE_TRAILER_LEN];
+    unsigned char *data;
+    const unsigned char *p, *end;
+    block_info_t *blocks;
+    uint64_t off, len, n, next;
+    off_t filesize;
+    int i;
+
+
+    if (fseeko(file, 0, SEEK_SET) != 0) {
+	errno_exit("%s", filename);
+    }
+    if (fread(header, 1, ARCHIVE_MAGIC_LEN, file) != ARCHIVE_MAGIC_LEN
+	|| memcmp(header, ARCHIVE_MAGIC, ARCHIVE_MAGIC_LEN) != 0) {
+	err_exit(_("%s: not a valid game archive"), filename);
+    }
+
+    if (fseeko(file, 0, SEEK_END) != 0 || (filesize = ftello(file)) < 0) {
+	errno_exit("%s", filename);
+    }
+    if (filesize < ARCHIVE_MAGIC_LEN + ARCHIVE_TRAILER_LEN
+	|| fseeko(file, filesize - ARCHIVE_TRAILER_LEN, SEEK_SET) != 0
+	|| fread(trailer, 1, ARCHIVE_TRAILER_LEN, file) != ARCHIVE_TRAILER_LEN
+	|| memcmp(trailer + 8, ARCHIVE_INDEX_MAGIC, ARCHIVE_MAGIC_LEN) != 0) {
+	err_exit(_("%s: game archive has no valid index"), filename);
+    }
+
+    for (off = 0, i = 7; i >= 0; i--) {
+	off = (off << 8) | trailer[i];
+    }
+
+    if (off < ARCHIVE_MAGIC_LEN
+	|| off > (uint64_t) filesize - ARCHIVE_TRAILER_LEN
+	|| (uint64_t) filesize - ARCHIVE_TRAILER_LEN - off > ARCHIVE_MAX_SIZE) {
+	err_exit(_("%s: game archive has no valid index"), filename);
+    }
+
+    // Read the index itself
+    len = filesize - ARCHIVE_TRAILER_LEN - off;
+    data = xmalloc(len + 1);
+    if (fseeko(file, off, SEEK_SET) != 0 || fread(data, 1, len, file) != len) {
+	err_exit(_("%s: game archive has no valid index"), filename);
+    }
+
+    p = data;
+    end = data + len;
+    if (! get_varint(&p, end, &n) || n > len) {
+	err_exit(_("%s: game archive has no valid index"), filename);
+    }
+
+    // Blocks must be in order and must not overlap, but may have gaps
+    blocks = xmalloc((n + 1) * sizeof(block_info_t));
+    next = ARCHIVE_MAGIC_LEN;
+    for (uint64_t b = 0; b < n; b++) {
+	if (! get_varint(&p, end, &blocks[b].offset)
+	    || ! get_varint(&p, end, &blocks[b].len)
+	    || ! get_varint(&p, end, &blocks[b].ngames)
+	    || blocks[b].offset < next
+	    || blocks[b].offset > off
+	    || blocks[b].len > off - blocks[b].offset
+	    || blocks[b].ngames > ARCHIVE_BLOCK_GAMES) {
+	    err_exit(_("%s: game archive has no valid index"), filename);
+	}
+	next = blocks[b].offset + blocks[b].len;
+    }
+    if (p != end) {
+	err_exit(_("%s: game archive has no valid index"), filename);
+    }
+
+    free(data);
+
+    *index_off = off;
+    *nblocks = n;
+    return blocks;
+}
+
+
+/***********************************************************************/
+// read_block: Read a block of a game archive
+
+unsigned char *read_block (FILE *restrict file, const char *restrict filename,
+			   const block_info_t *restrict info,
+			   column_dir_t dir[ARCHIVE_NUM_COLUMNS])
+{
+    unsigned char *data;
+    const unsigned char *p, *end, *payload;
+    uint64_t ngames, ncols, colnum, count, len;
+
+
+    if (info->len > ARCHIVE_MAX_SIZE) {
+	err_exit(_("%s: corrupt game archive"), filename);
+    }
+
+    data = xmalloc(info->len + 1);
+    if (fseeko(file, info->offset, SEEK_SET) != 0
+	|| fread(data, 1, info->len, file) != info->len) {
+	err_exit(_("%s: corrupt game archive"), filename);
+    }
+
+    for (int i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	dir[i].present = false;
+	dir[i].count   = 0;
+	dir[i].data    = NULL;
+	dir[i].len     = 0;
+    }
+
+    // Read the block directory
+    p = data;
+    end = data + info->len;
+    if (! get_varint(&p, end, &ngames) || ngames != info->ngames
+	|| ! get_varint(&p, end, &ncols) || ncols > info->len) {
+	err_exit(_("%s: corrupt game archive"), filename);
+    }
+
+    const unsigned char *dirstart = p;
+
+    // First pass: find the start of the column data
+    for (uint64_t c = 0; c < ncols; c++) {
+	if (! get_varint(&p, end, &colnum)
+	    || ! get_varint(&p, end, &count)
+	    || ! get_varint(&p, end, &len)) {
+	    err_exit(_("%s: corrupt game archive"), filename);
+	}
+    }
+    payload = p;
+
+    // Second pass: note where each column is; skip unknown columns
+    p = dirstart;
+    for (uint64_t c = 0; c < ncols; c++) {
+	get_varint(&p, end, &colnum);
+	get_varint(&p, end, &count);
+	get_varint(&p, end, &len);
+
+	if (len > (uint64_t) (end - payload)) {
+	    err_exit(_("%s: corrupt game archive"), filename);
+	}
+	if (colnum < ARCHIVE_NUM_COLUMNS) {
+	    dir[colnum].present = true;
+	    dir[colnum].count   = count;
+	    dir[colnum].data    = payload;
+	    dir[colnum].len     = len;
+	}
+	payload += len;
+    }
+
+    if (payload != end) {
+	err_exit(_("%s: corrupt game archive"), filename);
+    }
+
+    return data;
+}
+
+
+/***********************************************************************/
+// encode_block: Encode a block of a game archive
+
+void encode_block (byte_buf_t *restrict buf,
+		   const archive_block_t *restrict block)
+{
+    byte_buf_t colbuf[ARCHIVE_NUM_COLUMNS];
+    int i;
+
+
+    for (i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	memset(&colbuf[i], 0, sizeof(colbuf[i]));
+	encode_column(&colbuf[i], column_desc[i].type, &block->col[i]);
+    }
+
+    // Block directory, then each column
+    put_varint(buf, block->ngames);
+    put_varint(buf, ARCHIVE_NUM_COLUMNS);
+    for (i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	put_varint(buf, i);
+	put_varint(buf, block->col[i].count);
+	put_varint(buf, colbuf[i].len);
+    }
+
+    for (i = 0; i < ARCHIVE_NUM_COLUMNS; i++) {
+	put_bytes(buf, colbuf[i].data, colbuf[i].len);
+	free(colbuf[i].data);
+    }
+}
+
+
+/***********************************************************************/
+// encode_index: Encode the index and trailer of an archive
+
+void encode_index (byte_buf_t *restrict buf,
+		   const block_info_t *restrict blocks, size_t nblocks,
+		   uint64_t index_off)
+{
+    unsigned char trailer[ARCHIVE_TRAILER_LEN];
+
+
+    put_varint(buf, nblocks);
+    for (size_t n = 0; n < nblocks; n++) {
+	put_varint(buf, blocks[n].offset);
+	put_varint(buf, blocks[n].len);
+	put_varint(buf, blocks[n].ngames);
+    }
+
+    for (int i = 0; i < 8; i++) {
+	trailer[i] = (index_off >> (i * 8)) & 0xFF;
+    }
+    memcpy(trailer + 8, ARCHIVE_INDEX_MAGIC, ARCHIVE_MAGIC_LEN);
+    put_bytes(buf, trailer, ARCHIVE_TRAILER_LEN);
+}
+
+
+/***********************************************************************/
+// compact_archive: Remove unused space from a game archive
+
+void compact_archive (FILE *restrict file, const char *restrict filename,
+		      const block_info_t *restrict blocks, size_t nblocks)
+{
+    char *tmpname;
+    FILE *tmp;
+    block_info_t *newblocks;
+    byte_buf_t buf;
+    uint64_t off, copied;
+    size_t len;
+    bool ok;
+
+
+    tmpname = xmalloc(strlen(filename) + strlen(ARCHIVE_TMP_SUFFIX) + 1);
+    strcpy(tmpname, filename);
+    strcat(tmpname, ARCHIVE_TMP_SUFFIX);
+
+    tmp = fopen(tmpname, "wb");
+    if (tmp == NULL) {
+	free(tmpname);
+	return;
+    }
+
+    memset(&buf, 0, sizeof(buf));
+    newblocks = xmalloc((nblocks + 1) * sizeof(block_info_t));
+
+    ok = fwrite(ARCHIVE_MAGIC, 1, ARCHIVE_MAGIC_LEN, tmp)
+	== ARCHIVE_MAGIC_LEN;
+    off = ARCHIVE_MAGIC_LEN;
+
+    // Copy each block as it is: there is no need to decode it
+    for (size_t n = 0; ok && n < nblocks; n++) {
+	newblocks[n] = blocks[n];
+	newblocks[n].offset = off;
+
+	for (copied = 0; ok && copied < blocks[n].len; copied += len) {
+	    unsigned char data[BUFSIZE];
+
+	    len = MIN(sizeof(data), blocks[n].len - copied);
+	    ok = fseeko(file, blocks[n].offset + copied, SEEK_SET) == 0
+		&& fread(data, 1, len, file) == len
+		&& fwrite(data, 1, len, tmp) == len;
+	}
+
+	off += blocks[n].len;
+    }
+
+    if (ok) {
+	encode_index(&buf, newblocks, nblocks, off);
+	ok = fwrite(buf.data, 1, buf.len, tmp) == buf.len;
+    }
+
+    ok = (fclose(tmp) != EOF) && ok;
+
+    if (! ok || rename(tmpname, filename) != 0) {
+	unlink(tmpname);
+    }
+
+    free(buf.data);
+    free(newblocks);
+    free(tmpname);
+}
+
+
+/***********************************************************************/
+// add_current_game: Add the current game to a block
+
+void add_current_game (archive_block_t *block)
+{
+    column_buf_t *col = block->col;
+    int i, j;
+
+
+    add_int(&col[ACOL_TIME],          time(NULL));
+    add_int(&col[ACOL_SEED],          random_seed);
+    add_int(&col[ACOL_LOADED],        game_loaded);
+    add_int(&col[ACOL_MAX_TURN],      max_turn);
+    add_int(&col[ACOL_TURNS],         turn_number - 1);
+    add_int(&col[ACOL_PLAYERS],       number_players);
+    add_int(&col[ACOL_FIRST_PLAYER],  first_player);
+    add_double(&col[ACOL_INTEREST_RATE], interest_rate);
+
+    add_int(&col[ACOL_MOVE_COUNT],    num_recorded_moves);
+    for (size_t n = 0; n < num_recorded_moves; n++) {
+	add_int(&col[ACOL_MOVES], recorded_moves[n]);
+    }
+
+    for (i = 0; i < number_players; i++) {
+	add_double(&col[ACOL_CASH], player[i].cash);
+	add_double(&col[ACOL_DEBT], player[i].debt);
+	add_int(&col[ACOL_IN_GAME], player[i].in_game);
+	for (j = 0; j < MAX_COMPANIES; j++) {
+	    add_int(&col[ACOL_STOCK_OWNED], player[i].stock_owned[j]);
+	}
+    }
+
+    for (i = 0; i < MAX_COMPANIES; i++) {
+	add_double(&col[ACOL_SHARE_PRICE],  company[i].share_price);
+	add_double(&col[ACOL_SHARE_RETURN], company[i].share_return);
+	add_int(&col[ACOL_STOCK_ISSUED],    company[i].stock_issued);
+	add_int(&col[ACOL_MAX_STOCK],       company[i].max_stock);
+	add_int(&col[ACOL_ON_MAP],          company[i].on_map);
+    }
+
+    block->ngames++;
+}
+
+
+/***********************************************************************/
+// End of file
@@ -0,0 +1,121 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, archive.h, contains declarations for the game archive
+  functions used in Star Traders.  The game archive is an append-only
+  file that collects the final state of many finished games, stored by
+  column so that one value (such as every company's final share price)
+  can be read without decoding anything else.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_ARCHIVE_H
+#define included_ARCHIVE_H 1
+
+
+/************************************************************************
+*                   Game archive constants and types                    *
+************************************************************************/
+
+#define ARCHIVE_BLOCK_GAMES	1024	// Maximum games in one archive block
+
+// Columns in the game archive (never renumber: stored in the file!)
+typedef enum archive_column {
+    ACOL_TIME = 0,		// Time the game was archived
+    ACOL_SEED,			// Random number seed of the program
+    ACOL_LOADED,		// 1 if the game was loaded from disk
+    ACOL_MAX_TURN,		// Maximum number of turns
+    ACOL_TURNS,			// Number of turns actually played
+    ACOL_PLAYERS,		// Number of players
+    ACOL_FIRST_PLAYER,		// First player to have gone
+    ACOL_INTEREST_RATE,		// Final interest rate
+    ACOL_MOVE_COUNT,		// Number of moves recorded
+    ACOL_MOVES,			// Selection made for each move
+    ACOL_CASH,			// Each player's final cash
+    ACOL_DEBT,			// Each player's final debt
+    ACOL_IN_GAME,		// 1 if each player is still in the game
+    ACOL_STOCK_OWNED,		// Shares owned by each player in each company
+    ACOL_SHARE_PRICE,		// Final share price of each company
+    ACOL_SHARE_RETURN,		// Final return per share of each company
+    ACOL_STOCK_ISSUED,		// Final shares issued by each company
+    ACOL_MAX_STOCK,		// Final maximum shares of each company
+    ACOL_ON_MAP,		// 1 if each company is on the map
+
+    ARCHIVE_NUM_COLUMNS
+} archive_column_t;
+
+
+/************************************************************************
+*                   Game archive function prototypes                    *
+************************************************************************/
+
+/*
+  Function:   archive_record_move - Remember a move for the game archive
+  Parameters: selection           - Selection returned by get_move()
+  Returns:    (nothing)
+
+  This function records the selection made by the current player, to be
+  written to the game archive by archive_game().  It does nothing if
+  option_archive is NULL.
+*/
+extern void archive_record_move (selection_t selection);
+
+
+/*
+  Function:   archive_game - Append the current game to the game archive
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function appends the final state of the current game, together
+  with the moves recorded by archive_record_move(), to the game archive
+  named by option_archive.  The archive is created if it does not exist.
+  Nothing is done if option_archive is NULL or if the game was aborted.
+  It must be called after end_game(), so players are archived in order
+  of total value, winner first.
+
+  Only the last block of the archive is ever rewritten; complete blocks
+  are left untouched.  On any error, the program is terminated with an
+  appropriate message.
+*/
+extern void archive_game (void);
+
+
+/*
+  Function:   archive_print_column - Print one column of a game archive
+  Parameters: filename             - Name of the game archive
+              name                 - Name of the column to print
+  Returns:    (nothing)
+
+  This function prints the column name (such as "share_price") of every
+  game in the game archive filename to standard output, one line per
+  game.  Only that column (and, if needed, the one giving the number of
+  values per game) is decoded.  Numbers are always printed as in the
+  POSIX locale.  On any error, the program is terminated with an
+  appropriate message.
+*/
+extern void archive_print_column (const char *filename, const char *name);
+
+
+#endif /* included_ARCHIVE_H */
@@ -65,7 +65,7 @@ static void trade_shares (int num, bool *bid_used);
 *                  Stock Exchange function definitions                  *
 ************************************************************************/
 
-// This function is documented in the file "exch.h"
+// These functions are documented in the file "exch.h"
 
 
 /***********************************************************************/
@@ -73,6 +73,11 @@ static void trade_shares (int num, bool *bid_used);
 
 void exchange_stock (void)
 {
+    static chlabel_t label_title, label_no_companies;
+    static chlabel_t label_company, label_left, label_issued, label_return;
+    static chlabel_t label_price;
+    static chlabel_t label_menu[4], label_prompt;
+
     selection_t selection = SEL_NONE;
     bool bid_used = false;
     bool all_off_map;
@@ -94,10 +99,10 @@ void exchange_stock (void)
 	werase(curwin);
 	box(curwin, 0, 0);
 
-	center(curwin, 1, 0, attr_title, 0, 0, 1,
-	       _("  Interstellar Stock Exchange  "));
+	centerlabel(curwin, 1, 0, &label_title, attr_title, 0, 0, 1,
+		    _("  Interstellar Stock Exchange  "));
 	center(curwin, 2, 0, attr_normal, attr_highlight, 0, 1,
-	       _("Player: ^{%ls^}"), player[current_player].name);
+	       _("Player: ^{%ls^}"), name_wcs(player[current_player].name));
 
 	all_off_map = true;
 	for (i = 0; i < MAX_COMPANIES; i++) {
@@ -108,54 +113,58 @@ void exchange_stock (void)
 	}
 
 	if (all_off_map) {
-	    center(curwin, 8, 0, attr_normal, attr_highlight, 0, 1,
-		   _("No companies on the map"));
+	    centerlabel(curwin, 8, 0, &label_no_companies, attr_normal,
+			attr_highlight, 0, 1, _("No companies on the map"));
 	} else {
 	    mvwhline(curwin, 4, 2, ' ' | attr_subtitle, w - 4);
 	    mvwhline(curwin, 5, 2, ' ' | attr_subtitle, w - 4);
 
-	    left(curwin, 4, 4, attr_subtitle, 0, 0, 2,
-		 /* TRANSLATORS: "Company" is a two-line column label in
-		    a table containing a list of companies. */
-		 pgettext("subtitle", " \nCompany"));
-	    right(curwin, 4, w - 4, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Shares left" is a two-line column
-		     label in a table containing the number of shares
-		     left to be purchased in any given company.  The
-		     maximum column width is 10 characters (see
-		     STOCK_LEFT_COLS in src/intf.h). */
-		  pgettext("subtitle", "Shares\nleft"));
-	    right(curwin, 4, w - 6 - STOCK_LEFT_COLS, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Shares issued" is a two-line column
-		     label in a table containing the number of shares
-		     already sold (ie, bought by all players) in any
-		     given company.  The maximum column width is 10
-		     characters (see STOCK_ISSUED_COLS in src/intf.h). */
-		  pgettext("subtitle", "Shares\nissued"));
-	    right(curwin, 4, w - 8 - STOCK_LEFT_COLS - STOCK_ISSUED_COLS,
-		  attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Return" is a two-line column label in
-		     a table containing the share return as a percentage
-		     in any given company.  The maximum column width is
-		     10 characters (see SHARE_RETURN_COLS in src/intf.h). */
-		  pgettext("subtitle", "Return\n(%%)"));
-	    right(curwin, 4, w - 10 - STOCK_LEFT_COLS - STOCK_ISSUED_COLS
-		  - SHARE_RETURN_COLS, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Price per share" is a two-line column
-		     label in a table containing the price per share in
-		     any given company.  %ls is the currency symbol in
-		     the current locale.  The maximum column width is 12
-		     characters INCLUDING the currency symbol (see
-		     SHARE_PRICE_COLS in src/intf.h). */
-		  pgettext("subtitle", "Price per\nshare (%ls)"),
-		  currency_symbol);
+	    leftlabel(curwin, 4, 4, &label_company, attr_subtitle, 0, 0, 2,
+		      /* TRANSLATORS: "Company" is a two-line column label
+			 in a table containing a list of companies. */
+		      pgettext("subtitle", " \nCompany"));
+	    rightlabel(curwin, 4, w - 4, &label_left, attr_subtitle, 0, 0, 2,
+		       /* TRANSLATORS: "Shares left" is a two-line column
+			  label in a table containing the number of shares
+			  left to be purchased in any given company.  The
+			  maximum column width is 10 characters (see
+			  STOCK_LEFT_COLS in src/intf.h). */
+		       pgettext("subtitle", "Shares\nleft"));
+	    rightlabel(curwin, 4, w - 6 - STOCK_LEFT_COLS, &label_issued,
+		       attr_subtitle, 0, 0, 2,
+		       /* TRANSLATORS: "Shares issued" is a two-line column
+			  label in a table containing the number of shares
+			  already sold (ie, bought by all players) in any
+			  given company.  The maximum column width is 10
+			  characters (see STOCK_ISSUED_COLS in
+			  src/intf.h). */
+		       pgettext("subtitle", "Shares\nissued"));
+	    rightlabel(curwin, 4, w - 8 - STOCK_LEFT_COLS - STOCK_ISSUED_COLS,
+		       &label_return, attr_subtitle, 0, 0, 2,
+		       /* TRANSLATORS: "Return" is a two-line column label
+			  in a table containing the share return as a
+			  percentage in any given company.  The maximum
+			  column width is 10 characters (see
+			  SHARE_RETURN_COLS in src/intf.h). */
+		       pgettext("subtitle", "Return\n(%%)"));
+	    rightlabel(curwin, 4, w - 10 - STOCK_LEFT_COLS - STOCK_ISSUED_COLS
+		       - SHARE_RETURN_COLS, &label_price, attr_subtitle, 0, 0,
+		       2,
+		       /* TRANSLATORS: "Price per share" is a two-line
+			  column label in a table containing the price per
+			  share in any given company.  %ls is the currency
+			  symbol in the current locale.  The maximum column
+			  width is 12 characters INCLUDING the currency
+			  symbol (see SHARE_PRICE_COLS in src/intf.h). */
+		       pgettext("subtitle", "Price per\nshare (%ls)"),
+		       currency_symbol);
 
 	    for (line = 6, i = 0; i < MAX_COMPANIES; i++) {
 		if (company[i].on_map) {
 		    left(curwin, line, 2, attr_choice, 0, 0, 1, "%lc",
 			 (wint_t) PRINTABLE_MAP_VAL(COMPANY_TO_MAP(i)));
 		    left(curwin, line, 4, attr_normal, 0, 0, 1, "%ls",
-			 company[i].name);
+			 name_wcs(company[i].name));
 
 		    right(curwin, line, w - 2, attr_normal, 0, 0, 1, "%'ld  ",
 			  company[i].max_stock - company[i].stock_issued);
@@ -178,19 +187,22 @@ void exchange_stock (void)
 	// Show menu of choices for the player
 	newtxwin(7, WIN_COLS, 17, WCENTER, true, attr_normal_window);
 
-	left(curwin, 3, 2, attr_normal, attr_keycode, 0, 1,
-	     _("^{<1>^} Display stock portfolio"));
-	left(curwin, 4, 2, attr_normal, attr_keycode, 0, 1,
-	     /* TRANSLATORS: Each label may be up to 37 characters wide
-		(for <1> and <2>) or 38 characters wide (for <3> and <4>). */
-	     _("^{<2>^} Display galaxy map"));
-	left(curwin, 3, getmaxx(curwin) / 2, attr_normal, attr_keycode, 0, 1,
-	     _("^{<3>^} Visit the Trading Bank"));
-	left(curwin, 4, getmaxx(curwin) / 2, attr_normal, attr_keycode, 0, 1,
-	     _("^{<4>^} Exit the Stock Exchange"));
-
-	center(curwin, 1, -1, attr_normal, attr_keycode, attr_highlight, 1,
-	       _("Enter selection [^[Company letter^]/^{1^}-^{4^}]: "));
+	leftlabel(curwin, 3, 2, &label_menu[0], attr_normal, attr_keycode,
+		  0, 1, _("^{<1>^} Display stock portfolio"));
+	leftlabel(curwin, 4, 2, &label_menu[1], attr_normal, attr_keycode,
+		  0, 1,
+		  /* TRANSLATORS: Each label may be up to 37 characters wide
+		     (for <1> and <2>) or 38 characters wide (for <3> and
+		     <4>). */
+		  _("^{<2>^} Display galaxy map"));
+	leftlabel(curwin, 3, getmaxx(curwin) / 2, &label_menu[2], attr_normal,
+		  attr_keycode, 0, 1, _("^{<3>^} Visit the Trading Bank"));
+	leftlabel(curwin, 4, getmaxx(curwin) / 2, &label_menu[3], attr_normal,
+		  attr_keycode, 0, 1, _("^{<4>^} Exit the Stock Exchange"));
+
+	centerlabel(curwin, 1, -1, &label_prompt, attr_normal, attr_keycode,
+		    attr_highlight, 1,
+		    _("Enter selection [^[Company letter^]/^{1^}-^{4^}]: "));
 
 	curs_set(CURS_ON);
 	wrefresh(curwin);
@@ -299,12 +311,16 @@ void exchange_stock (void)
 
 void visit_bank (void)
 {
+    static chlabel_t label_title, label_debt, label_rate, label_limit;
+    static chlabel_t label_menu[3], label_prompt;
+
     double credit_limit;
     double val, max;
     wint_t key;
     bool done;
 
-    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    scratch_mark_t mark = scratch_mark();
+    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
     int x, width;
 
 
@@ -317,8 +333,8 @@ void visit_bank (void)
     // Show the informational part of the Bank
     newtxwin(10, WIN_COLS - 4, 5, WCENTER, true, attr_normal_window);
 
-    center(curwin, 1, 0, attr_title, 0, 0, 1,
-	   _("  Interstellar Trading Bank  "));
+    centerlabel(curwin, 1, 0, &label_title, attr_title, 0, 0, 1,
+		_("  Interstellar Trading Bank  "));
 
     mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, getmaxx(curwin) - 4, &width,
 	    1, pgettext("label", "Current cash:  "));
@@ -328,27 +344,27 @@ void visit_bank (void)
     right(curwin, 3, x + BANK_VALUE_COLS + 2, attr_normal, attr_highlight, 0,
 	  1, " ^{%N^} ", player[current_player].cash);
 
-    right(curwin, 4, x, attr_normal, 0, 0, 1,
-	  pgettext("label", "Current debt:  "));
+    rightlabel(curwin, 4, x, &label_debt, attr_normal, 0, 0, 1,
+	       pgettext("label", "Current debt:  "));
     right(curwin, 4, x + BANK_VALUE_COLS + 2, attr_normal, attr_highlight, 0,
 	  1, " ^{%N^} ", player[current_player].debt);
 
-    right(curwin, 5, x, attr_normal, 0, 0, 1,
-	  pgettext("label", "Interest rate: "));
+    rightlabel(curwin, 5, x, &label_rate, attr_normal, 0, 0, 1,
+	       pgettext("label", "Interest rate: "));
     right(curwin, 5, x + BANK_VALUE_COLS + 2, attr_normal, attr_highlight, 0,
 	  1, " ^{%.2f%%^} ", interest_rate * 100.0);
 
-    right(curwin, 7, x, attr_highlight, 0, 0, 1,
-	  /* TRANSLATORS: The "Total value", "Current cash", "Current
-	     debt", "Interest rate" and "Credit limit" labels MUST all be
-	     the same length (ie, right-padded with spaces as needed) and
-	     must have at least one trailing space so that the display
-	     routines work correctly.  The maximum length of each label
-	     is 36 characters.
-
-	     Note that some of these labels are used for both the Player
-	     Status window and the Trading Bank window. */
-	  pgettext("label", "Credit limit:  "));
+    rightlabel(curwin, 7, x, &label_limit, attr_highlight, 0, 0, 1,
+	       /* TRANSLATORS: The "Total value", "Current cash", "Current
+		  debt", "Interest rate" and "Credit limit" labels MUST all
+		  be the same length (ie, right-padded with spaces as
+		  needed) and must have at least one trailing space so
+		  that the display routines work correctly.  The maximum
+		  length of each label is 36 characters.
+
+		  Note that some of these labels are used for both the
+		  Player Status window and the Trading Bank window. */
+	       pgettext("label", "Credit limit:  "));
     whline(curwin, ' ' | attr_title, BANK_VALUE_COLS + 2);
     right(curwin, 7, x + BANK_VALUE_COLS + 2, attr_title, 0, 0, 1,
 	  " %N ", credit_limit);
@@ -358,19 +374,20 @@ void visit_bank (void)
     // Show menu of choices for the player
     newtxwin(7, WIN_COLS - 4, 15, WCENTER, true, attr_normal_window);
 
-    center(curwin, 3, 0, attr_normal, attr_keycode, 0, 1,
-	   /* TRANSLATORS: The "Borrow money", "Repay debt" and "Exit
-	      from the Bank" menu options must all be the same length
-	      (ie, padded with trailing spaces as required).  The maximum
-	      length is 72 characters. */
-	   _("^{<1>^} Borrow money      "));
-    center(curwin, 4, 0, attr_normal, attr_keycode, 0, 1,
-	   _("^{<2>^} Repay debt        "));
-    center(curwin, 5, 0, attr_normal, attr_keycode, 0, 1,
-	   _("^{<3>^} Exit from the Bank"));
-
-    center(curwin, 1, 0, attr_normal, attr_keycode, 0, 1,
-	   _("Enter selection [^{1^}-^{3^}]: "));
+    centerlabel(curwin, 3, 0, &label_menu[0], attr_normal, attr_keycode, 0,
+		1,
+		/* TRANSLATORS: The "Borrow money", "Repay debt" and "Exit
+		   from the Bank" menu options must all be the same length
+		   (ie, padded with trailing spaces as required).  The
+		   maximum length is 72 characters. */
+		_("^{<1>^} Borrow money      "));
+    centerlabel(curwin, 4, 0, &label_menu[1], attr_normal, attr_keycode, 0,
+		1, _("^{<2>^} Repay debt        "));
+    centerlabel(curwin, 5, 0, &label_menu[2], attr_normal, attr_keycode, 0,
+		1, _("^{<3>^} Exit from the Bank"));
+
+    centerlabel(curwin, 1, 0, &label_prompt, attr_normal, attr_keycode, 0,
+		1, _("Enter selection [^{1^}-^{3^}]: "));
 
     curs_set(CURS_ON);
     wrefresh(curwin);
@@ -440,7 +457,7 @@ void visit_bank (void)
 	    mkchstr(chbuf, BUFSIZE, attr_normal, attr_normal | A_BOLD, 0, 1,
 		    getmaxx(curwin) / 2, &width_cursym, 1, "^{%ls^}",
 		    currency_symbol);
-	    chbuf_cursym = xchstrdup(chbuf);
+	    chbuf_cursym = scratch_chstrdup(chbuf);
 
 	    mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, getmaxx(curwin)
 		    - BANK_INPUT_COLS - width_cursym - 6, &width, 1,
@@ -463,11 +480,8 @@ void visit_bank (void)
 			      attr_input_field);
 
 	    if (ret == OK && val > ROUNDING_AMOUNT) {
-		player[current_player].cash += val;
-		player[current_player].debt += val * (interest_rate + 1.0);
+		borrow_money(val);
 	    }
-
-	    free(chbuf_cursym);
 	}
 	break;
 
@@ -498,7 +512,7 @@ void visit_bank (void)
 	    mkchstr(chbuf, BUFSIZE, attr_normal, attr_normal | A_BOLD, 0, 1,
 		    getmaxx(curwin) / 2, &width_cursym, 1, "^{%ls^}",
 		    currency_symbol);
-	    chbuf_cursym = xchstrdup(chbuf);
+	    chbuf_cursym = scratch_chstrdup(chbuf);
 
 	    mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, getmaxx(curwin)
 		    - BANK_INPUT_COLS - width_cursym - 6, &width, 1,
@@ -522,18 +536,8 @@ void visit_bank (void)
 			      max, 3, x, BANK_INPUT_COLS, attr_input_field);
 
 	    if (ret == OK) {
-		player[current_player].cash -= val;
-		player[current_player].debt -= val;
-
-		if (player[current_player].cash < ROUNDING_AMOUNT) {
-		    player[current_player].cash = 0.0;
-		}
-		if (player[current_player].debt < ROUNDING_AMOUNT) {
-		    player[current_player].debt = 0.0;
-		}
+		repay_debt(val);
 	    }
-
-	    free(chbuf_cursym);
 	}
 	break;
 
@@ -545,7 +549,7 @@ void visit_bank (void)
     deltxwin();			// Trading Bank window
     txrefresh();
 
-    free(chbuf);
+    scratch_release(mark);
 }
 
 
@@ -558,6 +562,7 @@ void trade_shares (int num, bool *bid_used)
     int ret, w, x, mid;
     long int maxshares, val;
     double ownership;
+    scratch_mark_t mark;
     chtype *chbuf;
     int width;
     wint_t key;
@@ -566,7 +571,8 @@ void trade_shares (int num, bool *bid_used)
     assert(num >= 0 && num < MAX_COMPANIES);
     assert(company[num].on_map);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 
     ownership = (company[num].stock_issued == 0) ? 0.0 :
 	((double) player[current_player].stock_owned[num]
@@ -578,7 +584,7 @@ void trade_shares (int num, bool *bid_used)
 
     center(curwin, 1, 0, attr_title, 0, 0, 1,
 	   /* TRANSLATORS: %ls represents the company name. */
-	   _("  Stock Transaction in %ls  "), company[num].name);
+	   _("  Stock Transaction in %ls  "), name_wcs(company[num].name));
 
     mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, w / 2, &width, 1,
 	    /* TRANSLATORS: "Shares issued" represents the number of
@@ -746,10 +752,8 @@ void trade_shares (int num, bool *bid_used)
 	    ret = gettxlong(curwin, &val, 0, maxshares, 0, maxshares, 4, x,
 			    TRADE_INPUT_COLS, attr_input_field);
 
-	    if (ret == OK) {
-		player[current_player].cash -= val * company[num].share_price;
-		player[current_player].stock_owned[num] += val;
-		company[num].stock_issued += val;
+	    if (ret == OK && val > 0) {
+		trade_stock(num, val);
 	    }
 	}
 	break;
@@ -781,21 +785,15 @@ void trade_shares (int num, bool *bid_used)
 	    ret = gettxlong(curwin, &val, 0, maxshares, 0, maxshares, 4, x,
 			    TRADE_INPUT_COLS, attr_input_field);
 
-	    if (ret == OK) {
-		company[num].stock_issued -= val;
-		player[current_player].stock_owned[num] -= val;
-		player[current_player].cash += val * company[num].share_price;
+	    if (ret == OK && val > 0) {
+		trade_stock(num, -val);
 	    }
 	}
 	break;
 
     case L'3':
 	// Bid company to issue more shares
-	maxshares = 0;
-	if (! *bid_used && randf() < ownership && randf() < BID_CHANCE) {
-	    maxshares = randf() * ownership * MAX_SHARES_BIDDED;
-	    company[num].max_stock += maxshares;
-	}
+	maxshares = *bid_used ? 0 : bid_for_stock(num);
 
 	*bid_used = true;
 
@@ -805,7 +803,7 @@ void trade_shares (int num, bool *bid_used)
 		     attr_error_waitforkey, _("  No Shares Issued  "),
 		     /* TRANSLATORS: %ls represents the company name. */
 		     _("%ls has refused\nto issue more shares."),
-		     company[num].name);
+		     name_wcs(company[num].name));
 	} else {
 	    txdlgbox(MAX_DLG_LINES, 50, 8, WCENTER, attr_normal_window,
 		     attr_title, attr_normal, attr_highlight, 0,
@@ -813,7 +811,8 @@ void trade_shares (int num, bool *bid_used)
 		     /* TRANSLATORS: %ls represents the company name. */
 		     ngettext("%ls has issued\n^{one^} more share.",
 			      "%ls has issued\n^{%'ld^} more shares.",
-			      maxshares), company[num].name, maxshares);
+			      maxshares),
+		     name_wcs(company[num].name), maxshares);
 	}
 	break;
 
@@ -825,7 +824,85 @@ void trade_shares (int num, bool *bid_used)
     deltxwin();			// Stock Transaction window
     txrefresh();
 
-    free(chbuf);
+    scratch_release(mark);
+}
+
+
+/************************************************************************
+*            Stock Exchange transaction function definitions            *
+************************************************************************/
+
+// These functions are documented in the file "exch.h"
+
+
+/***********************************************************************/
+// trade_stock: Buy or sell shares in a company
+
+void trade_stock (int num, long int shares)
+{
+    assert(num >= 0 && num < MAX_COMPANIES);
+
+    player[current_player].cash -= shares * company[num].share_price;
+    player[current_player].stock_owned[num] += shares;
+    company[num].stock_issued += shares;
+
+    replay_record_trade(num, shares);
+}
+
+
+/***********************************************************************/
+// bid_for_stock: Bid for a company to issue more shares
+
+long int bid_for_stock (int num)
+{
+    double ownership;
+    long int maxshares = 0;
+
+
+    assert(num >= 0 && num < MAX_COMPANIES);
+
+    ownership = (company[num].stock_issued == 0) ? 0.0 :
+	((double) player[current_player].stock_owned[num]
+	 / company[num].stock_issued);
+
+    if (randf() < ownership && randf() < BID_CHANCE) {
+	maxshares = randf() * ownership * MAX_SHARES_BIDDED;
+	company[num].max_stock += maxshares;
+    }
+
+    replay_record_bid(num);
+    return maxshares;
+}
+
+
+/***********************************************************************/
+// borrow_money: Borrow money from the Bank
+
+void borrow_money (double amount)
+{
+    player[current_player].cash += amount;
+    player[current_player].debt += amount * (interest_rate + 1.0);
+
+    replay_record_borrow(amount);
+}
+
+
+/***********************************************************************/
+// repay_debt: Repay a debt to the Bank
+
+void repay_debt (double amount)
+{
+    player[current_player].cash -= amount;
+    player[current_player].debt -= amount;
+
+    if (player[current_player].cash < ROUNDING_AMOUNT) {
+	player[current_player].cash = 0.0;
+    }
+    if (player[current_player].debt < ROUNDING_AMOUNT) {
+	player[current_player].debt = 0.0;
+    }
+
+    replay_record_repay(amount);
 }
 
 
@@ -49,4 +49,49 @@
 extern void exchange_stock (void);
 
 
+/************************************************************************
+*            Stock Exchange transaction function prototypes             *
+************************************************************************/
+
+/*
+  Function:   trade_stock - Buy or sell shares in a company
+  Parameters: num         - Company to trade with
+              shares      - Shares to buy (if positive) or sell
+  Returns:    (nothing)
+
+  This function buys or sells shares in company num for the current
+  player at the current share price.  The caller must check that the
+  player can afford the shares, or has them to sell.
+*/
+extern void trade_stock (int num, long int shares);
+
+
+/*
+  Function:   bid_for_stock - Bid for a company to issue more shares
+  Parameters: num           - Company to bid for
+  Returns:    long int      - Number of shares issued (possibly 0)
+
+  This function asks company num to issue more shares to the current
+  player.  The company is more likely to agree, and to issue more
+  shares, the more of it the player already owns.  Only one bid may be
+  made per visit to the Stock Exchange.
+*/
+extern long int bid_for_stock (int num);
+
+
+/*
+  Function:   borrow_money - Borrow money from the Bank
+  Function:   repay_debt   - Repay a debt to the Bank
+  Parameters: amount       - Amount to borrow or repay
+  Returns:    (nothing)
+
+  These functions adjust the current player's cash and debt.  Money is
+  borrowed at the current interest rate; the caller must check that the
+  amount is within the player's credit limit, or no more than both their
+  cash and debt when repaying.
+*/
+extern void borrow_money (double amount);
+extern void repay_debt (double amount);
+
+
 #endif /* included_EXCH_H */
@@ -0,0 +1,350 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, export.c, contains the implementation of the game state
+  export functions used in Star Traders.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  The export file holds one line per move, each a JSON object such as
+  (broken over several lines here for clarity):
+
+    {"turn":3,"player":1,"move":"k","x":23,"y":1,
+     "events":[{"type":"merger","company":0,"into":2}],
+     "interest_rate":1.0e-01,
+     "companies":[{"on_map":true,"price":2.3e+02,"return":6.5e-02},...],
+     "players":[{"in_game":true,"value":6.1e+03},...]}
+
+  "move" is the untranslated letter of the move selected ("a" to "t"),
+  or one of "bankrupt", "save" or "quit"; "x" and "y" are only present
+  for moves on the galaxy map.  Each event is a "merger" (of company
+  into into), a "company_bankrupt" (with company) or a "player_bankrupt"
+  (with player).  Companies and players are numbered from zero, and the
+  arrays of companies and players always hold MAX_COMPANIES and
+  number_players entries.  The state given is that after the move, with
+  each player's value as returned by total_value().  Numbers are written
+  by xdtostr(), so do not depend on the locale.
+
+  Each line is written straight into the stdio buffer of the file, which
+  is only flushed every EXPORT_FLUSH_MOVES moves (and at the end of the
+  game), so exporting a game takes very little time.
+*/
+
+
+/************************************************************************
+*                        Module-specific macros                         *
+************************************************************************/
+
+// Most events a single move can cause: up to three mergers, bankruptcy
+// of any company and bankruptcy of the player
+#define MAX_EXPORT_EVENTS	(MAX_COMPANIES + 4)
+
+
+/************************************************************************
+*                   Module-specific type declarations                   *
+************************************************************************/
+
+// Events caused by a move
+typedef enum export_event_type {
+    EXPORT_MERGER,			// Company bb merged into company aa
+    EXPORT_COMPANY_BANKRUPT,		// Company num went bankrupt
+    EXPORT_PLAYER_BANKRUPT		// Player num went bankrupt
+} export_event_type_t;
+
+typedef struct export_event {
+    export_event_type_t	type;
+    int			num;		// Company or player (or aa)
+    int			bb;		// EXPORT_MERGER: company taken over
+} export_event_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static FILE *export_file = NULL;	// Export file, if open
+
+static int move_turn;			// Turn number of the move
+static int move_player;			// Player who made the move
+static selection_t move_selection;	// Selection made
+static export_event_t events[MAX_EXPORT_EVENTS];
+static int num_events;			// Events caused by the move
+static int moves_unflushed;		// Moves since last fflush()
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   record_event - Remember an event caused by the current move
+  Parameters: type         - Type of event
+              num          - Company or player
+              bb           - Company taken over, for EXPORT_MERGER
+  Returns:    (nothing)
+*/
+static void record_event (export_event_type_t type, int num, int bb);
+
+
+/*
+  Function:   put_double - Write a JSON number to the export file
+  Parameters: name       - Name of the member
+              val        - Value to write
+  Returns:    (nothing)
+
+  JSON has no way of writing infinities or NaNs: these are written as
+  null instead.
+*/
+static void put_double (const char *name, double val);
+
+
+/************************************************************************
+*                   Game export function definitions                    *
+************************************************************************/
+
+/* These functions are documented either in the file "export.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// export_start: Start exporting the game state
+
+void export_start (void)
+{
+    if (option_export == NULL || export_file != NULL) {
+	return;
+    }
+
+    export_file = fopen(option_export, "a");
+    if (export_file == NULL) {
+	errno_exit("%s", option_export);
+    }
+
+    // Buffer fully even for a terminal: export_move() does the flushing
+    setvbuf(export_file, NULL, _IOFBF, BUFSIZ);
+
+    num_events = 0;
+    moves_unflushed = 0;
+}
+
+
+/***********************************************************************/
+// export_record_move: Remember a selection for the export
+
+void export_record_move (selection_t selection)
+{
+    if (export_file == NULL) {
+	return;
+    }
+
+    move_turn = turn_number;
+    move_player = current_player;
+    move_selection = selection;
+    num_events = 0;
+}
+
+
+/***********************************************************************/
+// export_record_merger: Remember a merger
+
+void export_record_merger (int aa, int bb)
+{
+    record_event(EXPORT_MERGER, aa, bb);
+}
+
+
+/***********************************************************************/
+// export_record_company_bankrupt: Remember a company bankruptcy
+
+void export_record_company_bankrupt (int num)
+{
+    record_event(EXPORT_COMPANY_BANKRUPT, num, 0);
+}
+
+
+/***********************************************************************/
+// export_record_player_bankrupt: Remember a player bankruptcy
+
+void export_record_player_bankrupt (int num)
+{
+    record_event(EXPORT_PLAYER_BANKRUPT, num, 0);
+}
+
+
+/***********************************************************************/
+// export_move: Write out the move just made
+
+void export_move (void)
+{
+    int i;
+
+
+    if (export_file == NULL) {
+	return;
+    }
+
+    fprintf(export_file, "{\"turn\":%d,\"player\":%d,", move_turn,
+	    move_player);
+
+    switch (move_selection) {
+    case SEL_BANKRUPT:
+	fputs("\"move\":\"bankrupt\"", export_file);
+	break;
+
+    case SEL_SAVE:
+	fputs("\"move\":\"save\"", export_file);
+	break;
+
+    case SEL_QUIT:
+	fputs("\"move\":\"quit\"", export_file);
+	break;
+
+    default:
+	assert(move_selection >= SEL_MOVE_FIRST
+	       && move_selection <= SEL_MOVE_LAST);
+	fprintf(export_file, "\"move\":\"%c\",\"x\":%d,\"y\":%d",
+		'a' + move_selection, game_move[move_selection].x,
+		game_move[move_selection].y);
+    }
+
+    fputs(",\"events\":[", export_file);
+    for (i = 0; i < num_events; i++) {
+	if (i > 0) {
+	    putc(',', export_file);
+	}
+
+	switch (events[i].type) {
+	case EXPORT_MERGER:
+	    fprintf(export_file,
+		    "{\"type\":\"merger\",\"company\":%d,\"into\":%d}",
+		    events[i].bb, events[i].num);
+	    break;
+
+	case EXPORT_COMPANY_BANKRUPT:
+	    fprintf(export_file,
+		    "{\"type\":\"company_bankrupt\",\"company\":%d}",
+		    events[i].num);
+	    break;
+
+	case EXPORT_PLAYER_BANKRUPT:
+	    fprintf(export_file,
+		    "{\"type\":\"player_bankrupt\",\"player\":%d}",
+		    events[i].num);
+	    break;
+	}
+    }
+    putc(']', export_file);
+
+    put_double("interest_rate", interest_rate);
+
+    fputs(",\"companies\":[", export_file);
+    for (i = 0; i < MAX_COMPANIES; i++) {
+	fprintf(export_file, "%s{\"on_map\":%s", (i > 0) ? "," : "",
+		company[i].on_map ? "true" : "false");
+	put_double("price", company[i].share_price);
+	put_double("return", company[i].share_return);
+	putc('}', export_file);
+    }
+
+    fputs("],\"players\":[", export_file);
+    for (i = 0; i < number_players; i++) {
+	fprintf(export_file, "%s{\"in_game\":%s", (i > 0) ? "," : "",
+		player[i].in_game ? "true" : "false");
+	put_double("value", total_value(i));
+	putc('}', export_file);
+    }
+    fputs("]}\n", export_file);
+
+    num_events = 0;
+
+    if (++moves_unflushed >= EXPORT_FLUSH_MOVES) {
+	if (fflush(export_file) == EOF) {
+	    errno_exit("%s", option_export);
+	}
+	moves_unflushed = 0;
+    }
+}
+
+
+/***********************************************************************/
+// export_end: Finish exporting the game state
+
+void export_end (void)
+{
+    if (export_file == NULL) {
+	return;
+    }
+
+    if (fclose(export_file) == EOF) {
+	errno_exit("%s", option_export);
+    }
+    export_file = NULL;
+}
+
+
+/************************************************************************
+*                 Module-specific function definitions                  *
+************************************************************************/
+
+// These functions are documented at the start of this file
+
+
+/***********************************************************************/
+// record_event: Remember an event caused by the current move
+
+void record_event (export_event_type_t type, int num, int bb)
+{
+    if (export_file == NULL) {
+	return;
+    }
+
+    assert(num_events < MAX_EXPORT_EVENTS);
+
+    events[num_events].type = type;
+    events[num_events].num  = num;
+    events[num_events].bb   = bb;
+    num_events++;
+}
+
+
+/***********************************************************************/
+// put_double: Write a JSON number to the export file
+
+void put_double (const char *name, double val)
+{
+    char buf[DTOSTR_BUFSIZE];
+
+
+    fprintf(export_file, ",\"%s\":%s", name, isfinite(val) ?
+	    xdtostr(buf, sizeof(buf), val) : "null");
+}
+
+
+/***********************************************************************/
+// End of file
@@ -0,0 +1,119 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, export.h, contains declarations for the game state export
+  functions used in Star Traders.  While a game is being played, a line
+  describing each move and the state of the game after it is written to
+  the export file as a JSON object, for use by other programs.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_EXPORT_H
+#define included_EXPORT_H 1
+
+
+/************************************************************************
+*                  Game export constants and variables                  *
+************************************************************************/
+
+#define EXPORT_FLUSH_MOVES	20	// Moves between flushes of the export
+
+
+/************************************************************************
+*                    Game export function prototypes                    *
+************************************************************************/
+
+/*
+  Function:   export_start - Start exporting the game state
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function opens the file named by option_export for appending, if
+  that option is not NULL.  The file may also be a named pipe.  It must
+  be called after init_game().  On any error, the program is terminated
+  with an appropriate message.
+*/
+extern void export_start (void);
+
+
+/*
+  Function:   export_record_move - Remember a selection for the export
+  Parameters: selection          - Selection returned by get_move()
+  Returns:    (nothing)
+
+  This function remembers the selection made by the current player, as
+  well as the current player and turn number, to be written out by
+  export_move().  It does nothing if the game state is not being
+  exported.
+*/
+extern void export_record_move (selection_t selection);
+
+
+/*
+  Function:   export_record_merger           - Remember a merger
+  Function:   export_record_company_bankrupt - Remember a company bankruptcy
+  Function:   export_record_player_bankrupt  - Remember a player bankruptcy
+  Parameters: aa                             - Company taking over
+              bb                             - Company being taken over
+              num                            - Company or player
+  Returns:    (nothing)
+
+  These functions remember what happened as a result of the move made
+  since the last call to export_record_move(), to be written out by
+  export_move().  They do nothing if the game state is not being
+  exported.
+*/
+extern void export_record_merger (int aa, int bb);
+extern void export_record_company_bankrupt (int num);
+extern void export_record_player_bankrupt (int num);
+
+
+/*
+  Function:   export_move - Write out the move just made
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function writes one line to the export file: a JSON object with
+  the turn number, the player who moved, the selection and anything that
+  happened as a result, then each company's share price and return and
+  each player's total value.  It must be called after next_player().
+  The file is only flushed every EXPORT_FLUSH_MOVES moves, so that
+  writing it takes very little time.
+*/
+extern void export_move (void);
+
+
+/*
+  Function:   export_end - Finish exporting the game state
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function flushes and closes the export file.  On any error, the
+  program is terminated with an appropriate message.
+*/
+extern void export_end (void);
+
+
+#endif /* included_EXPORT_H */
@@ -35,6 +35,12 @@
 *                        Module-specific macros                         *
 ************************************************************************/
 
+#define GAME_INDEX_FILENAME	"index"		// Index of saved games
+#define GAME_INDEX_TMP_SUFFIX	".tmp"		// Used while rewriting index
+
+// Format of a game summary: see format_game_summary()
+#define GAME_SUMMARY_FMT	"%d %d %d %lld %.0f%s%s\n"
+
 // Macros used in load_game()
 
 #define load_game_scanf(_fmt, _var, _cond)				\
@@ -43,7 +49,8 @@
 	    err_exit(_("%s: missing field on line %d"),			\
 		     filename, lineno);					\
 	}								\
-	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p) == NULL) {	\
+	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p, crc_p)		\
+	    == NULL) {							\
 	    err_exit(_("%s: illegal field on line %d"),			\
 		     filename, lineno);					\
 	}								\
@@ -63,7 +70,29 @@
 #define load_game_read_long(_var, _cond)				\
     load_game_scanf("%ld", _var, _cond)
 #define load_game_read_double(_var, _cond)				\
-    load_game_scanf("%lf", _var, _cond)
+    do {								\
+	char *p;							\
+									\
+	if (fgets(inbuf, BIGBUFSIZE, file) == NULL) {			\
+	    err_exit(_("%s: missing field on line %d"),			\
+		     filename, lineno);					\
+	}								\
+	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p, crc_p)		\
+	    == NULL) {							\
+	    err_exit(_("%s: illegal field on line %d"),			\
+		     filename, lineno);					\
+	}								\
+	(_var) = xstrtod(buf, &p);					\
+	if (p == buf) {							\
+	    err_exit(_("%s: illegal field on line %d: '%s'"),		\
+		     filename, lineno, buf);				\
+	}								\
+	if (! (_cond)) {						\
+	    err_exit(_("%s: illegal value on line %d: '%s'"),		\
+		     filename, lineno, buf);				\
+	}								\
+	lineno++;							\
+    } while (0)
 
 #define load_game_read_bool(_var)					\
     do {								\
@@ -74,7 +103,7 @@
     } while (0)
 
 #ifdef USE_UTF8_GAME_FILE
-#  define load_game_read_string(_var, _var_utf8)			\
+#  define load_game_read_string(_var)					\
     do {								\
 	char *s;							\
 	int len;							\
@@ -83,7 +112,8 @@
 	    err_exit(_("%s: missing field on line %d"),			\
 		     filename, lineno);					\
 	}								\
-	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p) == NULL) {	\
+	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p, crc_p)		\
+	    == NULL) {							\
 	    err_exit(_("%s: illegal field on line %d"),			\
 		     filename, lineno);					\
 	}								\
@@ -91,8 +121,14 @@
 	    err_exit(_("%s: illegal value on line %d"),			\
 		     filename, lineno);					\
 	}								\
+									\
+	len = strlen(buf);						\
+	if (len > 0 && buf[len - 1] == '\n') {				\
+	    buf[len - 1] = '\0';					\
+	}								\
+									\
 	if (need_icd) {							\
-	    s = str_cd_iconv(buf, icd);					\
+	    s = str_cd_iconv(buf, load_icd);				\
 	    if (s == NULL) {						\
 		if (errno == EILSEQ) {					\
 		    err_exit(_("%s: illegal characters on line %d"),	\
@@ -101,23 +137,18 @@
 		    errno_exit("str_cd_iconv");				\
 		}							\
 	    }								\
+	    xmbstowcs(wcbuf, s, BUFSIZE);				\
+	    free(s);							\
 	} else {							\
-	    s = xstrdup(buf);						\
+	    xmbstowcs(wcbuf, buf, BUFSIZE);				\
 	}								\
 									\
-	len = strlen(s);						\
-	if (len > 0 && s[len - 1] == '\n') {				\
-	    s[len - 1] = '\0';						\
-	}								\
-									\
-	xmbstowcs(wcbuf, s, BUFSIZE);					\
-	(_var) = xwcsdup(wcbuf);					\
-	(_var_utf8) = s;						\
+	(_var) = intern_name(wcbuf, buf);				\
 									\
 	lineno++;							\
     } while (0)
 #else // ! USE_UTF8_GAME_FILE
-#  define load_game_read_string(_var, _var_utf8)			\
+#  define load_game_read_string(_var)					\
     do {								\
 	char *s;							\
 	int len;							\
@@ -126,7 +157,8 @@
 	    err_exit(_("%s: missing field on line %d"),			\
 		     filename, lineno);					\
 	}								\
-	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p) == NULL) {	\
+	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p, crc_p)		\
+	    == NULL) {							\
 	    err_exit(_("%s: illegal field on line %d"),			\
 		     filename, lineno);					\
 	}								\
@@ -143,8 +175,8 @@
 	}								\
 									\
 	xmbstowcs(wcbuf, s, BUFSIZE);					\
-	(_var) = xwcsdup(wcbuf);					\
-	(_var_utf8) = s;						\
+	(_var) = intern_name(wcbuf, s);					\
+	free(s);							\
 									\
 	lineno++;							\
     } while (0)
@@ -156,7 +188,7 @@
 #define save_game_printf(_fmt, _var)					\
     do {								\
 	snprintf(buf, BUFSIZE, _fmt "\n", _var);			\
-	scramble(encbuf, buf, BIGBUFSIZE, crypt_key_p);			\
+	scramble(encbuf, buf, BIGBUFSIZE, crypt_key_p, crc_p);		\
 	fprintf(file, "%s", encbuf);					\
     } while (0)
 
@@ -165,19 +197,22 @@
 #define save_game_write_long(_var)					\
     save_game_printf("%ld", _var)
 #define save_game_write_double(_var)					\
-    save_game_printf("%2.20e", _var)
+    do {								\
+	char dbuf[DTOSTR_BUFSIZE];					\
+									\
+	save_game_printf("%s", xdtostr(dbuf, sizeof(dbuf), _var));	\
+    } while (0)
 #define save_game_write_bool(_var)					\
     save_game_printf("%d", (int) _var)
 
 #ifdef USE_UTF8_GAME_FILE
-#  define save_game_write_string(_var, _var_utf8)			\
+#  define save_game_write_string(_var)					\
     do {								\
-	if ((_var_utf8) != NULL) {					\
-	    save_game_printf("%s", _var_utf8);				\
-	} else {							\
+	if (name_mbs(_var) == NULL) {					\
+	    /* Convert once; the UTF-8 copy is reused by later saves */	\
+	    snprintf(buf, BUFSIZE, "%ls", name_wcs(_var));		\
 	    if (need_icd) {						\
-		snprintf(buf, BUFSIZE, "%ls", _var);			\
-		char *s = str_cd_iconv(buf, icd);			\
+		char *s = str_cd_iconv(buf, save_icd);			\
 		if (s == NULL) {					\
 		    if (errno == EILSEQ) {				\
 			err_exit(_("%s: could not convert string"),	\
@@ -186,25 +221,166 @@
 			errno_exit("str_cd_iconv");			\
 		    }							\
 		}							\
-		save_game_printf("%s", s);				\
+		set_name_mbs(_var, s);					\
 		free(s);						\
 	    } else {							\
-		save_game_printf("%ls", _var);				\
+		set_name_mbs(_var, buf);				\
 	    }								\
 	}								\
+	save_game_printf("%s", name_mbs(_var));				\
     } while (0)
 #else // ! USE_UTF8_GAME_FILE
-#  define save_game_write_string(_var, _var_utf8)			\
+#  define save_game_write_string(_var)					\
     do {								\
-	if ((_var_utf8) != NULL) {					\
-	    save_game_printf("%s", _var_utf8);				\
+	if (name_mbs(_var) != NULL) {					\
+	    save_game_printf("%s", name_mbs(_var));			\
 	} else {							\
-	    save_game_printf("%ls", _var);				\
+	    save_game_printf("%ls", name_wcs(_var));			\
 	}								\
     } while (0)
 #endif // ! USE_UTF8_GAME_FILE
 
 
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+/* The locale's codeset does not change once the program is running, so
+   the codeset line written to game files and (if needed) the character
+   set conversion descriptors are set up once by init_game_file_codeset()
+   and then kept for the life of the program. */
+
+static char *game_file_codeset_nl = NULL;	// Codeset line in game files
+
+#ifdef USE_UTF8_GAME_FILE
+static bool need_icd = false;			// Locale codeset not UTF-8?
+static iconv_t load_icd = (iconv_t) -1;		// Game file to locale codeset
+static iconv_t save_icd = (iconv_t) -1;		// Locale codeset to game file
+#endif
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   init_game_file_codeset - Set up character set conversion
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function determines the codeset line to be used in game files
+  and, if USE_UTF8_GAME_FILE is defined and the locale does not use
+  UTF-8, opens the iconv() descriptors used to convert strings to and
+  from the game file.  It does nothing if called a second time.
+*/
+static void init_game_file_codeset (void);
+
+
+/*
+  Function:   format_game_summary - Describe the current game in one line
+  Parameters: buf                 - Buffer for the summary line
+              bufsize             - Size of buf
+              summary             - Summary of the current game (output)
+  Returns:    (nothing)
+
+  This function fills in *summary from the current game's global
+  variables (apart from summary->num) and formats it as a single line,
+  terminated by '\n', into buf.  The line contains only ASCII digits and
+  spaces, followed by the game name (if any), so is independent of the
+  locale and character set.
+*/
+static void format_game_summary (char *restrict buf, size_t bufsize,
+				 game_summary_t *restrict summary);
+
+
+/*
+  Function:   parse_game_summary - Parse a summary line
+  Parameters: str                - Summary line, as per format_game_summary()
+              summary            - Resulting summary (output)
+  Returns:    bool               - True if str is a valid summary line
+
+  This function does the reverse of format_game_summary().  The
+  summary->num field is not changed.  Summaries written before games
+  could be named have no name: summary->name is set to "" for these.
+*/
+static bool parse_game_summary (const char *restrict str,
+				game_summary_t *restrict summary);
+
+
+/*
+  Function:   read_game_summary - Read the summary line of a game file
+  Parameters: num               - Game number to read
+              summary           - Resulting summary (output)
+  Returns:    bool              - True if a summary could be read
+
+  This function opens the game file for game num and reads only as far
+  as its summary line.  False is returned if the file does not exist, is
+  not a game file or was saved by a version of Star Traders that did not
+  write a summary.
+*/
+static bool read_game_summary (int num, game_summary_t *summary);
+
+
+/*
+  Function:   read_game_index - Read the index of saved games
+  Parameters: summaries       - Pointer to array of summaries (output)
+  Returns:    int             - Number of summaries, or -1 on error
+
+  This function reads the index file in the data directory into a newly
+  allocated array placed in *summaries.  If the index does not exist or is
+  not valid, -1 is returned and *summaries is not changed.
+*/
+static int read_game_index (game_summary_t **summaries);
+
+
+/*
+  Function:   scan_game_files - Rebuild the index from the game files
+  Parameters: summaries       - Pointer to array of summaries (output)
+  Returns:    int             - Number of summaries
+
+  This function lists the data directory, reading the summary line of
+  every game file found there, and places the results in a newly
+  allocated array in *summaries.
+*/
+static int scan_game_files (game_summary_t **summaries);
+
+
+/*
+  Function:   write_game_index - Write the index of saved games
+  Parameters: summaries        - Array of summaries to write
+              count            - Number of elements in summaries
+  Returns:    (nothing)
+
+  This function replaces the index file in the data directory.  The new
+  index is written to a temporary file that is then renamed, so that an
+  interrupted write never leaves a partial index behind.  Errors are
+  ignored: the index can always be rebuilt by scan_game_files().
+*/
+static void write_game_index (const game_summary_t *summaries, int count);
+
+
+/*
+  Function:   update_game_index - Add or replace one game in the index
+  Parameters: summary           - Summary of the game just saved
+  Returns:    (nothing)
+
+  This function updates the index file after a game has been saved.
+*/
+static void update_game_index (const game_summary_t *summary);
+
+
+/*
+  Function:   cmp_game_summary - Compare two summaries for sorting
+  Parameters: a, b             - Pointers to elements to compare
+  Returns:    int              - Comparison of a and b
+
+  This function compares two game_summary_t elements, placing the most
+  recently saved game first (then by game number).  It is used by
+  list_saved_games() to sort the index.
+*/
+static int cmp_game_summary (const void *a, const void *b);
+
+
 /************************************************************************
 *                Game load and save function definitions                *
 ************************************************************************/
@@ -219,25 +395,23 @@ bool load_game (int num)
 {
     char *filename;
     FILE *file;
-    char *codeset, *codeset_nl;
     int saved_errno, lineno;
-    char *prev_locale;
 
     char *buf, *inbuf;
     wchar_t *wcbuf;
 
     unsigned int crypt_key;
     unsigned int *crypt_key_p;
+    unsigned long int crc, crc_input;
+    unsigned long int *crc_p;
     int is_encrypted_input;
+    bool has_summary;
+    int max_encryption;
     int n, i, j;
 
-#ifdef USE_UTF8_GAME_FILE
-    iconv_t icd;
-    bool need_icd;
-#endif
 
 
-    assert(num >= 1 && num <= 9);
+    assert(num >= 1 && num <= MAX_GAME_NUM);
 
     buf = xmalloc(BUFSIZE);
     inbuf = xmalloc(BIGBUFSIZE);
@@ -275,44 +449,8 @@ bool load_game (int num)
 	return false;
     }
 
-#ifdef USE_UTF8_GAME_FILE
-    // Make sure all strings are read in UTF-8 format for consistency
-    codeset = nl_langinfo(CODESET);
-    if (codeset == NULL) {
-	errno_exit("nl_langinfo(CODESET)");
-    }
-    need_icd = (strcmp(codeset, GAME_FILE_CHARSET) != 0);
-    if (need_icd) {
-	// Try using the GNU libiconv "//TRANSLIT" option
-	strcpy(buf, codeset);
-	strcat(buf, GAME_FILE_TRANSLIT);
-
-	icd = iconv_open(buf, GAME_FILE_CHARSET);
-	if (icd == (iconv_t) -1) {
-	    // Try iconv_open() without "//TRANSLIT"
-	    icd = iconv_open(codeset, GAME_FILE_CHARSET);
-	    if (icd == (iconv_t) -1) {
-		errno_exit("iconv_open");
-	    }
-	}
-    } else {
-	icd = (iconv_t) -1;
-    }
-    codeset_nl = xstrdup(GAME_FILE_CHARSET "\n");
-#else // ! USE_UTF8_GAME_FILE
     // Make sure all strings are read in the correct codeset
-    codeset = nl_langinfo(CODESET);
-    if (codeset == NULL) {
-	errno_exit("nl_langinfo(CODESET)");
-    }
-    codeset_nl = xmalloc(strlen(codeset) + 2);
-    strcpy(codeset_nl, codeset);
-    strcat(codeset_nl, "\n");
-#endif // ! USE_UTF8_GAME_FILE
-
-    // Change the formatting of numbers to the POSIX locale for consistency
-    prev_locale = xstrdup(setlocale(LC_NUMERIC, NULL));
-    setlocale(LC_NUMERIC, "C");
+    init_game_file_codeset();
 
     // Read the game file header
     if (fgets(buf, BUFSIZE, file) == NULL) {
@@ -324,28 +462,57 @@ bool load_game (int num)
     if (fgets(buf, BUFSIZE, file) == NULL) {
 	err_exit(_("%s: missing subheader in game file"), filename);
     }
-    if (strcmp(buf, GAME_FILE_API_VERSION "\n") != 0) {
+    if (strcmp(buf, GAME_FILE_API_VERSION "\n") == 0) {
+	has_summary = true;
+	max_encryption = GAME_FILE_WHOLE_CRC;
+    } else if (strcmp(buf, GAME_FILE_API_OLD_VERSION "\n") == 0) {
+	// Older files have no summary and no whole-file checksum
+	has_summary = false;
+	max_encryption = GAME_FILE_ENCRYPTED;
+    } else {
 	err_exit(_("%s: saved under a different version of Star Traders"),
 		 filename);
     }
     if (fgets(buf, BUFSIZE, file) == NULL) {
 	err_exit(_("%s: missing subheader in game file"), filename);
     }
-    if (strcmp(buf, codeset_nl) != 0) {
+    if (strcmp(buf, game_file_codeset_nl) != 0) {
 	err_exit(_("%s: saved under an incompatible character encoding"),
 		 filename);
     }
 
     lineno = 4;
 
+    // Only the game name is used from the summary: the rest of the same
+    // information is read in below
+    free(game_name);
+    game_name = NULL;
+
+    if (has_summary) {
+	game_summary_t summary;
+
+	if (fgets(buf, BUFSIZE, file) == NULL) {
+	    err_exit(_("%s: missing subheader in game file"), filename);
+	}
+	if (parse_game_summary(buf, &summary) && *summary.name != '\0') {
+	    game_name = xstrdup(summary.name);
+	}
+	lineno++;
+    }
+
     // Read in the game file encryption status
-    if (fscanf(file, "%i\n", &is_encrypted_input) != 1) {
+    if (fscanf(file, "%i\n", &is_encrypted_input) != 1
+	|| is_encrypted_input < GAME_FILE_PLAIN
+	|| is_encrypted_input > max_encryption) {
 	err_exit(_("%s: illegal or missing field on line %d"), filename, lineno);
     }
     lineno++;
 
     crypt_key = 0;
-    crypt_key_p = is_encrypted_input ? &crypt_key : NULL;
+    crypt_key_p = (is_encrypted_input != GAME_FILE_PLAIN) ? &crypt_key : NULL;
+
+    crc = 0;
+    crc_p = (is_encrypted_input == GAME_FILE_WHOLE_CRC) ? &crc : NULL;
 
     // Read in various game variables
     load_game_read_int(n,                n == MAX_X);
@@ -358,9 +525,10 @@ bool load_game (int num)
     load_game_read_int(n,                n == MAX_COMPANIES);
     load_game_read_double(interest_rate, interest_rate > 0.0);
 
-    // Read in player data
+    // Read in player data, replacing all names from any earlier game
+    clear_names();
     for (i = 0; i < number_players; i++) {
-	load_game_read_string(player[i].name, player[i].name_utf8);
+	load_game_read_string(player[i].name);
 	load_game_read_double(player[i].cash, player[i].cash >= 0.0);
 	load_game_read_double(player[i].debt, player[i].debt >= 0.0);
 	load_game_read_bool(player[i].in_game);
@@ -372,8 +540,7 @@ bool load_game (int num)
 
     // Read in company data
     for (i = 0; i < MAX_COMPANIES; i++) {
-	xmbstowcs(wcbuf, gettext(company_name[i]), BUFSIZE);
-	company[i].name = xwcsdup(wcbuf);
+	company[i].name = intern_name(company_wname(i), NULL);
 	load_game_read_double(company[i].share_price,  company[i].share_price >= 0.0);
 	load_game_read_double(company[i].share_return, true);
 	load_game_read_long(company[i].stock_issued,   company[i].stock_issued >= 0);
@@ -386,7 +553,7 @@ bool load_game (int num)
 	if (fgets(inbuf, BIGBUFSIZE, file) == NULL) {
 	    err_exit(_("%s: missing field on line %d"), filename, lineno);
 	}
-	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p) == NULL) {
+	if (unscramble(buf, inbuf, BUFSIZE, crypt_key_p, crc_p) == NULL) {
 	    err_exit(_("%s: illegal field on line %d"), filename, lineno);
 	}
 	if (strlen(buf) != MAX_Y + 1) {
@@ -409,25 +576,25 @@ bool load_game (int num)
     // Read in a dummy sentinel value
     load_game_read_int(n, n == GAME_FILE_SENTINEL);
 
-    if (fclose(file) == EOF) {
-	errno_exit("%s", filename);
+    // Read in and check the whole-file checksum, if present
+    if (crc_p != NULL) {
+	if (fscanf(file, "%lx\n", &crc_input) != 1) {
+	    err_exit(_("%s: illegal or missing field on line %d"),
+		     filename, lineno);
+	}
+	if (crc_input != crc) {
+	    err_exit(_("%s: checksum mismatch in game file"), filename);
+	}
     }
 
-    // Change the formatting of numbers back to the user-supplied locale
-    setlocale(LC_NUMERIC, prev_locale);
-
-#ifdef USE_UTF8_GAME_FILE
-    if (need_icd) {
-	iconv_close(icd);
+    if (fclose(file) == EOF) {
+	errno_exit("%s", filename);
     }
-#endif
 
     free(buf);
     free(inbuf);
     free(wcbuf);
     free(filename);
-    free(prev_locale);
-    free(codeset_nl);
     return true;
 }
 
@@ -441,26 +608,35 @@ bool save_game (int num)
     char *buf, *encbuf;
     char *filename;
     FILE *file;
-    char *codeset;
     int saved_errno;
-    char *prev_locale;
     int i, j, x, y;
     unsigned int crypt_key;
     unsigned int *crypt_key_p;
+    unsigned long int crc;
+    unsigned long int *crc_p;
+    int encryption;
+    game_summary_t summary;
 
-#ifdef USE_UTF8_GAME_FILE
-    iconv_t icd;
-    bool need_icd;
-#endif
 
 
-    assert(num >= 1 && num <= 9);
+    assert(num >= 1 && num <= MAX_GAME_NUM);
 
     buf = xmalloc(BUFSIZE);
     encbuf = xmalloc(BIGBUFSIZE);
 
+    if (option_dont_encrypt) {
+	encryption = GAME_FILE_PLAIN;
+    } else if (option_file_checksum) {
+	encryption = GAME_FILE_WHOLE_CRC;
+    } else {
+	encryption = GAME_FILE_ENCRYPTED;
+    }
+
     crypt_key = 0;
-    crypt_key_p = option_dont_encrypt ? NULL : &crypt_key;
+    crypt_key_p = (encryption != GAME_FILE_PLAIN) ? &crypt_key : NULL;
+
+    crc = 0;
+    crc_p = (encryption == GAME_FILE_WHOLE_CRC) ? &crc : NULL;
 
     // Create the data directory, if needed
     data_dir = data_directory();
@@ -501,37 +677,14 @@ bool save_game (int num)
 	return false;
     }
 
-#ifdef USE_UTF8_GAME_FILE
-    // Make sure all strings are output in UTF-8 format for consistency
-    codeset = nl_langinfo(CODESET);
-    if (codeset == NULL) {
-	errno_exit("nl_langinfo(CODESET)");
-    }
-    need_icd = (strcmp(codeset, GAME_FILE_CHARSET) != 0);
-    if (need_icd) {
-	icd = iconv_open(GAME_FILE_CHARSET, codeset);
-	if (icd == (iconv_t) -1) {
-	    errno_exit("iconv_open");
-	}
-    } else {
-	icd = (iconv_t) -1;
-    }
-    codeset = GAME_FILE_CHARSET;	// Now contains output codeset
-#else // ! USE_UTF8_GAME_FILE
     // Make sure all strings are output in the correct codeset
-    codeset = nl_langinfo(CODESET);
-    if (codeset == NULL) {
-	errno_exit("nl_langinfo(CODESET)");
-    }
-#endif // ! USE_UTF8_GAME_FILE
-
-    // Change the formatting of numbers to the POSIX locale for consistency
-    prev_locale = xstrdup(setlocale(LC_NUMERIC, NULL));
-    setlocale(LC_NUMERIC, "C");
+    init_game_file_codeset();
 
-    // Write out the game file header and encryption status
+    // Write out the game file header, summary and encryption status
     fprintf(file, "%s\n" "%s\n", GAME_FILE_HEADER, GAME_FILE_API_VERSION);
-    fprintf(file, "%s\n" "%d\n", codeset, ! option_dont_encrypt);
+    format_game_summary(buf, BUFSIZE, &summary);
+    summary.num = num;
+    fprintf(file, "%s" "%s" "%d\n", game_file_codeset_nl, buf, encryption);
 
     // Write out various game variables
     save_game_write_int(MAX_X);
@@ -546,7 +699,7 @@ bool save_game (int num)
 
     // Write out player data
     for (i = 0; i < number_players; i++) {
-	save_game_write_string(player[i].name, player[i].name_utf8);
+	save_game_write_string(player[i].name);
 	save_game_write_double(player[i].cash);
 	save_game_write_double(player[i].debt);
 	save_game_write_bool(player[i].in_game);
@@ -576,31 +729,506 @@ bool save_game (int num)
 	*p++ = '\n';
 	*p = '\0';
 
-	scramble(encbuf, buf, BIGBUFSIZE, crypt_key_p);
+	scramble(encbuf, buf, BIGBUFSIZE, crypt_key_p, crc_p);
 	fprintf(file, "%s", encbuf);
     }
 
     // Write out a dummy sentinel value
     save_game_write_int(GAME_FILE_SENTINEL);
 
+    // Write out the whole-file checksum, if needed
+    if (crc_p != NULL) {
+	fprintf(file, "%08lx\n", crc);
+    }
+
     if (fclose(file) == EOF) {
 	errno_exit("%s", filename);
     }
 
-    // Change the formatting of numbers back to the user-supplied locale
-    setlocale(LC_NUMERIC, prev_locale);
+    update_game_index(&summary);
+
+    free(buf);
+    free(encbuf);
+    free(filename);
+    return true;
+}
+
+
+/***********************************************************************/
+// list_saved_games: List all saved games using the index
+
+int list_saved_games (game_summary_t **summaries)
+{
+    int count;
+
+
+    assert(summaries != NULL);
+
+    count = read_game_index(summaries);
+    if (count < 0) {
+	count = scan_game_files(summaries);
+	write_game_index(*summaries, count);
+    }
+
+    if (count > 0) {
+	qsort(*summaries, count, sizeof(game_summary_t), cmp_game_summary);
+    }
+
+    return count;
+}
+
+
+/***********************************************************************/
+// find_saved_game: Find the number of a named saved game
+
+int find_saved_game (const char *name)
+{
+    game_summary_t *summaries;
+    int count, num;
+
+
+    assert(name != NULL);
+
+    // Summaries are sorted with the most recently saved game first
+    count = list_saved_games(&summaries);
+    num = 0;
+
+    for (int i = 0; i < count; i++) {
+	if (strcmp(summaries[i].name, name) == 0) {
+	    num = summaries[i].num;
+	    break;
+	}
+    }
+
+    free(summaries);
+    return num;
+}
+
+
+/***********************************************************************/
+// unused_game_number: Suggest a number for a new saved game
+
+int unused_game_number (void)
+{
+    game_summary_t *summaries;
+    int count, num;
+
+
+    count = list_saved_games(&summaries);
+    num = 0;
+
+    for (int i = 0; i < count; i++) {
+	num = MAX(num, summaries[i].num);
+    }
+
+    free(summaries);
+    return MIN(num + 1, MAX_GAME_NUM);
+}
+
+
+/***********************************************************************/
+// valid_game_name: Check the name of a saved game
+
+bool valid_game_name (const char *name)
+{
+    size_t len;
+
+
+    assert(name != NULL);
+
+    len = strspn(name, "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		 "abcdefghijklmnopqrstuvwxyz0123456789._-");
+
+    return len > 0 && len <= GAME_NAME_LEN && name[len] == '\0'
+	&& name[strspn(name, "0123456789")] != '\0';
+}
+
+
+/************************************************************************
+*                 Module-specific function definitions                  *
+************************************************************************/
+
+// These functions are documented at the start of this file
+
+
+/***********************************************************************/
+// init_game_file_codeset: Set up character set conversion
+
+void init_game_file_codeset (void)
+{
+    char *codeset;
+
+
+    if (game_file_codeset_nl != NULL) {
+	return;
+    }
+
+    codeset = nl_langinfo(CODESET);
+    if (codeset == NULL) {
+	errno_exit("nl_langinfo(CODESET)");
+    }
 
 #ifdef USE_UTF8_GAME_FILE
+    // All strings are read and written in UTF-8 format for consistency
+    need_icd = (strcmp(codeset, GAME_FILE_CHARSET) != 0);
     if (need_icd) {
-	iconv_close(icd);
+	// Try using the GNU libiconv "//TRANSLIT" option
+	char *buf = xmalloc(strlen(codeset) + strlen(GAME_FILE_TRANSLIT) + 1);
+
+	strcpy(buf, codeset);
+	strcat(buf, GAME_FILE_TRANSLIT);
+
+	load_icd = iconv_open(buf, GAME_FILE_CHARSET);
+	if (load_icd == (iconv_t) -1) {
+	    // Try iconv_open() without "//TRANSLIT"
+	    load_icd = iconv_open(codeset, GAME_FILE_CHARSET);
+	    if (load_icd == (iconv_t) -1) {
+		errno_exit("iconv_open");
+	    }
+	}
+	free(buf);
+
+	save_icd = iconv_open(GAME_FILE_CHARSET, codeset);
+	if (save_icd == (iconv_t) -1) {
+	    errno_exit("iconv_open");
+	}
     }
-#endif
 
-    free(buf);
-    free(encbuf);
+    game_file_codeset_nl = xstrdup(GAME_FILE_CHARSET "\n");
+#else // ! USE_UTF8_GAME_FILE
+    // All strings are read and written in the locale's codeset
+    game_file_codeset_nl = xmalloc(strlen(codeset) + 2);
+    strcpy(game_file_codeset_nl, codeset);
+    strcat(game_file_codeset_nl, "\n");
+#endif // ! USE_UTF8_GAME_FILE
+}
+
+
+/************************************************************************
+*                 Saved game index function definitions                 *
+************************************************************************/
+
+// These functions are documented at the start of this file
+
+
+/***********************************************************************/
+// format_game_summary: Describe the current game in one line
+
+void format_game_summary (char *restrict buf, size_t bufsize,
+			  game_summary_t *restrict summary)
+{
+    assert(buf != NULL);
+    assert(summary != NULL);
+
+    summary->number_players = number_players;
+    summary->turn_number    = turn_number;
+    summary->max_turn       = max_turn;
+    summary->saved          = time(NULL);
+    summary->leader_value   = 0.0;
+
+    if (game_name != NULL) {
+	assert(valid_game_name(game_name));
+	strcpy(summary->name, game_name);
+    } else {
+	*summary->name = '\0';
+    }
+
+    for (int i = 0; i < number_players; i++) {
+	if (player[i].in_game) {
+	    summary->leader_value = MAX(summary->leader_value,
+					total_value(i));
+	}
+    }
+
+    snprintf(buf, bufsize, GAME_SUMMARY_FMT, summary->number_players,
+	     summary->turn_number, summary->max_turn,
+	     (long long int) summary->saved, summary->leader_value,
+	     (*summary->name != '\0') ? " " : "", summary->name);
+}
+
+
+/***********************************************************************/
+// parse_game_summary: Parse a summary line
+
+bool parse_game_summary (const char *restrict str,
+			 game_summary_t *restrict summary)
+{
+    long long int saved;
+    const char *p;
+    size_t len;
+    int n;
+
+
+    assert(str != NULL);
+    assert(summary != NULL);
+
+    if (sscanf(str, "%d %d %d %lld %lf%n", &summary->number_players,
+	       &summary->turn_number, &summary->max_turn, &saved,
+	       &summary->leader_value, &n) != 5) {
+	return false;
+    }
+    summary->saved = (time_t) saved;
+
+    // The game name, if any, takes up the rest of the line
+    for (p = str + n; *p == ' '; p++)
+	;
+    len = strcspn(p, "\n");
+    if (len > GAME_NAME_LEN) {
+	return false;
+    }
+    memcpy(summary->name, p, len);
+    summary->name[len] = '\0';
+    if (len > 0 && ! valid_game_name(summary->name)) {
+	return false;
+    }
+
+    return summary->number_players >= 1
+	&& summary->number_players <= MAX_PLAYERS
+	&& summary->turn_number >= 1
+	&& summary->turn_number <= summary->max_turn
+	&& summary->leader_value >= 0.0;
+}
+
+
+/***********************************************************************/
+// read_game_summary: Read the summary line of a game file
+
+bool read_game_summary (int num, game_summary_t *summary)
+{
+    char buf[BUFSIZE];
+    char *filename;
+    FILE *file;
+    bool ret;
+
+
+    assert(summary != NULL);
+
+    filename = game_filename(num);
+    if (filename == NULL) {
+	return false;
+    }
+
+    file = fopen(filename, "r");
     free(filename);
-    free(prev_locale);
-    return true;
+    if (file == NULL) {
+	return false;
+    }
+
+    // Header, API version, codeset, then the summary line
+    ret = fgets(buf, BUFSIZE, file) != NULL
+	&& strcmp(buf, GAME_FILE_HEADER "\n") == 0
+	&& fgets(buf, BUFSIZE, file) != NULL
+	&& strcmp(buf, GAME_FILE_API_VERSION "\n") == 0
+	&& fgets(buf, BUFSIZE, file) != NULL
+	&& fgets(buf, BUFSIZE, file) != NULL
+	&& parse_game_summary(buf, summary);
+
+    fclose(file);
+
+    summary->num = num;
+    return ret;
+}
+
+
+/***********************************************************************/
+// read_game_index: Read the index of saved games
+
+int read_game_index (game_summary_t **summaries)
+{
+    char buf[BUFSIZE];
+    char *filename;
+    FILE *file;
+    game_summary_t *s;
+    int count, size;
+
+
+    assert(summaries != NULL);
+
+    filename = data_filename(GAME_INDEX_FILENAME);
+    file = fopen(filename, "r");
+    free(filename);
+    if (file == NULL) {
+	return -1;
+    }
+
+    if (fgets(buf, BUFSIZE, file) == NULL
+	|| strcmp(buf, GAME_INDEX_HEADER "\n") != 0) {
+	fclose(file);
+	return -1;
+    }
+
+    s = NULL;
+    count = size = 0;
+
+    while (fgets(buf, BUFSIZE, file) != NULL) {
+	int num, n;
+
+	if (count == size) {
+	    size = (size == 0) ? BUFSIZE / sizeof(game_summary_t) : size * 2;
+	    s = xrealloc(s, size * sizeof(game_summary_t));
+	}
+
+	if (sscanf(buf, "%d %n", &num, &n) != 1
+	    || num < 1 || num > MAX_GAME_NUM
+	    || ! parse_game_summary(buf + n, &s[count])) {
+	    free(s);
+	    fclose(file);
+	    return -1;
+	}
+
+	s[count++].num = num;
+    }
+
+    fclose(file);
+
+    *summaries = s;
+    return count;
+}
+
+
+/***********************************************************************/
+// scan_game_files: Rebuild the index from the game files
+
+int scan_game_files (game_summary_t **summaries)
+{
+    const char *data_dir;
+    DIR *dir;
+    struct dirent *de;
+    game_summary_t *s;
+    int count, size;
+
+
+    assert(summaries != NULL);
+
+    s = NULL;
+    count = size = 0;
+
+    data_dir = data_directory();
+    dir = opendir(data_dir != NULL ? data_dir : ".");
+
+    if (dir != NULL) {
+	while ((de = readdir(dir)) != NULL) {
+	    int num = game_filename_num(de->d_name);
+
+	    if (num == 0) {
+		continue;
+	    }
+
+	    if (count == size) {
+		size = (size == 0) ? BUFSIZE / sizeof(game_summary_t)
+		    : size * 2;
+		s = xrealloc(s, size * sizeof(game_summary_t));
+	    }
+
+	    if (read_game_summary(num, &s[count])) {
+		count++;
+	    }
+	}
+
+	closedir(dir);
+    }
+
+    *summaries = s;
+    return count;
+}
+
+
+/***********************************************************************/
+// write_game_index: Write the index of saved games
+
+void write_game_index (const game_summary_t *summaries, int count)
+{
+    char *filename, *tmpname;
+    FILE *file;
+    bool ok;
+
+
+    assert(summaries != NULL || count == 0);
+
+    filename = data_filename(GAME_INDEX_FILENAME);
+    tmpname = xmalloc(strlen(filename) + strlen(GAME_INDEX_TMP_SUFFIX) + 1);
+    strcpy(tmpname, filename);
+    strcat(tmpname, GAME_INDEX_TMP_SUFFIX);
+
+    file = fopen(tmpname, "w");
+    if (file != NULL) {
+	ok = fprintf(file, "%s\n", GAME_INDEX_HEADER) >= 0;
+
+	for (int i = 0; ok && i < count; i++) {
+	    ok = fprintf(file, "%d " GAME_SUMMARY_FMT, summaries[i].num,
+			 summaries[i].number_players,
+			 summaries[i].turn_number, summaries[i].max_turn,
+			 (long long int) summaries[i].saved,
+			 summaries[i].leader_value,
+			 (*summaries[i].name != '\0') ? " " : "",
+			 summaries[i].name) >= 0;
+	}
+
+	ok = (fclose(file) != EOF) && ok;
+
+	if (! ok || rename(tmpname, filename) != 0) {
+	    unlink(tmpname);
+	}
+    }
+
+    free(tmpname);
+    free(filename);
+}
+
+
+/***********************************************************************/
+// update_game_index: Add or replace one game in the index
+
+void update_game_index (const game_summary_t *summary)
+{
+    game_summary_t *summaries;
+    int count, i;
+
+
+    assert(summary != NULL);
+
+    count = read_game_index(&summaries);
+
+    if (count < 0) {
+	// Rebuild the index; this includes the game just saved
+	count = scan_game_files(&summaries);
+    } else {
+	for (i = 0; i < count; i++) {
+	    if (summaries[i].num == summary->num) {
+		break;
+	    }
+	}
+
+	if (i == count) {
+	    summaries = xrealloc(summaries, (count + 1)
+				 * sizeof(game_summary_t));
+	    count++;
+	}
+
+	summaries[i] = *summary;
+    }
+
+    write_game_index(summaries, count);
+    free(summaries);
+}
+
+
+/***********************************************************************/
+// cmp_game_summary: Compare two summaries for sorting
+
+int cmp_game_summary (const void *a, const void *b)
+{
+    const game_summary_t *aa = (const game_summary_t *) a;
+    const game_summary_t *bb = (const game_summary_t *) b;
+
+
+    if (aa->saved > bb->saved) {
+	return -1;
+    } else if (aa->saved < bb->saved) {
+	return 1;
+    } else {
+	return (aa->num > bb->num) - (aa->num < bb->num);
+    }
 }
 
 
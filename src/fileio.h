@@ -32,13 +32,36 @@
 #define included_FILEIO_H 1
 
 
+/************************************************************************
+*                    Saved game summary declarations                    *
+************************************************************************/
+
+/*
+  Each saved game file contains a short, unencrypted summary line after
+  the file header.  A copy of every summary is also kept in an index file
+  in the data directory, so that saved games can be listed without
+  opening (let alone decrypting) each game file.  A saved game may also
+  have a name, by which it can be loaded instead of by its number.
+*/
+
+typedef struct game_summary {
+    int		num;			// Game number (1 to MAX_GAME_NUM)
+    char	name[GAME_NAME_LEN + 1];	// Name of the game, or ""
+    int		number_players;		// Number of players in the game
+    int		turn_number;		// Turn number when saved
+    int		max_turn;		// Maximum turn number
+    time_t	saved;			// Time the game was saved
+    double	leader_value;		// Total value of the leading player
+} game_summary_t;
+
+
 /************************************************************************
 *                Game load and save function prototypes                 *
 ************************************************************************/
 
 /*
   Function:   load_game - Load a previously-saved game from disk
-  Parameters: num       - Game number to load (1-9)
+  Parameters: num       - Game number to load (1 to MAX_GAME_NUM)
   Returns:    bool      - True if game loaded successfully, else false
 
   This function loads a previously-saved game from disk, initialising all
@@ -50,13 +73,63 @@ extern bool load_game (int num);
 
 /*
   Function:   save_game - Save the current game to disk
-  Parameters: num       - Game number to use (1-9)
+  Parameters: num       - Game number to use (1 to MAX_GAME_NUM)
   Returns:    bool      - True if game saved successfully, else false
 
   This function saves the current game to disk.  True is returned if this
-  could be done successfully.
+  could be done successfully.  The index of saved games is also updated.
 */
 extern bool save_game (int num);
 
 
+/*
+  Function:   list_saved_games - List all saved games using the index
+  Parameters: summaries        - Pointer to array of summaries (output)
+  Returns:    int              - Number of saved games
+
+  This function reads the index of saved games and places a newly
+  allocated array of game summaries, most recently saved first, in
+  *summaries; the caller must free() this array.  If the index does not
+  exist or is invalid, it is rebuilt by reading just the summary line of
+  every game file in the data directory.  Game files saved by earlier
+  versions of Star Traders do not have a summary and are not listed.
+*/
+extern int list_saved_games (game_summary_t **summaries);
+
+
+/*
+  Function:   find_saved_game - Find the number of a named saved game
+  Parameters: name            - Name of the saved game
+  Returns:    int             - Game number, or 0 if there is no such game
+
+  This function looks up name in the index of saved games and returns
+  the number of the most recently saved game of that name.
+*/
+extern int find_saved_game (const char *name);
+
+
+/*
+  Function:   unused_game_number - Suggest a number for a new saved game
+  Parameters: (none)
+  Returns:    int                - Game number (1 to MAX_GAME_NUM)
+
+  This function returns the number after the highest one used by any
+  saved game, or MAX_GAME_NUM if that number is already in use.
+*/
+extern int unused_game_number (void);
+
+
+/*
+  Function:   valid_game_name - Check the name of a saved game
+  Parameters: name            - Name to check
+  Returns:    bool            - True if name may be used for a saved game
+
+  A name is valid if it is 1 to GAME_NAME_LEN characters long, made up of
+  ASCII letters, digits, ".", "-" and "_", and is not just digits (which
+  would be taken as a game number).  Such names can be written to game
+  files and typed in any locale.
+*/
+extern bool valid_game_name (const char *name);
+
+
 #endif /* included_FILEIO_H */
@@ -32,6 +32,50 @@
 #include "trader.h"
 
 
+/************************************************************************
+*                        Module-specific macros                         *
+************************************************************************/
+
+#define MAX_SAVED_GAMES_SHOWN	8	// Saved games listed in game number window
+
+#define NAMES_INITIAL		(MAX_PLAYERS + MAX_COMPANIES)
+					// Initial size of the table of names
+#define NAME_TEXT_INITIAL	BUFSIZE	// Initial size of each text buffer
+
+
+/************************************************************************
+*                   Module-specific type declarations                   *
+************************************************************************/
+
+// One entry in the table of names
+typedef struct name_entry {
+    size_t		wcs_off;	// Offset of name in name_text
+    size_t		mbs_off;	// Offset of file form in name_mbtext
+    bool		have_mbs;	// True if mbs_off is valid
+} name_entry_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+// Translated company names, as returned by company_wname()
+static wchar_t *company_wname_cache[MAX_COMPANIES];
+
+// Table of names, as kept by intern_name()
+static name_entry_t *name_table = NULL;	// Each name in the table
+static int num_names = 0;		// Number of names
+static int max_names = 0;		// Size of name_table[]
+
+static char *name_text = NULL;		// Names, as NUL-terminated wchar_t
+static size_t name_text_len = 0;	// Bytes of name_text in use
+static size_t name_text_size = 0;	// Size of name_text
+
+static char *name_mbtext = NULL;	// Game file forms of names
+static size_t name_mbtext_len = 0;	// Bytes of name_mbtext in use
+static size_t name_mbtext_size = 0;	// Size of name_mbtext
+
+
 /************************************************************************
 *                  Module-specific function prototypes                  *
 ************************************************************************/
@@ -50,20 +94,6 @@
 static int ask_number_players (void);
 
 
-/*
-  Function:   ask_game_number - Ask for the game number
-  Parameters: (none)
-  Returns:    int    - Game number (1-9) or ERR to cancel
-
-  This internal function asks the user which game number to load.  It
-  returns a number 1 to 9 as a response, or ERR if the user wishes to
-  cancel loading a game.
-
-  Please note that the window opened by this function is NOT closed!
-*/
-static int ask_game_number (void);
-
-
 /*
   Function:   ask_player_names - Ask for each of the players' names
   Parameters: (none)
@@ -74,9 +104,10 @@ static int ask_game_number (void);
   playing the game.
 
   On entry, the global variable number_players is used to determine how
-  many people are playing.  On exit, each player[].name is set.  The
-  windows created by this function ARE closed, but not any other window.
-  Note also that txrefresh() is NOT called.
+  many people are playing.  On exit, the table of names holds only the
+  players' names, and each player[].name is set.  The windows created by
+  this function ARE closed, but not any other window.  Note also that
+  txrefresh() is NOT called.
 */
 static void ask_player_names (void);
 
@@ -95,6 +126,25 @@ static void ask_player_names (void);
 static int cmp_player (const void *a, const void *b);
 
 
+/*
+  Function:   append_text - Append data to a buffer of names
+  Parameters: buf         - Pointer to buffer (may be moved)
+              len         - Pointer to number of bytes in use
+              size        - Pointer to size of buffer
+              data        - Data to append
+              n           - Number of bytes of data
+  Returns:    size_t      - Offset of the data in the buffer
+
+  This internal function appends n bytes from data to the buffer *buf,
+  enlarging it as needed.  As n is always a multiple of the size of the
+  characters kept in the buffer, the offset returned is suitably aligned
+  for them.
+*/
+static size_t append_text (char **restrict buf, size_t *restrict len,
+			   size_t *restrict size, const void *restrict data,
+			   size_t n);
+
+
 /************************************************************************
 *                       Game function definitions                       *
 ************************************************************************/
@@ -108,9 +158,16 @@ static int cmp_player (const void *a, const void *b);
 
 void init_game (void)
 {
+    // A game name on the command line refers to a game saved under that
+    // name; if there is none, a new game of that name is started
+    if (game_num == 0 && game_name != NULL) {
+	game_num = find_saved_game(game_name);
+    }
+
     // Try to load an old game, if possible
     if (game_num != 0) {
-	chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+	scratch_mark_t mark = scratch_mark();
+	chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 	int width;
 
 	mkchstr(chbuf, BUFSIZE, attr_status_window, 0, 0, 1, WIN_COLS - 7,
@@ -123,7 +180,7 @@ void init_game (void)
 
 	deltxwin();
 	txrefresh();
-	free(chbuf);
+	scratch_release(mark);
     }
 
     // Initialise game data, if not already loaded
@@ -137,12 +194,13 @@ void init_game (void)
 		return;
 
 	    } else if (choice == 0) {
-		choice = ask_game_number();
+		choice = ask_game_number(false);
 
 		if (choice != ERR) {
 		    // Try to load the game, if possible
 
-		    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+		    scratch_mark_t mark = scratch_mark();
+		    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 		    int width;
 
 		    game_num = choice;
@@ -158,7 +216,7 @@ void init_game (void)
 
 		    deltxwin();
 		    txrefresh();
-		    free(chbuf);
+		    scratch_release(mark);
 		}
 
 		deltxwin();		// "Enter game number" window
@@ -171,65 +229,21 @@ void init_game (void)
 	}
 
 	if (! game_loaded) {
-	    wchar_t *buf = xmalloc(BUFSIZE * sizeof(wchar_t));
-
 	    ask_player_names();
 
 	    deltxwin();			// "Number of players" window
 	    txrefresh();
 
-	    // Initialise player data (other than names)
-	    for (int i = 0; i < number_players; i++) {
-		player[i].cash    = INITIAL_CASH;
-		player[i].debt    = 0.0;
-		player[i].in_game = true;
-
-		for (int j = 0; j < MAX_COMPANIES; j++) {
-		    player[i].stock_owned[j] = 0;
-		}
-	    }
-
-	    // Initialise company data
-	    for (int i = 0; i < MAX_COMPANIES; i++) {
-		xmbstowcs(buf, gettext(company_name[i]), BUFSIZE);
-		company[i].name         = xwcsdup(buf);
-		company[i].share_price  = 0.0;
-		company[i].share_return = INITIAL_RETURN;
-		company[i].stock_issued = 0;
-		company[i].max_stock    = 0;
-		company[i].on_map       = false;
-	    }
-
-	    // Initialise galaxy map
-	    for (int x = 0; x < MAX_X; x++) {
-		for (int y = 0; y < MAX_Y; y++) {
-		    galaxy_map[x][y] = (randf() < STAR_RATIO) ?
-			MAP_STAR : MAP_EMPTY;
-		}
-	    }
-
-	    // Miscellaneous initialisation
-	    interest_rate = INITIAL_INTEREST_RATE;
-	    max_turn = option_max_turn ? option_max_turn : DEFAULT_MAX_TURN;
-	    turn_number = 1;
-
-	    // Select who is to go first
-	    if (number_players == 1) {
-		first_player   = 0;
-		current_player = 0;
-	    } else {
-		first_player   = randi(number_players);
-		current_player = first_player;
+	    new_game();
 
+	    if (number_players > 1) {
 		txdlgbox(MAX_DLG_LINES, 50, 8, WCENTER, attr_normal_window,
 			 attr_title, attr_normal, attr_highlight, 0,
 			 attr_waitforkey, _("  First Player  "),
 			 _("The first player to go is ^{%ls^}."),
-			 player[first_player].name);
+			 name_wcs(player[first_player].name));
 		txrefresh();
 	    }
-
-	    free(buf);
 	}
     }
 
@@ -238,13 +252,171 @@ void init_game (void)
 }
 
 
+/***********************************************************************/
+// new_game: Set up the data for a new game
+
+void new_game (void)
+{
+    // Initialise player data (other than names)
+    for (int i = 0; i < number_players; i++) {
+	player[i].cash    = INITIAL_CASH;
+	player[i].debt    = 0.0;
+	player[i].in_game = true;
+
+	for (int j = 0; j < MAX_COMPANIES; j++) {
+	    player[i].stock_owned[j] = 0;
+	}
+    }
+
+    // Initialise company data
+    for (int i = 0; i < MAX_COMPANIES; i++) {
+	company[i].name         = intern_name(company_wname(i), NULL);
+	company[i].share_price  = 0.0;
+	company[i].share_return = INITIAL_RETURN;
+	company[i].stock_issued = 0;
+	company[i].max_stock    = 0;
+	company[i].on_map       = false;
+    }
+
+    // Initialise galaxy map
+    for (int x = 0; x < MAX_X; x++) {
+	for (int y = 0; y < MAX_Y; y++) {
+	    galaxy_map[x][y] = (randf() < STAR_RATIO) ? MAP_STAR : MAP_EMPTY;
+	}
+    }
+
+    // Miscellaneous initialisation
+    interest_rate = INITIAL_INTEREST_RATE;
+    max_turn = option_max_turn ? option_max_turn : DEFAULT_MAX_TURN;
+    turn_number = 1;
+
+    // Select who is to go first
+    if (number_players == 1) {
+	first_player   = 0;
+	current_player = 0;
+    } else {
+	first_player   = randi(number_players);
+	current_player = first_player;
+    }
+}
+
+
+/***********************************************************************/
+// company_wname: Return the translated name of a company
+
+wchar_t *company_wname (int num)
+{
+    assert(num >= 0 && num < MAX_COMPANIES);
+
+    if (company_wname_cache[num] == NULL) {
+	wchar_t *buf = xmalloc(BUFSIZE * sizeof(wchar_t));
+
+	xmbstowcs(buf, gettext(company_name[num]), BUFSIZE);
+	company_wname_cache[num] = xwcsdup(buf);
+	free(buf);
+    }
+
+    return company_wname_cache[num];
+}
+
+
+/***********************************************************************/
+// clear_names: Empty the table of names
+
+void clear_names (void)
+{
+    num_names = 0;
+    name_text_len = 0;
+    name_mbtext_len = 0;
+}
+
+
+/***********************************************************************/
+// intern_name: Add a name to the table of names
+
+name_ref_t intern_name (const wchar_t *restrict name, const char *restrict mbs)
+{
+    name_ref_t ref;
+
+
+    assert(name != NULL);
+
+    for (ref = 0; ref < num_names; ref++) {
+	if (wcscmp(name_wcs(ref), name) == 0) {
+	    break;
+	}
+    }
+
+    if (ref == num_names) {
+	if (num_names == max_names) {
+	    max_names = (max_names == 0) ? NAMES_INITIAL : max_names * 2;
+	    name_table = xrealloc(name_table, max_names
+				  * sizeof(name_entry_t));
+	}
+
+	name_table[ref].wcs_off = append_text(&name_text, &name_text_len,
+					 &name_text_size, name,
+					 (wcslen(name) + 1) * sizeof(wchar_t));
+	name_table[ref].have_mbs = false;
+	num_names++;
+    }
+
+    if (mbs != NULL && ! name_table[ref].have_mbs) {
+	set_name_mbs(ref, mbs);
+    }
+
+    return ref;
+}
+
+
+/***********************************************************************/
+// name_wcs: Return a name from the table of names
+
+const wchar_t *name_wcs (name_ref_t ref)
+{
+    assert(ref >= 0 && ref < num_names);
+
+    return (const wchar_t *) (name_text + name_table[ref].wcs_off);
+}
+
+
+/***********************************************************************/
+// name_mbs: Return the form of a name written to game files
+
+const char *name_mbs (name_ref_t ref)
+{
+    assert(ref >= 0 && ref < num_names);
+
+    if (! name_table[ref].have_mbs) {
+	return NULL;
+    }
+
+    return name_mbtext + name_table[ref].mbs_off;
+}
+
+
+/***********************************************************************/
+// set_name_mbs: Set the form of a name written to game files
+
+void set_name_mbs (name_ref_t ref, const char *restrict mbs)
+{
+    assert(ref >= 0 && ref < num_names);
+    assert(mbs != NULL);
+
+    name_table[ref].mbs_off = append_text(&name_mbtext, &name_mbtext_len,
+				     &name_mbtext_size, mbs, strlen(mbs) + 1);
+    name_table[ref].have_mbs = true;
+}
+
+
 /***********************************************************************/
 // ask_number_players: Ask for the number of players
 
 static int ask_number_players (void)
 {
     wchar_t *keycode_contgame = xmalloc(BUFSIZE * sizeof(wchar_t));
-    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    scratch_mark_t mark = scratch_mark();
+    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
     int lines, maxwidth;
     int widthbuf[2];
     int ret;
@@ -263,7 +435,7 @@ static int ask_number_players (void)
 
     newtxwin(lines + 4, maxwidth, 3, WCENTER, true, attr_normal_window);
     leftch(curwin, 2, 2, chbuf, lines, widthbuf);
-    free(chbuf);
+    scratch_release(mark);
 
     curs_set(CURS_ON);
     wrefresh(curwin);
@@ -326,67 +498,184 @@ static int ask_number_players (void)
 /***********************************************************************/
 // ask_game_number: Ask for the game number
 
-int ask_game_number (void)
+int ask_game_number (bool saving)
 {
+    game_summary_t *summaries;
+    scratch_mark_t mark;
     chtype *chbuf;
-    int lines, maxwidth;
-    int widthbuf[2];
-    int ret;
+    char timebuf[BUFSIZE];
+    char namebuf[GAME_NAME_LEN + 1];
+    wchar_t buf[GAME_NAME_LEN + 1];
+    wchar_t defaultstr[GAME_NAME_LEN + 1];
+    int n, shown, i, w, x, y, line, width, ret, num;
     bool done;
 
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    lines = mkchstr(chbuf, BUFSIZE, attr_normal, attr_keycode, 0, 2,
-		    WIN_COLS - 7, widthbuf, 2,
-		    _("Enter game number [^{1^}-^{9^}] "
-		      "or ^{<CTRL><C>^} to cancel: "));
-    assert(lines == 1 || lines == 2);
-    maxwidth = (lines == 1 ? widthbuf[0] : MAX(widthbuf[0], widthbuf[1])) + 5;
+    n = list_saved_games(&summaries);
+    shown = MIN(n, MAX_SAVED_GAMES_SHOWN);
 
-    newtxwin(lines + 4, maxwidth, 6, WCENTER, true, attr_normal_window);
-    leftch(curwin, 2, 2, chbuf, lines, widthbuf);
-    free(chbuf);
+    if (saving) {
+	// Suggest the game number after the highest one already in use
+	swprintf(defaultstr, GAME_NAME_LEN + 1, L"%d", unused_game_number());
+    } else if (n > 0 && *summaries[0].name != '\0') {
+	// Suggest the most recently saved game, by name if it has one
+	swprintf(defaultstr, GAME_NAME_LEN + 1, L"%s", summaries[0].name);
+    } else {
+	swprintf(defaultstr, GAME_NAME_LEN + 1, L"%d",
+		 (n > 0) ? summaries[0].num : 1);
+    }
 
-    curs_set(CURS_ON);
-    wrefresh(curwin);
+    newtxwin((shown > 0) ? shown + 9 : 5, WIN_COLS - 4, 6, WCENTER, true,
+	     attr_normal_window);
+    w = getmaxx(curwin);
+
+    if (shown > 0) {
+	center(curwin, 1, 0, attr_title, 0, 0, 1, _("  Saved Games  "));
+
+	mvwhline(curwin, 3, 2, ' ' | attr_subtitle, w - 4);
+
+	x = 4 + GAME_NUM_COLS;
+	right(curwin, 3, x, attr_subtitle, 0, 0, 1,
+	      /* TRANSLATORS: "Game" is a column label in a table
+		 containing a list of saved games; each entry shows the
+		 game name, or the game number if it has no name.  The
+		 maximum column width is 8 characters (see GAME_NUM_COLS in
+		 src/intf.h). */
+	      pgettext("subtitle", "Game"));
+	x += 2 + SAVED_PLAYERS_COLS;
+	right(curwin, 3, x, attr_subtitle, 0, 0, 1,
+	      /* TRANSLATORS: "Players" is a column label in a table
+		 containing a list of saved games.  The maximum column
+		 width is 8 characters (see SAVED_PLAYERS_COLS in
+		 src/intf.h). */
+	      pgettext("subtitle", "Players"));
+	x += 2 + SAVED_TURN_COLS;
+	right(curwin, 3, x, attr_subtitle, 0, 0, 1,
+	      /* TRANSLATORS: "Turn" is a column label in a table
+		 containing a list of saved games; each entry shows the
+		 turn number out of the maximum number of turns.  The
+		 maximum column width is 9 characters (see SAVED_TURN_COLS
+		 in src/intf.h). */
+	      pgettext("subtitle", "Turn"));
+	left(curwin, 3, x + 3, attr_subtitle, 0, 0, 1,
+	     /* TRANSLATORS: "Saved" is a column label in a table
+		containing a list of saved games; each entry shows the
+		date and time the game was saved. */
+	     pgettext("subtitle", "Saved"));
+	right(curwin, 3, w - 4, attr_subtitle, 0, 0, 1,
+	      /* TRANSLATORS: "Leader's worth" is a column label in a
+		 table containing a list of saved games; each entry shows
+		 the total value of the player in the lead.  %ls is the
+		 currency symbol in the current locale.  The maximum
+		 column width is 18 characters INCLUDING the currency
+		 symbol (see TOTAL_VALUE_COLS in src/intf.h). */
+	      pgettext("subtitle", "Leader's worth (%ls)"), currency_symbol);
+
+	for (line = 4, i = 0; i < shown; line++, i++) {
+	    struct tm *tm = localtime(&summaries[i].saved);
+
+	    if (tm == NULL || strftime(timebuf, sizeof(timebuf),
+				       /* TRANSLATORS: This is the format
+					  used to show when a game was
+					  saved.  See strftime(3) for
+					  details.  It should be no wider
+					  than 16 characters. */
+				       pgettext("strftime", "%Y-%m-%d %H:%M"),
+				       tm) == 0) {
+		strcpy(timebuf, "-");
+	    }
 
+	    x = 4 + GAME_NUM_COLS;
+	    if (*summaries[i].name != '\0') {
+		right(curwin, line, x, attr_normal, 0, 0, 1, "%s",
+		      summaries[i].name);
+	    } else {
+		right(curwin, line, x, attr_normal, 0, 0, 1, "%d",
+		      summaries[i].num);
+	    }
+	    x += 2 + SAVED_PLAYERS_COLS;
+	    right(curwin, line, x, attr_normal, 0, 0, 1, "%d",
+		  summaries[i].number_players);
+	    x += 2 + SAVED_TURN_COLS;
+	    right(curwin, line, x, attr_normal, 0, 0, 1, "%d/%d",
+		  summaries[i].turn_number, summaries[i].max_turn);
+	    left(curwin, line, x + 3, attr_normal, 0, 0, 1, "%s", timebuf);
+	    right(curwin, line, w - 4, attr_normal, 0, 0, 1, "%!N",
+		  summaries[i].leader_value);
+	}
+
+	if (n > shown) {
+	    center(curwin, line, 0, attr_normal, attr_highlight, 0, 1,
+		   ngettext("(and ^{one^} other saved game)",
+			    "(and ^{%'d^} other saved games)", n - shown),
+		   n - shown);
+	}
+
+	y = shown + 6;
+    } else {
+	y = 2;
+    }
+
+    free(summaries);
+
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    mkchstr(chbuf, BUFSIZE, attr_normal, attr_keycode, 0, 1,
+	    w - GAME_NUM_COLS - 4, &width, 1,
+	    _("Enter game number [^{1^}-^{%'d^}] or name, "
+	      "or ^{<CTRL><C>^} to cancel: "), MAX_GAME_NUM);
+    x = (w + width - GAME_NUM_COLS) / 2;
+    rightch(curwin, y, x, chbuf, 1, &width);
+    scratch_release(mark);
+
+    *buf = L'\0';
     done = false;
     while (! done) {
-	wint_t key;
+	ret = gettxline(curwin, buf, GAME_NAME_LEN + 1, NULL, false,
+			defaultstr, defaultstr, L"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+			L"abcdefghijklmnopqrstuvwxyz0123456789._-", true,
+			y, x, GAME_NUM_COLS, attr_input_field);
 
-	if (gettxchar(curwin, &key) == OK) {
-	    // Ordinary wide character
-	    if (key >= L'1' && key <= L'9') {
-		left(curwin, getcury(curwin), getcurx(curwin), A_BOLD,
-		     0, 0, 1, "%lc", key);
-		wrefresh(curwin);
+	if (ret != OK) {
+	    return ERR;
+	}
 
-		ret = key - L'0';
+	// Only ASCII characters can have been typed in
+	for (i = 0; buf[i] != L'\0'; i++) {
+	    namebuf[i] = (char) buf[i];
+	}
+	namebuf[i] = '\0';
+
+	if (valid_game_name(namebuf)) {
+	    // A game name: find the game saved under that name, if any
+	    num = find_saved_game(namebuf);
+	    if (num == 0 && saving) {
+		num = unused_game_number();
+	    }
+	    if (num != 0) {
+		if (saving) {
+		    free(game_name);
+		    game_name = xstrdup(namebuf);
+		}
 		done = true;
-	    } else {
-		beep();
 	    }
 	} else {
-	    // Function or control key
-	    switch (key) {
-	    case KEY_ESC:
-	    case KEY_CANCEL:
-	    case KEY_EXIT:
-	    case KEY_CTRL('C'):
-	    case KEY_CTRL('G'):
-	    case KEY_CTRL('\\'):
-		ret = ERR;
-		done = true;
-		break;
+	    // A game number
+	    char *p;
+	    long int val = strtol(namebuf, &p, 10);
 
-	    default:
-		beep();
+	    if (*p == '\0' && val >= 1 && val <= MAX_GAME_NUM) {
+		num = (int) val;
+		done = true;
 	    }
 	}
+
+	if (! done) {
+	    beep();
+	}
     }
 
-    curs_set(CURS_OFF);
-    return ret;
+    return num;
 }
 
 
@@ -395,10 +684,17 @@ int ask_game_number (void)
 
 void ask_player_names (void)
 {
-    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    scratch_mark_t mark = scratch_mark();
+    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    wchar_t *names[MAX_PLAYERS];
     int width;
 
 
+    for (int i = 0; i < number_players; i++) {
+	names[i] = NULL;
+    }
+
+
     if (number_players == 1) {
 	// Ask for the player's name
 
@@ -408,12 +704,10 @@ void ask_player_names (void)
 	int x = getcurx(curwin);
 	int w = getmaxx(curwin) - x - 2;
 
-	player[0].name = NULL;
-	player[0].name_utf8 = NULL;
 	while (true) {
-	    int ret = gettxstr(curwin, &player[0].name, NULL, false,
+	    int ret = gettxstr(curwin, &names[0], NULL, false,
 			       2, x, w, attr_input_field);
-	    if (ret == OK && wcslen(player[0].name) != 0) {
+	    if (ret == OK && wcslen(names[0]) != 0) {
 		break;
 	    } else {
 		beep();
@@ -448,8 +742,6 @@ void ask_player_names (void)
 	center(curwin, 1, 0, attr_title, 0, 0, 1, _("  Enter Player Names  "));
 
 	for (i = 0; i < number_players; i++) {
-	    player[i].name = NULL;
-	    player[i].name_utf8 = NULL;
 	    entered[i] = false;
 	    left(curwin, i + 3, 2, attr_normal, 0, 0, 1,
 		 /* xgettext:c-format, range: 1..8 */
@@ -462,13 +754,13 @@ void ask_player_names (void)
 	cur = 0;
 	done = false;
 	while (! done) {
-	    int ret = gettxstr(curwin, &player[cur].name, &modified, true,
+	    int ret = gettxstr(curwin, &names[cur], &modified, true,
 			       3 + cur, x, w, attr_input_field);
 
 	    switch (ret) {
 	    case OK:
 		// Make sure name is not an empty string
-		len = wcslen(player[cur].name);
+		len = wcslen(names[cur]);
 		entered[cur] = (len != 0);
 		if (len == 0) {
 		    beep();
@@ -476,8 +768,8 @@ void ask_player_names (void)
 
 		// Make sure name has not been entered already
 		for (i = 0; i < number_players; i++) {
-		    if (i != cur && player[i].name != NULL
-			&& wcscmp(player[i].name, player[cur].name) == 0) {
+		    if (i != cur && names[i] != NULL
+			&& wcscmp(names[i], names[cur]) == 0) {
 			entered[cur] = false;
 			beep();
 			break;
@@ -543,7 +835,15 @@ void ask_player_names (void)
 
     deltxwin();				// "Need instructions?" window
     deltxwin();				// "Enter player names" window
-    free(chbuf);
+
+    // Keep the names in the table of names for this game
+    clear_names();
+    for (int i = 0; i < number_players; i++) {
+	player[i].name = intern_name(names[i], NULL);
+	free(names[i]);
+    }
+
+    scratch_release(mark);
 }
 
 
@@ -552,6 +852,7 @@ void ask_player_names (void)
 
 void end_game (void)
 {
+    scratch_mark_t mark;
     chtype *chbuf;
     int lines, widthbuf[5];
 
@@ -561,7 +862,8 @@ void end_game (void)
 	return;
     }
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 
     txdlgbox(MAX_DLG_LINES, 50, 9, WCENTER, attr_error_window,
 	     attr_error_title, attr_error_highlight, 0, 0,
@@ -595,7 +897,7 @@ void end_game (void)
 			/* xgettext:c-format */
 			_("The winner is ^{%ls^}\n"
 			  "with a value of ^{%N^}."),
-			player[0].name, player[0].sort_value);
+			name_wcs(player[0].name), player[0].sort_value);
 
 	newtxwin(number_players + lines + 8, WIN_COLS - 4, 3, WCENTER,
 		 true, attr_normal_window);
@@ -619,7 +921,7 @@ void end_game (void)
 	    right(curwin, i + lines + 5, ORDINAL_COLS + 2, attr_normal, 0, 0,
 		  1, gettext(ordinal[i + 1]));
 	    left(curwin, i + lines + 5, ORDINAL_COLS + 4, attr_normal, 0, 0,
-		 1, "%ls", player[i].name);
+		 1, "%ls", name_wcs(player[i].name));
 	    right(curwin, i + lines + 5, w - 2, attr_normal, 0, 0,
 		  1, "  %!N  ", player[i].sort_value);
 	}
@@ -628,7 +930,7 @@ void end_game (void)
 	deltxwin();
     }
 
-    free(chbuf);
+    scratch_release(mark);
 }
 
 
@@ -647,7 +949,7 @@ void show_map (bool closewin)
 
     // Display current player and turn number
     left(curwin, 1, 4, attr_mapwin_title, attr_mapwin_highlight, 0, 1,
-	 _("Player: ^{%ls^}"), player[current_player].name);
+	 _("Player: ^{%ls^}"), name_wcs(player[current_player].name));
     right(curwin, 1, getmaxx(curwin) - 2, attr_mapwin_title,
 	  attr_mapwin_highlight, attr_mapwin_blink, 1,
 	  (turn_number != max_turn) ? _("  Turn: ^{%d^}  ") :
@@ -687,6 +989,10 @@ void show_map (bool closewin)
 
 void show_status (int num)
 {
+    static chlabel_t label_title, label_no_companies;
+    static chlabel_t label_company, label_ownership, label_holdings;
+    static chlabel_t label_return, label_price;
+
     double val;
     int w, i, line;
 
@@ -695,9 +1001,10 @@ void show_status (int num)
 
     newtxwin(MAX_COMPANIES + 15, WIN_COLS, 1, WCENTER, true,
 	     attr_normal_window);
-    center(curwin, 1, 0, attr_title, 0, 0, 1, _("  Stock Portfolio  "));
+    centerlabel(curwin, 1, 0, &label_title, attr_title, 0, 0, 1,
+		_("  Stock Portfolio  "));
     center(curwin, 2, 0, attr_normal, attr_highlight, 0, 1,
-	   _("Player: ^{%ls^}"), player[num].name);
+	   _("Player: ^{%ls^}"), name_wcs(player[num].name));
 
     val = total_value(num);
     if (val == 0.0) {
@@ -718,52 +1025,56 @@ void show_status (int num)
 	}
 
 	if (none) {
-	    center(curwin, 8, 0, attr_normal, attr_highlight, 0, 1,
-		   _("No companies on the map"));
+	    centerlabel(curwin, 8, 0, &label_no_companies, attr_normal,
+			attr_highlight, 0, 1, _("No companies on the map"));
 	} else {
 	    mvwhline(curwin, 4, 2, ' ' | attr_subtitle, w - 4);
 	    mvwhline(curwin, 5, 2, ' ' | attr_subtitle, w - 4);
 
-	    left(curwin, 4, 4, attr_subtitle, 0, 0, 2,
-		 /* TRANSLATORS: "Company" is a two-line column label in
-		    a table containing a list of companies. */
-		 pgettext("subtitle", " \nCompany"));
-	    right(curwin, 4, w - 4, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Ownership" is a two-line column label
-		     in a table containing the current player's
-		     percentage ownership in any given company.  The
-		     maximum column width is 10 characters (see
-		     OWNERSHIP_COLS in src/intf.h). */
-		  pgettext("subtitle", "Ownership\n(%%)"));
-	    right(curwin, 4, w - 6 - OWNERSHIP_COLS, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Holdings" is a two-line column label
-		     in a table containing the number of shares the
-		     current player owns in any given company.  The
-		     maximum column width is 10 characters (see
-		     STOCK_OWNED_COLS in src/intf.h). */
-		  pgettext("subtitle", "Holdings\n(shares)"));
-	    right(curwin, 4, w - 8 - OWNERSHIP_COLS - STOCK_OWNED_COLS,
-		  attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Return" is a two-line column label in
-		     a table containing the share return as a percentage
-		     in any given company.  The maximum column width is
-		     10 characters (see SHARE_RETURN_COLS in src/intf.h). */
-		  pgettext("subtitle", "Return\n(%%)"));
-	    right(curwin, 4, w - 10 - OWNERSHIP_COLS - STOCK_OWNED_COLS
-		  - SHARE_RETURN_COLS, attr_subtitle, 0, 0, 2,
-		  /* TRANSLATORS: "Price per share" is a two-line column
-		     label in a table containing the price per share in
-		     any given company.  %ls is the currency symbol in
-		     the current locale.  The maximum column width is 12
-		     characters INCLUDING the currency symbol (see
-		     SHARE_PRICE_COLS in src/intf.h). */
-		  pgettext("subtitle", "Price per\nshare (%ls)"),
-		  currency_symbol);
+	    leftlabel(curwin, 4, 4, &label_company, attr_subtitle, 0, 0, 2,
+		      /* TRANSLATORS: "Company" is a two-line column label
+			 in a table containing a list of companies. */
+		      pgettext("subtitle", " \nCompany"));
+	    rightlabel(curwin, 4, w - 4, &label_ownership, attr_subtitle, 0, 0,
+		       2,
+		       /* TRANSLATORS: "Ownership" is a two-line column
+			  label in a table containing the current player's
+			  percentage ownership in any given company.  The
+			  maximum column width is 10 characters (see
+			  OWNERSHIP_COLS in src/intf.h). */
+		       pgettext("subtitle", "Ownership\n(%%)"));
+	    rightlabel(curwin, 4, w - 6 - OWNERSHIP_COLS, &label_holdings,
+		       attr_subtitle, 0, 0, 2,
+		       /* TRANSLATORS: "Holdings" is a two-line column
+			  label in a table containing the number of shares
+			  the current player owns in any given company.
+			  The maximum column width is 10 characters (see
+			  STOCK_OWNED_COLS in src/intf.h). */
+		       pgettext("subtitle", "Holdings\n(shares)"));
+	    rightlabel(curwin, 4, w - 8 - OWNERSHIP_COLS - STOCK_OWNED_COLS,
+		       &label_return, attr_subtitle, 0, 0, 2,
+		       /* TRANSLATORS: "Return" is a two-line column label
+			  in a table containing the share return as a
+			  percentage in any given company.  The maximum
+			  column width is 10 characters (see
+			  SHARE_RETURN_COLS in src/intf.h). */
+		       pgettext("subtitle", "Return\n(%%)"));
+	    rightlabel(curwin, 4, w - 10 - OWNERSHIP_COLS - STOCK_OWNED_COLS
+		       - SHARE_RETURN_COLS, &label_price, attr_subtitle, 0, 0,
+		       2,
+		       /* TRANSLATORS: "Price per share" is a two-line
+			  column label in a table containing the price per
+			  share in any given company.  %ls is the currency
+			  symbol in the current locale.  The maximum column
+			  width is 12 characters INCLUDING the currency
+			  symbol (see SHARE_PRICE_COLS in src/intf.h). */
+		       pgettext("subtitle", "Price per\nshare (%ls)"),
+		       currency_symbol);
 
 	    for (line = 6, i = 0; i < MAX_COMPANIES; i++) {
 		if (company[i].on_map) {
 		    left(curwin, line, 4, attr_normal, 0, 0, 1, "%ls",
-			 company[i].name);
+			 name_wcs(company[i].name));
 
 		    right(curwin, line, w - 2, attr_normal, 0, 0, 1, "%.2f  ",
 			  (company[i].stock_issued == 0) ? 0.0 :
@@ -785,7 +1096,8 @@ void show_status (int num)
 
 	line = MAX_COMPANIES + 7;
 
-	chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+	scratch_mark_t mark = scratch_mark();
+	chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 	int width, x;
 
 	mkchstr(chbuf, BUFSIZE, attr_highlight, 0, 0, 1, w / 2, &width, 1,
@@ -826,7 +1138,7 @@ void show_status (int num)
 	right(curwin, line + 1, x + TOTAL_VALUE_COLS + 2, attr_title, 0, 0, 1,
 	      " %N ", val);
 
-	free(chbuf);
+	scratch_release(mark);
     }
 
     wait_for_key(curwin, getmaxy(curwin) - 2, attr_waitforkey);
@@ -880,5 +1192,30 @@ int cmp_player (const void *a, const void *b)
 }
 
 
+/***********************************************************************/
+// append_text: Append data to a buffer of names
+
+size_t append_text (char **restrict buf, size_t *restrict len,
+		    size_t *restrict size, const void *restrict data, size_t n)
+{
+    size_t off = *len;
+
+
+    if (*size - *len < n) {
+	size_t newsize = (*size == 0) ? NAME_TEXT_INITIAL : *size;
+
+	while (newsize - *len < n) {
+	    newsize *= 2;
+	}
+	*buf = xrealloc(*buf, newsize);
+	*size = newsize;
+    }
+
+    memcpy(*buf + off, data, n);
+    *len += n;
+    return off;
+}
+
+
 /***********************************************************************/
 // End of file
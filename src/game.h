@@ -62,6 +62,120 @@
 extern void init_game (void);
 
 
+/*
+  Function:   new_game - Set up the data for a new game
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function initialises the players (apart from their names), the
+  companies and the galaxy map for a new game of number_players players,
+  then selects who is to go first.  Nothing is displayed, so it may be
+  used without a terminal.  If option_max_turn contains a non-zero
+  value, it is used to initialise max_turn.
+*/
+extern void new_game (void);
+
+
+/*
+  Function:   company_wname - Return the translated name of a company
+  Parameters: num           - Company number (0 to MAX_COMPANIES - 1)
+  Returns:    wchar_t *     - Name of company num as a wide-character string
+
+  This function returns gettext(company_name[num]) converted to a
+  wide-character string.  The conversion is done only the first time;
+  the same string is returned after that, as the locale is not changed
+  once the program has started.  The string must not be modified or
+  freed.
+*/
+extern wchar_t *company_wname (int num);
+
+
+/*
+  Function:   clear_names - Empty the table of names
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function removes all names from the table kept by intern_name(),
+  so that the table does not grow from one game to the next.  It must be
+  called before the names of a new or loaded game are interned; any
+  name_ref_t value returned before then becomes invalid.
+*/
+extern void clear_names (void);
+
+
+/*
+  Function:   intern_name - Add a name to the table of names
+  Parameters: name        - Name to add
+              mbs         - Name as written to game files, or NULL
+  Returns:    name_ref_t  - Index of the name in the table
+
+  This function adds name to the table of names, unless it is there
+  already, and returns its index.  The names of players and companies
+  are kept as such indexes, so that player[] and company[] hold no
+  pointers: a copy of them made with memcpy() needs no other copying or
+  freeing.  Names are never removed from the table other than by
+  clear_names(), so the index remains valid for the rest of the game.
+  If mbs is not NULL, it is kept as the form of the name to write to
+  game files (see set_name_mbs()).
+*/
+extern name_ref_t intern_name (const wchar_t *restrict name,
+			       const char *restrict mbs);
+
+
+/*
+  Function:   name_wcs - Return a name from the table of names
+  Parameters: ref      - Index returned by intern_name()
+  Returns:    wchar_t * - Name as a wide-character string
+
+  The string returned must not be modified.  It remains valid only until
+  the next call to intern_name() or set_name_mbs(), as the table may be
+  moved in memory to make room for more names.
+*/
+extern const wchar_t *name_wcs (name_ref_t ref);
+
+
+/*
+  Function:   name_mbs - Return the form of a name written to game files
+  Parameters: ref      - Index returned by intern_name()
+  Returns:    char *   - Name as written to game files, or NULL
+
+  This function returns the multibyte form of a name, as read from or
+  last written to a game file, or NULL if it has not yet been set.  The
+  string returned is valid as described for name_wcs().
+*/
+extern const char *name_mbs (name_ref_t ref);
+
+
+/*
+  Function:   set_name_mbs - Set the form of a name written to game files
+  Parameters: ref          - Index returned by intern_name()
+              mbs          - Name as written to game files
+  Returns:    (nothing)
+
+  This function keeps a copy of mbs in the table of names, so that the
+  name need only be converted once, however often the game is saved.
+*/
+extern void set_name_mbs (name_ref_t ref, const char *restrict mbs);
+
+
+/*
+  Function:   ask_game_number - Ask for the game number
+  Parameters: saving          - True if saving a game, false if loading
+  Returns:    int             - Game number (1 to MAX_GAME_NUM) or ERR
+
+  This function lists the most recently saved games (using the index of
+  saved games, so no game file needs to be opened), then asks the user
+  which game number or name to load or save.  If loading, the default is
+  the most recently saved game; if saving, it is the next unused number.
+  A name given when saving becomes the name of the current game
+  (game_name), and is saved under its old number if a game of that name
+  already exists.  ERR is returned if the user wishes to cancel.
+
+  Please note that the window opened by this function is NOT closed!
+*/
+extern int ask_game_number (bool saving);
+
+
 /*
   Function:   end_game - Finish playing the current game
   Parameters: (none)
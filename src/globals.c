@@ -140,14 +140,29 @@ int	first_player;			// Who WAS the first player to go?
 double	interest_rate;			// Current interest rate
 
 bool	game_loaded	= false;	// True if game was loaded from disk
-int	game_num	= 0;		// Game number (1-9)
+int	game_num	= 0;		// Game number (1-MAX_GAME_NUM)
+char	*game_name	= NULL;		// Name of the saved game, or NULL
 
 bool	quit_selected	= false;	// Is a player trying to quit the game?
 bool	abort_game	= false;	// Abort game without declaring winner?
-
-bool	option_no_color     = false;	// True if --no-color was specified
-bool	option_dont_encrypt = false;	// True if --dont-encrypt was specified
-int	option_max_turn     = 0;	// Max. turns if --max-turn was specified
+bool	replaying	= false;	// Processing moves without any display?
+
+bool	option_no_color      = false;	// True if --no-color was specified
+bool	option_dont_encrypt  = false;	// True if --dont-encrypt was specified
+bool	option_file_checksum = false;	// True if --file-checksum was specified
+int	option_max_turn      = 0;	// Max. turns if --max-turn was specified
+char	*option_archive      = NULL;	// Game archive if --archive was specified
+char	*option_replay       = NULL;	// Game replay if --replay was specified
+char	*option_view_replay  = NULL;	// Game replay if --view-replay was given
+char	*option_export       = NULL;	// Export file if --export was specified
+bool	option_fast_play     = false;	// True if --fast-play was specified
+char	*option_headless     = NULL;	// Frame file if --headless was specified
+bool	option_ansi_frames   = false;	// True if --ansi-frames was specified
+char	*option_frame_bytes  = NULL;	// Byte counts if --frame-bytes was used
+bool	option_low_bandwidth = false;	// True if --low-bandwidth was specified
+char	*option_spectate     = NULL;	// Socket if --spectate was specified
+char	*option_server       = NULL;	// Address if --server was specified
+bool	option_startup_profile = false;	// True if --startup-profile was given
 
 
 /***********************************************************************/
@@ -45,6 +45,8 @@
 #define MIN_MAX_TURN		10	// Minimum that can be specified for max_turn
 
 #define MAX_PLAYERS		8	// Maximum number of players (do not change!)
+#define MAX_GAME_NUM		999999	// Maximum saved game number
+#define GAME_NAME_LEN		8	// Maximum length of a saved game name
 #define INITIAL_CASH		6000.00	// Initial cash per player
 #define MAX_OVERDRAFT		1000.00	// Maximum value any player can go negative
 #define MAKE_BANKRUPT		0.07	// If a player is overdraft, 7% chance of bankruptcy
@@ -102,9 +104,13 @@
 *                        Game type declarations                         *
 ************************************************************************/
 
+// Index of a name in the table of names kept by intern_name()
+typedef int name_ref_t;
+
+
 // Information about each company
 typedef struct company_info {
-    wchar_t	*name;			// Company name
+    name_ref_t	name;			// Company name
     double	share_price;		// Share price
     double	share_return;		// Return per share (may be negative)
     long int	stock_issued;		// Total stock sold to players
@@ -115,8 +121,7 @@ typedef struct company_info {
 
 // Information about each player
 typedef struct player_info {
-    wchar_t	*name;			// Player name
-    char	*name_utf8;		// Player name (in UTF-8, for load/save)
+    name_ref_t	name;			// Player name
     double	cash;			// Cash available
     double	debt;			// Amount of debt
     long int	stock_owned[MAX_COMPANIES];	// How much stock is owned
@@ -202,14 +207,29 @@ extern int	first_player;		// Who WAS the first player to go?
 extern double	interest_rate;		// Current interest rate
 
 extern bool	game_loaded;		// True if game was loaded from disk
-extern int	game_num;		// Game number (1-9)
+extern int	game_num;		// Game number (1-MAX_GAME_NUM)
+extern char	*game_name;		// Name of the saved game, or NULL
 
 extern bool	quit_selected;		// Is a player trying to quit the game?
 extern bool	abort_game;		// Abort game without declaring winner?
+extern bool	replaying;		// Processing moves without any display?
 
 extern bool	option_no_color;	// True if --no-color was specified
 extern bool	option_dont_encrypt;	// True if --dont-encrypt was specified
+extern bool	option_file_checksum;	// True if --file-checksum was specified
 extern int	option_max_turn;	// Max. turns if --max-turn was specified
+extern char	*option_archive;	// Game archive if --archive was specified
+extern char	*option_replay;		// Game replay if --replay was specified
+extern char	*option_view_replay;	// Game replay if --view-replay was given
+extern char	*option_export;		// Export file if --export was specified
+extern bool	option_fast_play;	// True if --fast-play was specified
+extern char	*option_headless;	// Frame file if --headless was specified
+extern bool	option_ansi_frames;	// True if --ansi-frames was specified
+extern char	*option_frame_bytes;	// Byte counts if --frame-bytes was used
+extern bool	option_low_bandwidth;	// True if --low-bandwidth was specified
+extern char	*option_spectate;	// Socket if --spectate was specified
+extern char	*option_server;		// Address if --server was specified
+extern bool	option_startup_profile;	// True if --startup-profile was given
 
 
 #endif /* included_GLOBALS_H */
@@ -0,0 +1,473 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, headless.c, contains the implementation of running Star
+  Traders without a terminal.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  Curses is still used to draw the screen, but on a screen created with
+  newterm() whose output goes to the null device, using the terminal
+  type HEADLESS_TERM and ignoring the LINES and COLUMNS environment
+  variables.  Curses keeps a copy of what would be on the terminal in
+  curscr; each frame is read from there into a grid of cells, which is
+  compared with the last frame written.  Nothing at all is written to
+  the real terminal, so games can be played by other programs, and the
+  screens they produce compared, at far more frames per second than a
+  terminal could show.
+
+  If option_frame_bytes is not NULL, the Curses output goes to a
+  temporary file instead of the null device.  The size of that file is
+  the number of bytes Curses would have sent to a real terminal of type
+  HEADLESS_TERM; it is written out and the file emptied each time a key
+  is waited for.
+
+  Text frames hold LINES lines with trailing spaces removed, each frame
+  followed by a line holding only a form feed.  Line-drawing characters
+  are written as "+", "-" and "|".  ANSI frames start by clearing the
+  screen and set the character rendition and colours of each cell, so
+  that they can be shown by simply writing them to a terminal.
+*/
+
+
+/************************************************************************
+*                 Module-specific constants and macros                  *
+************************************************************************/
+
+#define HEADLESS_TERM	"xterm"		// Terminal type to pretend to use
+#define NULL_DEVICE	"/dev/null"	// Where the Curses output goes
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static SCREEN *headless_screen = NULL;	// Screen with no terminal
+static FILE *null_out = NULL;		// Curses output (discarded or counted)
+static FILE *null_in = NULL;		// Curses input (never read)
+static FILE *frame_file = NULL;		// Frames are written here
+static FILE *bytes_file = NULL;		// Bytes sent are written here
+
+static frame_cell_t *frame = NULL;		// Screen as it is now
+static frame_cell_t *last_frame = NULL;	// Last frame written
+static bool have_last_frame = false;	// True if last_frame is valid
+static int frame_lines, frame_cols;	// Size of each frame
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   write_frame - Write frame[] to the frame file
+  Parameters: (none)
+  Returns:    (nothing)
+
+  The frame is written as text or, if option_ansi_frames is true, as
+  ANSI escape sequences.
+*/
+static void write_frame (void);
+
+
+/*
+  Function:   put_sgr - Write an ANSI Select Graphic Rendition sequence
+  Parameters: file    - File to write to
+              attr    - Curses rendition to select
+              pair    - Curses colour pair to select
+  Returns:    (nothing)
+*/
+static void put_sgr (FILE *file, chtype attr, short pair);
+
+
+/*
+  Function:   write_frame_bytes - Write the bytes sent for this frame
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function writes the number of bytes Curses has output since the
+  last call to the file named by option_frame_bytes, then empties the
+  temporary file holding that output.
+*/
+static void write_frame_bytes (void);
+
+
+/************************************************************************
+*                 Headless display function definitions                 *
+************************************************************************/
+
+/* These functions are documented either in the file "headless.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// headless_init: Initialise a screen with no terminal
+
+void headless_init (void)
+{
+    if (option_frame_bytes != NULL) {
+	null_out = tmpfile();
+	if (null_out == NULL) {
+	    errno_exit("tmpfile");
+	}
+
+	bytes_file = fopen(option_frame_bytes, "w");
+	if (bytes_file == NULL) {
+	    errno_exit("%s", option_frame_bytes);
+	}
+    } else {
+	null_out = fopen(NULL_DEVICE, "w");
+    }
+    null_in = fopen(NULL_DEVICE, "r");
+    if (null_out == NULL || null_in == NULL) {
+	errno_exit("%s", NULL_DEVICE);
+    }
+
+    // Use the size given by the terminal description, not the environment
+    use_env(false);
+
+    headless_screen = newterm(HEADLESS_TERM, null_out, null_in);
+    if (headless_screen == NULL) {
+	err_exit(_("cannot create a screen of terminal type '%s'"),
+		 HEADLESS_TERM);
+    }
+    set_term(headless_screen);
+
+    frame_file = fopen(option_headless, "w");
+    if (frame_file == NULL) {
+	errno_exit("%s", option_headless);
+    }
+
+    frame_lines = LINES;
+    frame_cols = COLS;
+    frame = xmalloc(frame_lines * frame_cols * sizeof(frame_cell_t));
+    last_frame = xmalloc(frame_lines * frame_cols * sizeof(frame_cell_t));
+    have_last_frame = false;
+}
+
+
+/***********************************************************************/
+// headless_end: Close the frame file
+
+void headless_end (void)
+{
+    if (frame_file != NULL) {
+	if (fclose(frame_file) == EOF) {
+	    frame_file = NULL;
+	    errno_exit("%s", option_headless);
+	}
+	frame_file = NULL;
+    }
+
+    if (bytes_file != NULL) {
+	if (fclose(bytes_file) == EOF) {
+	    bytes_file = NULL;
+	    errno_exit("%s", option_frame_bytes);
+	}
+	bytes_file = NULL;
+    }
+
+    if (headless_screen != NULL) {
+	delscreen(headless_screen);
+	headless_screen = NULL;
+
+	fclose(null_out);
+	fclose(null_in);
+	null_out = null_in = NULL;
+    }
+
+    free(frame);
+    free(last_frame);
+    frame = last_frame = NULL;
+}
+
+
+/***********************************************************************/
+// headless_getwch: Get a wide character from standard input
+
+int headless_getwch (wint_t *restrict wch)
+{
+    wint_t key;
+    int c;
+
+
+    // Write the screen the player now sees, if it has changed
+    read_screen(frame, frame_lines, frame_cols);
+    if (! have_last_frame || memcmp(frame, last_frame, frame_lines
+				    * frame_cols * sizeof(frame_cell_t)) != 0) {
+	write_frame();
+
+	frame_cell_t *t = last_frame;
+	last_frame = frame;
+	frame = t;
+	have_last_frame = true;
+    }
+
+    if (bytes_file != NULL) {
+	write_frame_bytes();
+    }
+
+    key = fgetwc(stdin);
+    if (key == WEOF) {
+	// No more keys: the game simply ends here
+	end_screen();
+	startup_report();
+	exit(EXIT_SUCCESS);
+    }
+
+    *wch = key;
+
+    c = wctob(key);
+    if ((c >= 0 && c < ' ') || c == 0x7F) {
+	// Make control characters appear to be function keys, as in getwch()
+	*wch = (wint_t) c;
+	return KEY_CODE_YES;
+    }
+
+    return OK;
+}
+
+
+/***********************************************************************/
+// read_screen: Copy the screen into an array of cells
+
+void read_screen (frame_cell_t *restrict frame, int lines, int cols)
+{
+    // Clear the whole of each cell, as frames are compared by memcmp()
+    memset(frame, 0, lines * cols * sizeof(frame_cell_t));
+
+    for (int y = 0; y < lines; y++) {
+	for (int x = 0; x < cols; x++) {
+	    frame_cell_t *cp = &frame[y * cols + x];
+
+#if defined(HAVE_CURSES_ENHANCED) || defined(HAVE_NCURSESW)
+	    cchar_t cc;
+	    wchar_t wcs[CCHARW_MAX + 1];
+	    attr_t attr;
+	    short pair;
+
+	    mvwin_wch(curscr, y, x, &cc);
+	    if (getcchar(&cc, wcs, &attr, &pair, NULL) == ERR) {
+		wcs[0] = L' ';
+		attr = A_NORMAL;
+		pair = 0;
+	    }
+	    cp->ch = wcs[0];
+	    cp->attr = attr & (A_ATTRIBUTES & ~A_COLOR);
+	    cp->pair = pair;
+#else
+	    chtype ch = mvwinch(curscr, y, x);
+
+	    cp->ch = (unsigned char) (ch & A_CHARTEXT);
+	    cp->attr = ch & (A_ATTRIBUTES & ~A_COLOR);
+	    cp->pair = PAIR_NUMBER(ch);
+#endif
+
+	    // Show line-drawing characters using ASCII
+	    if (cp->attr & A_ALTCHARSET) {
+		cp->attr &= ~A_ALTCHARSET;
+		switch (cp->ch) {
+		case L'q':
+		    cp->ch = L'-';
+		    break;
+
+		case L'x':
+		    cp->ch = L'|';
+		    break;
+
+		case L'j':
+		case L'k':
+		case L'l':
+		case L'm':
+		case L'n':
+		case L't':
+		case L'u':
+		case L'v':
+		case L'w':
+		    cp->ch = L'+';
+		    break;
+
+		default:
+		    cp->ch = L'#';
+		}
+	    }
+
+	    if (cp->ch == L'\0') {
+		cp->ch = L' ';
+	    }
+	}
+    }
+}
+
+
+/***********************************************************************/
+// write_ansi_line: Write a line of cells as ANSI escape sequences
+
+void write_ansi_line (FILE *restrict file, const frame_cell_t *restrict line,
+		      int cols)
+{
+    bool skip = false;
+
+
+    for (int x = 0; x < cols; x++) {
+	if (skip) {
+	    // Second column of a double-width character
+	    skip = false;
+	    continue;
+	}
+
+	if (x == 0 || line[x].attr != line[x - 1].attr
+	    || line[x].pair != line[x - 1].pair) {
+	    put_sgr(file, line[x].attr, line[x].pair);
+	}
+
+	fprintf(file, "%lc", (wint_t) line[x].ch);
+	skip = (wcwidth(line[x].ch) > 1);
+    }
+
+    fputs("\033[0m", file);
+}
+
+
+/***********************************************************************/
+// write_frame: Write frame[] to the frame file
+
+void write_frame (void)
+{
+    bool ansi = option_ansi_frames;
+
+
+    if (ansi) {
+	fputs("\033[H\033[2J", frame_file);
+    }
+
+    for (int y = 0; y < frame_lines; y++) {
+	const frame_cell_t *line = &frame[y * frame_cols];
+
+	if (ansi) {
+	    write_ansi_line(frame_file, line, frame_cols);
+	} else {
+	    int len = frame_cols;
+	    bool skip = false;
+
+	    // Leave out trailing spaces
+	    while (len > 0 && line[len - 1].ch == L' ') {
+		len--;
+	    }
+
+	    for (int x = 0; x < len; x++) {
+		if (skip) {
+		    // Second column of a double-width character
+		    skip = false;
+		    continue;
+		}
+
+		fprintf(frame_file, "%lc", (wint_t) line[x].ch);
+		skip = (wcwidth(line[x].ch) > 1);
+	    }
+	}
+
+	fputc('\n', frame_file);
+    }
+
+    if (! ansi) {
+	fputs("\f\n", frame_file);
+    }
+
+    if (ferror(frame_file)) {
+	errno_exit("%s", option_headless);
+    }
+}
+
+
+/***********************************************************************/
+// write_frame_bytes: Write the bytes sent for this frame
+
+void write_frame_bytes (void)
+{
+    int fd = fileno(null_out);
+    struct stat statbuf;
+
+
+    // Curses may write to the file descriptor directly, not via null_out
+    if (fflush(null_out) == EOF || fstat(fd, &statbuf) != 0) {
+	errno_exit("fstat");
+    }
+
+    fprintf(bytes_file, "%" PRIdMAX "\n", (intmax_t) statbuf.st_size);
+    if (ferror(bytes_file)) {
+	errno_exit("%s", option_frame_bytes);
+    }
+
+    if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) == -1) {
+	errno_exit("ftruncate");
+    }
+}
+
+
+/***********************************************************************/
+// put_sgr: Write an ANSI Select Graphic Rendition sequence
+
+void put_sgr (FILE *file, chtype attr, short pair)
+{
+    short fg, bg;
+
+
+    fputs("\033[0", file);
+
+    if (attr & A_BOLD) {
+	fputs(";1", file);
+    }
+    if (attr & A_DIM) {
+	fputs(";2", file);
+    }
+    if (attr & A_UNDERLINE) {
+	fputs(";4", file);
+    }
+    if (attr & A_BLINK) {
+	fputs(";5", file);
+    }
+    if (attr & A_REVERSE) {
+	fputs(";7", file);
+    }
+
+    if (pair > 0 && pair_content(pair, &fg, &bg) == OK) {
+	if (fg >= 0 && fg < 8) {
+	    fprintf(file, ";%d", 30 + fg);
+	}
+	if (bg >= 0 && bg < 8) {
+	    fprintf(file, ";%d", 40 + bg);
+	}
+    }
+
+    fputc('m', file);
+}
+
+
+/***********************************************************************/
+// End of file
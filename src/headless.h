@@ -0,0 +1,129 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, headless.h, contains declarations for running Star Traders
+  without a terminal.  The screen is kept only in memory, keys are read
+  from standard input, and each screen shown while waiting for a key is
+  written to a file as a frame of plain text or of ANSI escape
+  sequences (if option_ansi_frames is true).
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_HEADLESS_H
+#define included_HEADLESS_H 1
+
+
+/************************************************************************
+*                 Headless display types and structures                 *
+************************************************************************/
+
+// One character cell of the screen, as read by read_screen()
+typedef struct frame_cell {
+    wchar_t		ch;		// Character in the cell
+    chtype		attr;		// Rendition, without colour or char
+    short		pair;		// Colour pair
+} frame_cell_t;
+
+
+/************************************************************************
+*                 Headless display function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   headless_init - Initialise a screen with no terminal
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function is called by init_screen() in place of initscr() if
+  option_headless is not NULL.  It creates a Curses screen of MIN_LINES
+  by MIN_COLS whose output is discarded (or counted, if
+  option_frame_bytes is not NULL), and opens the frame file named by
+  option_headless.  On any error, the program is terminated with an
+  appropriate message.
+*/
+extern void headless_init (void);
+
+
+/*
+  Function:   headless_end - Close the frame file
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function is called by end_screen() to close the frame file and
+  the file named by option_frame_bytes, if they are open.
+*/
+extern void headless_end (void);
+
+
+/*
+  Function:   headless_getwch - Get a wide character from standard input
+  Parameters: wch             - Pointer to wide character result
+  Returns:    int             - OK or KEY_CODE_YES
+
+  This function is used by the input functions in place of reading the
+  keyboard if option_headless is not NULL.  It first writes the screen
+  as it is now to the frame file, unless it is the same as the last
+  frame written, then reads the next character from standard input.  If
+  option_frame_bytes is not NULL, the number of bytes Curses has output
+  since the last call is also written to that file, one per line.
+  Control characters are returned as if they were function keys, as by
+  gettxchar(); function keys themselves cannot be given.  If standard
+  input is at its end, the program ends.
+*/
+extern int headless_getwch (wint_t *restrict wch);
+
+
+/*
+  Function:   read_screen - Copy the screen into an array of cells
+  Parameters: frame       - Array of lines * cols cells (output)
+              lines       - Number of lines to copy
+              cols        - Number of columns in each line
+  Returns:    (nothing)
+
+  This function copies what is on the screen, as last updated by
+  doupdate(), into frame, line by line.  Each cell is cleared first, so
+  that two frames may be compared with memcmp().  Line-drawing characters
+  are replaced by "+", "-" and "|".  It may be used with any screen, not
+  just one created by headless_init().
+*/
+extern void read_screen (frame_cell_t *restrict frame, int lines, int cols);
+
+
+/*
+  Function:   write_ansi_line - Write a line of cells as ANSI sequences
+  Parameters: file            - File to write to
+              line            - Cells of the line
+              cols            - Number of cells in line
+  Returns:    (nothing)
+
+  This function writes line to file, selecting the character rendition
+  and colours of each cell with ANSI Select Graphic Rendition sequences.
+  The rendition is reset at the end of the line; no newline is written.
+*/
+extern void write_ansi_line (FILE *restrict file,
+			     const frame_cell_t *restrict line, int cols);
+
+
+#endif /* included_HEADLESS_H */
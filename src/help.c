@@ -230,6 +230,33 @@ static const char *help_text[HELP_TEXT_PAGES] = {
 };
 
 
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static int help_numpages = -1;		// Pages of help text, once counted
+static chtype *help_page[HELP_TEXT_PAGES]; // Each page, once formatted
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   format_help_page - Format a page of help text
+  Parameters: text             - Page of help text, already translated
+  Returns:    chtype *         - Formatted page (allocated with malloc())
+
+  This function interprets the circumflex accent and tilde escapes in
+  text, as described above, returning a string of chtype characters
+  ready to be displayed with waddch(): each character is converted to
+  its multibyte sequence in the current locale, and each line ends with
+  "\n".  As the attributes and map characters do not change once the
+  screen has been initialised, each page need only be formatted once.
+*/
+static chtype *format_help_page (const char *text);
+
+
 /************************************************************************
 *                     Help text function definition                     *
 ************************************************************************/
@@ -242,29 +269,23 @@ static const char *help_text[HELP_TEXT_PAGES] = {
 
 void show_help (void)
 {
-    wchar_t *wchelp_text[HELP_TEXT_PAGES];
-    wchar_t *wcbuf = xmalloc(BIGBUFSIZE * sizeof(wchar_t));
-    chtype *outbuf = xmalloc(BIGBUFSIZE * sizeof(chtype));
-
     int curpage = 0;
-    int numpages = 0;
     bool done = false;
 
 
     // Count how many pages appear in the (translated) help text
-    while (numpages < HELP_TEXT_PAGES) {
-	const char *s = gettext(help_text[numpages]);
-	if (s == NULL || *s == '\0' || *s == '@')
-	    break;
+    if (help_numpages < 0) {
+	help_numpages = 0;
+	while (help_numpages < HELP_TEXT_PAGES) {
+	    const char *s = gettext(help_text[help_numpages]);
+	    if (s == NULL || *s == '\0' || *s == '@')
+		break;
 
-	xmbstowcs(wcbuf, s, BIGBUFSIZE);
-	wchelp_text[numpages] = xwcsdup(wcbuf);
-	numpages++;
+	    help_numpages++;
+	}
     }
 
-    if (numpages == 0) {
-	free(outbuf);
-	free(wcbuf);
+    if (help_numpages == 0) {
 	return;
     }
 
@@ -282,199 +303,16 @@ void show_help (void)
 	       /* TRANSLATORS: The parameter %1$d is the current page
 		  number, %2$d is the number of pages your help text
 		  takes (6, in English). */
-	       _("Page %1$d of %2$d"), curpage + 1, numpages);
+	       _("Page %1$d of %2$d"), curpage + 1, help_numpages);
 	wmove(curwin, 4, 2);
 
-	// Process the help text string
-
-	const wchar_t *htxt = wchelp_text[curpage];
-	char convbuf[MB_LEN_MAX + 1];
-	char *cp;
-	mbstate_t mbstate;
-	chtype *outp;
-	size_t i, n;
-
-	int count = BIGBUFSIZE;
-	int maxchar = MB_CUR_MAX;
-	int curattr = attr_normal;
-
-	memset(&mbstate, 0, sizeof(mbstate));
-	outp = outbuf;
-
-	while (*htxt != L'\0' && count > maxchar * 2) {
-	    switch (*htxt) {
-	    case L'\n':
-		// Start a new line
-		*outp++ = '\n';
-		count--;
-		break;
-
-	    case L'^':
-		// Switch to a different character rendition
-		switch (*++htxt) {
-		case L'^':
-		    wcbuf[0] = *htxt;
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'N':
-		    curattr = attr_normal;
-		    break;
-
-		case L'B':
-		    curattr = attr_normal | A_BOLD;
-		    break;
-
-		case L'H':
-		    curattr = attr_highlight;
-		    break;
-
-		case L'K':
-		    curattr = attr_keycode;
-		    break;
-
-		case L'e':
-		    curattr = attr_map_empty;
-		    break;
-
-		case L'o':
-		    curattr = attr_map_outpost;
-		    break;
-
-		case L's':
-		    curattr = attr_map_star;
-		    break;
-
-		case L'c':
-		    curattr = attr_map_company;
-		    break;
-
-		case L'k':
-		    curattr = attr_map_choice;
-		    break;
-
-		default:
-		    wcbuf[0] = L'^';
-		    wcbuf[1] = *htxt;
-		    wcbuf[2] = L'\0';
-		    goto addwcbuf;
-		}
-		break;
-
-	    case L'~':
-		// Print a global constant
-		switch (*++htxt) {
-		case L'~':
-		    wcbuf[0] = *htxt;
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'x':
-		    swprintf(wcbuf, BIGBUFSIZE, L"%2d", MAX_X);
-		    goto addwcbuf;
-
-		case L'y':
-		    swprintf(wcbuf, BIGBUFSIZE, L"%2d", MAX_Y);
-		    goto addwcbuf;
-
-		case L'm':
-		    swprintf(wcbuf, BIGBUFSIZE, L"%2d", NUMBER_MOVES);
-		    goto addwcbuf;
-
-		case L'c':
-		    swprintf(wcbuf, BIGBUFSIZE, L"%d", MAX_COMPANIES);
-		    goto addwcbuf;
-
-		case L't':
-		    swprintf(wcbuf, BIGBUFSIZE, L"%2d", DEFAULT_MAX_TURN);
-		    goto addwcbuf;
-
-		case L'1':
-		case L'2':
-		case L'3':
-		case L'4':
-		case L'5':
-		case L'6':
-		case L'7':
-		case L'8':
-		case L'9':
-		    // N-th choice of move, as a key press
-		    wcbuf[0] = PRINTABLE_GAME_MOVE(*htxt - L'1');
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'M':
-		    // Last choice of move, as a key press
-		    wcbuf[0] = PRINTABLE_GAME_MOVE(NUMBER_MOVES - 1);
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'.':
-		    // Map representation of empty space
-		    wcbuf[0] = PRINTABLE_MAP_VAL(MAP_EMPTY);
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'+':
-		    // Map representation of an outpost
-		    wcbuf[0] = PRINTABLE_MAP_VAL(MAP_OUTPOST);
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'*':
-		    // Map representation of a star
-		    wcbuf[0] = PRINTABLE_MAP_VAL(MAP_STAR);
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		case L'A':
-		case L'B':
-		case L'C':
-		case L'D':
-		case L'E':
-		case L'F':
-		case L'G':
-		case L'H':
-		    // Map representation of company
-		    assert((*htxt - L'A') < MAX_COMPANIES);
-		    wcbuf[0] = PRINTABLE_MAP_VAL(COMPANY_TO_MAP(*htxt - L'A'));
-		    wcbuf[1] = L'\0';
-		    goto addwcbuf;
-
-		default:
-		    wcbuf[0] = L'~';
-		    wcbuf[1] = *htxt;
-		    wcbuf[2] = L'\0';
-		    goto addwcbuf;
-		}
-		break;
-
-	    default:
-		// Print the character
-		wcbuf[0] = *htxt;
-		wcbuf[1] = L'\0';
-
-	    addwcbuf:
-		for (wchar_t *p = wcbuf; *p != L'\0' && count > maxchar * 2; p++) {
-		    n = xwcrtomb(convbuf, *p, &mbstate);
-		    for (i = 0, cp = convbuf; i < n; i++, cp++, outp++, count--) {
-			*outp = (unsigned char) *cp | curattr;
-		    }
-		}
-	    }
-
-	    htxt++;
+	// Format the page the first time it is shown
+	if (help_page[curpage] == NULL) {
+	    help_page[curpage] = format_help_page(gettext(help_text[curpage]));
 	}
 
-	// Add the terminating NUL (possibly with a preceding shift sequence)
-	n = xwcrtomb(convbuf, L'\0', &mbstate);
-	for (i = 0, cp = convbuf; i < n; i++, cp++, outp++, count--) {
-	    *outp = (unsigned char) *cp;
-	}
-	assert(count >= 0);
-
-	// Display the formatted text in outbuf
-	for (outp = outbuf; *outp != 0; outp++) {
+	// Display the formatted text
+	for (const chtype *outp = help_page[curpage]; *outp != 0; outp++) {
 	    if (*outp == '\n') {
 		wmove(curwin, getcury(curwin) + 1, 2);
 	    } else {
@@ -499,7 +337,7 @@ void show_help (void)
 	if (gettxchar(curwin, &key) == OK) {
 	    // Ordinary wide character
 	    curpage++;
-	    done = (curpage == numpages);
+	    done = (curpage == help_numpages);
 	} else {
 	    // Function or control character
 	    switch (key) {
@@ -528,17 +366,226 @@ void show_help (void)
 
 	    default:
 		curpage++;
-		done = (curpage == numpages);
+		done = (curpage == help_numpages);
 	    }
 	}
     }
 
     deltxwin();
     txrefresh();
+}
+
+
+/************************************************************************
+*                 Module-specific function definitions                  *
+************************************************************************/
+
+// This function is documented at the start of this file
+
+
+/***********************************************************************/
+// format_help_page: Format a page of help text
+
+chtype *format_help_page (const char *text)
+{
+    wchar_t *wctext = xmalloc(BIGBUFSIZE * sizeof(wchar_t));
+    wchar_t *wcbuf = xmalloc(BIGBUFSIZE * sizeof(wchar_t));
+    chtype *outbuf = xmalloc(BIGBUFSIZE * sizeof(chtype));
+    chtype *result;
+
+    const wchar_t *htxt = wctext;
+    char convbuf[MB_LEN_MAX + 1];
+    char *cp;
+    mbstate_t mbstate;
+    chtype *outp;
+    size_t i, n;
+
+    int count = BIGBUFSIZE;
+    int maxchar = MB_CUR_MAX;
+    int curattr = attr_normal;
+
 
-    for (curpage = 0; curpage < numpages; curpage++) {
-	free(wchelp_text[curpage]);
+    xmbstowcs(wctext, text, BIGBUFSIZE);
+
+    memset(&mbstate, 0, sizeof(mbstate));
+    outp = outbuf;
+
+    while (*htxt != L'\0' && count > maxchar * 2) {
+	switch (*htxt) {
+	case L'\n':
+	    // Start a new line
+	    *outp++ = '\n';
+	    count--;
+	    break;
+
+	case L'^':
+	    // Switch to a different character rendition
+	    switch (*++htxt) {
+	    case L'^':
+		wcbuf[0] = *htxt;
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'N':
+		curattr = attr_normal;
+		break;
+
+	    case L'B':
+		curattr = attr_normal | A_BOLD;
+		break;
+
+	    case L'H':
+		curattr = attr_highlight;
+		break;
+
+	    case L'K':
+		curattr = attr_keycode;
+		break;
+
+	    case L'e':
+		curattr = attr_map_empty;
+		break;
+
+	    case L'o':
+		curattr = attr_map_outpost;
+		break;
+
+	    case L's':
+		curattr = attr_map_star;
+		break;
+
+	    case L'c':
+		curattr = attr_map_company;
+		break;
+
+	    case L'k':
+		curattr = attr_map_choice;
+		break;
+
+	    default:
+		wcbuf[0] = L'^';
+		wcbuf[1] = *htxt;
+		wcbuf[2] = L'\0';
+		goto addwcbuf;
+	    }
+	    break;
+
+	case L'~':
+	    // Print a global constant
+	    switch (*++htxt) {
+	    case L'~':
+		wcbuf[0] = *htxt;
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'x':
+		swprintf(wcbuf, BIGBUFSIZE, L"%2d", MAX_X);
+		goto addwcbuf;
+
+	    case L'y':
+		swprintf(wcbuf, BIGBUFSIZE, L"%2d", MAX_Y);
+		goto addwcbuf;
+
+	    case L'm':
+		swprintf(wcbuf, BIGBUFSIZE, L"%2d", NUMBER_MOVES);
+		goto addwcbuf;
+
+	    case L'c':
+		swprintf(wcbuf, BIGBUFSIZE, L"%d", MAX_COMPANIES);
+		goto addwcbuf;
+
+	    case L't':
+		swprintf(wcbuf, BIGBUFSIZE, L"%2d", DEFAULT_MAX_TURN);
+		goto addwcbuf;
+
+	    case L'1':
+	    case L'2':
+	    case L'3':
+	    case L'4':
+	    case L'5':
+	    case L'6':
+	    case L'7':
+	    case L'8':
+	    case L'9':
+		// N-th choice of move, as a key press
+		wcbuf[0] = PRINTABLE_GAME_MOVE(*htxt - L'1');
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'M':
+		// Last choice of move, as a key press
+		wcbuf[0] = PRINTABLE_GAME_MOVE(NUMBER_MOVES - 1);
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'.':
+		// Map representation of empty space
+		wcbuf[0] = PRINTABLE_MAP_VAL(MAP_EMPTY);
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'+':
+		// Map representation of an outpost
+		wcbuf[0] = PRINTABLE_MAP_VAL(MAP_OUTPOST);
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'*':
+		// Map representation of a star
+		wcbuf[0] = PRINTABLE_MAP_VAL(MAP_STAR);
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    case L'A':
+	    case L'B':
+	    case L'C':
+	    case L'D':
+	    case L'E':
+	    case L'F':
+	    case L'G':
+	    case L'H':
+		// Map representation of company
+		assert((*htxt - L'A') < MAX_COMPANIES);
+		wcbuf[0] = PRINTABLE_MAP_VAL(COMPANY_TO_MAP(*htxt - L'A'));
+		wcbuf[1] = L'\0';
+		goto addwcbuf;
+
+	    default:
+		wcbuf[0] = L'~';
+		wcbuf[1] = *htxt;
+		wcbuf[2] = L'\0';
+		goto addwcbuf;
+	    }
+	    break;
+
+	default:
+	    // Print the character
+	    wcbuf[0] = *htxt;
+	    wcbuf[1] = L'\0';
+
+	addwcbuf:
+	    for (wchar_t *p = wcbuf; *p != L'\0' && count > maxchar * 2; p++) {
+		n = xwcrtomb(convbuf, *p, &mbstate);
+		for (i = 0, cp = convbuf; i < n; i++, cp++, outp++, count--) {
+		    *outp = (unsigned char) *cp | curattr;
+		}
+	    }
+	}
+
+	htxt++;
     }
+
+    // Add the terminating NUL (possibly with a preceding shift sequence)
+    n = xwcrtomb(convbuf, L'\0', &mbstate);
+    for (i = 0, cp = convbuf; i < n; i++, cp++, outp++, count--) {
+	*outp = (unsigned char) *cp;
+    }
+    assert(count >= 0);
+
+    result = xchstrdup(outbuf);
+
     free(outbuf);
     free(wcbuf);
+    free(wctext);
+    return result;
 }
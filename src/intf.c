@@ -91,10 +91,15 @@ chtype	*chtype_game_move[NUMBER_MOVES];	// as chtype strings
 *        Module-specific constants, type declarations and macros        *
 ************************************************************************/
 
+#define MAX_TXWINS	16		// Maximum depth of the window stack
+#define WINPOOL_SIZE	8		// Deleted windows kept for reuse
+
 typedef struct txwin {
     WINDOW		*win;		// Pointer to window structure
-    struct txwin	*next;		// Next window in stack
-    struct txwin	*prev;		// Previous window in stack
+    int			begin_y;	// Screen position of the window
+    int			begin_x;
+    int			nlines;		// Size of the window
+    int			ncols;
 } txwin_t;
 
 
@@ -114,7 +119,7 @@ typedef struct txwin {
 	(_var)[_checkpos] = L'\0';					\
     } while (0)
 
-#define init_game_chstr(_chvar, _var, _attr, _err)			\
+#define init_game_chstr(_chvar, _var, _attr, _spattr, _err)		\
     do {								\
 	chtype *p = chbuf;						\
 	wchar_t c;							\
@@ -136,7 +141,7 @@ typedef struct txwin {
 	if (w == 1) {							\
 	    n = xwcrtomb(convbuf, L' ', &mbstate);			\
 	    for (int i = 0; i < n; i++) {				\
-		*p++ = (unsigned char) convbuf[i] | attr_map_empty;	\
+		*p++ = (unsigned char) convbuf[i] | (_spattr);		\
 	    }								\
 	}								\
 									\
@@ -192,12 +197,46 @@ struct convspec {
 };
 
 
+// Cache of format strings already parsed by mkchstr_parse()
+
+#define FMTCACHE_SIZE	256	// Number of entries (a power of two)
+#define FMTCACHE_PROBES	8	// Entries tried before one is replaced
+
+struct parsedfmt {
+    const char		*format;	// Format string as passed to mkchstr()
+    char		*format_copy;	// Copy, in case format is reused
+    wchar_t		*wcformat;	// Format as a wide-character string
+    int			num_args;	// Number of variable arguments
+    struct argument	format_arg[MAXFMTARGS];	  // Argument types only
+    struct convspec	format_spec[MAXFMTSPECS]; // Conversion specifiers
+};
+
+
 /************************************************************************
 *                       Module-specific variables                       *
 ************************************************************************/
 
-txwin_t *topwin   = NULL;	// Top-most txwin structure
-txwin_t *firstwin = NULL;	// First (bottom-most) txwin structure
+// The stack of windows, from the bottom-most (txstack[0]) to the
+// top-most (txstack[txdepth - 1])
+static txwin_t txstack[MAX_TXWINS];
+static int txdepth = 0;
+
+// Windows that have been deleted, kept to be used again by newtxwin()
+static WINDOW *winpool[WINPOOL_SIZE];
+static int winpool_count = 0;
+
+// Area of the screen uncovered since the last txrefresh(), as lines and
+// columns from damage_top/left up to (but not including) bottom/right
+static int damage_top    = 0;
+static int damage_left   = 0;
+static int damage_bottom = 0;
+static int damage_right  = 0;
+
+// True if txrefresh() has left doupdate() to the next keyboard read
+static bool refresh_pending = false;
+
+// Parsed format strings, indexed by a hash of the format pointer
+static struct parsedfmt *fmtcache[FMTCACHE_SIZE];
 
 
 /************************************************************************
@@ -227,6 +266,39 @@ static void init_title (void);
 static void sigterm_handler (int sig);
 
 
+/*
+  Function:   txdamage - Mark an area of the screen as needing repainting
+  Parameters: begin_y  - Top line of the area
+              begin_x  - Left-most column of the area
+              nlines   - Number of lines in the area
+              ncols    - Number of columns in the area
+  Returns:    (nothing)
+
+  This function adds the given area to the part of the screen that must
+  be repainted by the next call to txrefresh(), typically because a
+  window covering it has been deleted.
+*/
+static void txdamage (int begin_y, int begin_x, int nlines, int ncols);
+
+
+/*
+  Function:   txrepaint - Refresh one window for txrefresh()
+  Parameters: win       - Window to refresh
+              begin_y   - Screen position of the window (line)
+              begin_x   - Screen position of the window (column)
+              nlines    - Number of lines in the window
+              ncols     - Number of columns in the window
+  Returns:    (nothing)
+
+  This internal function touches those lines of win that lie in the
+  damaged area of the screen, then copies win to the virtual screen
+  using wnoutrefresh().  If win had changes of its own, its area is
+  added to the damaged area so that windows above it are repainted.
+*/
+static void txrepaint (WINDOW *win, int begin_y, int begin_x, int nlines,
+		       int ncols);
+
+
 /*
   Function:   txresize - Handle a terminal resize event
   Parameters: (none)
@@ -240,20 +312,57 @@ static void txresize (void);
 #endif
 
 
+/*
+  Function:   mkchstr_lookup - Return the parsed format string for mkchstr()
+  Parameters: format         - Format string as passed to mkchstr()
+  Returns:    struct parsedfmt * - Parsed format, or NULL on error (with
+                                   errno set)
+
+  This helper function returns format converted to a wide-character
+  string and parsed by mkchstr_parse().  The result is kept in a cache
+  indexed by the format pointer, as the same (translated) format strings
+  are used every time a window is drawn.  A copy of the format string is
+  kept and compared as well, so a buffer reused for different formats is
+  handled correctly.  The locale is not changed once the screen has been
+  initialised, so it need not form part of the key.
+
+  Format strings that are literals often lie within a few bytes of each
+  other, and so hash to the same entry: "%ls" and "%lc", for example,
+  are used alternately for every line of the Stock Exchange.  The
+  following FMTCACHE_PROBES entries are therefore tried as well, and an
+  entry is only replaced if all of them are in use.
+*/
+static const struct parsedfmt *mkchstr_lookup (const char *restrict format);
+
+
 /*
   Function:   mkchstr_parse - Parse the format string for mkchstr()
   Parameters: format        - Format string as described for mkchstr()
               format_arg    - Pointer to variable arguments array
               format_spec   - Pointer to conversion specifiers array
-              args          - Variable argument list passed to mkchstr()
-  Returns:    int           - 0 if OK, -1 if error (with errno set)
+  Returns:    int           - Number of arguments, or -1 if error (with
+                              errno set)
 
   This helper function parses the format string passed to mkchstr(),
-  setting the format_arg and format_spec arrays appropriately.
+  setting the format_spec array and the types in the format_arg array
+  appropriately.
 */
 static int mkchstr_parse (const wchar_t *restrict format,
 			  struct argument *restrict format_arg,
-			  struct convspec *restrict format_spec,
+			  struct convspec *restrict format_spec);
+
+
+/*
+  Function:   mkchstr_args - Fetch the variable arguments for mkchstr()
+  Parameters: format_arg   - Pointer to variable arguments array
+              num_args     - Number of arguments, from mkchstr_parse()
+              args         - Variable argument list passed to mkchstr()
+  Returns:    (nothing)
+
+  This helper function fetches each argument in args according to the
+  type set in format_arg[] by mkchstr_parse().
+*/
+static void mkchstr_args (struct argument *restrict format_arg, int num_args,
 			  va_list args);
 
 
@@ -309,6 +418,27 @@ static void mkchstr_conv (chtype *restrict chbuf, int chbufsize,
 			  wchar_t *restrict wcbuf, chtype *restrict attrbuf);
 
 
+/*
+  Function:   mklabel   - Prepare a static label if not already done
+  Parameters: label     - Label to prepare
+              attr_norm - Normal character rendition to use
+              attr_alt1 - First alternate character rendition to use
+              attr_alt2 - Second alternate character rendition to use
+              maxlines  - Maximum number of screen lines to use
+              maxwidth  - Maximum width of each line, in column positions
+              format    - Format string as described for mkchstr()
+              args      - Variable argument list
+  Returns:    (nothing)
+
+  This internal function prepares the chtype string for label using
+  vmkchstr(), unless that has already been done.  The string is copied
+  to the heap and is never freed.
+*/
+static void mklabel (chlabel_t *restrict label, chtype attr_norm,
+		     chtype attr_alt1, chtype attr_alt2, int maxlines,
+		     int maxwidth, const char *restrict format, va_list args);
+
+
 /*
   Function:   getwch - Get a wide character from the keyboard
   Parameters: win    - Window to use (should be curwin)
@@ -321,11 +451,27 @@ static void mkchstr_conv (chtype *restrict chbuf, int chbufsize,
   error.
 
   This function is either a wrapper (with modifications) for wget_wch()
-  from Curses, or an implementation of that function using wgetch().
+  from Curses, or an implementation of that function using wgetch().  If
+  option_headless is not NULL, headless_getwch() is used instead.  If
+  option_spectate is not NULL, spectate_update() is called first.
 */
 static int getwch (WINDOW *win, wint_t *restrict wch);
 
 
+/*
+  Function:   waitwch - Wait for a wide character from the keyboard
+  Parameters: win     - Window to use (should be curwin)
+              wch     - Pointer to wide character result
+  Returns:    int     - OK, KEY_CODE_YES or ERR
+
+  This internal function is the same as getwch(), except that win must
+  not have a timeout set.  If option_spectate is not NULL, spectators
+  are sent any changes to the screen every SPECTATE_POLL_TIME ms while
+  the key is waited for.
+*/
+static int waitwch (WINDOW *win, wint_t *restrict wch);
+
+
 /*
   Function:   cpos_end - Adjust cpos and st for printing the ending part of buf
   Parameters: buf      - Pointer to current editing buffer
@@ -428,8 +574,13 @@ void init_screen (void)
 	errno_exit("sigaction(SIGQUIT)");
     }
 
-    // Initialise the screen
-    initscr();
+    // Initialise the screen, which may have no terminal
+    if (option_headless != NULL) {
+	headless_init();
+    } else {
+	initscr();
+    }
+    startup_mark("initialising the terminal");
 
     if (COLS < MIN_COLS || LINES < MIN_LINES) {
 	err_exit(_("terminal size is too small (%d x %d required)"),
@@ -438,8 +589,8 @@ void init_screen (void)
 
     // Initialise variables controlling the stack of windows
     curwin = stdscr;
-    topwin = NULL;
-    firstwin = NULL;
+    txdepth = 0;
+    winpool_count = 0;
 
     noecho();
     curs_set(CURS_OFF);
@@ -530,8 +681,11 @@ void init_screen (void)
 	attr_error_waitforkey = A_REVERSE;
     }
 
+    startup_mark("initialising colours and renditions");
+
     init_title();
     refresh();
+    startup_mark("drawing the title");
 
     /* Initialise strings used for keycode input and map representations.
 
@@ -554,29 +708,41 @@ void init_screen (void)
     init_game_str(printable_game_move, default_printable_game_move, NUMBER_MOVES);
 
     /* To save time later, convert each output character to its own
-       chtype string, with appropriate attributes. */
+       chtype string, with appropriate attributes.  The space following
+       each narrow character normally uses attr_map_empty.  With
+       --low-bandwidth, it uses the same rendition as the character
+       itself, as the background of map values is the same as that of
+       empty space: this saves changing the rendition twice for every
+       star, outpost and company shown on the map. */
 
     init_game_chstr(chtype_map_val[MAP_TO_INDEX(MAP_EMPTY)],
 		    printable_map_val[MAP_TO_INDEX(MAP_EMPTY)],
-		    attr_map_empty, MAP_EMPTY);
+		    attr_map_empty, attr_map_empty, MAP_EMPTY);
     init_game_chstr(chtype_map_val[MAP_TO_INDEX(MAP_OUTPOST)],
 		    printable_map_val[MAP_TO_INDEX(MAP_OUTPOST)],
-		    attr_map_outpost, MAP_OUTPOST);
+		    attr_map_outpost, option_low_bandwidth ?
+		    attr_map_outpost : attr_map_empty, MAP_OUTPOST);
     init_game_chstr(chtype_map_val[MAP_TO_INDEX(MAP_STAR)],
 		    printable_map_val[MAP_TO_INDEX(MAP_STAR)],
-		    attr_map_star, MAP_STAR);
+		    attr_map_star, option_low_bandwidth ?
+		    attr_map_star : attr_map_empty, MAP_STAR);
     for (int i = 0; i < MAX_COMPANIES; i++) {
 	init_game_chstr(chtype_map_val[MAP_TO_INDEX(COMPANY_TO_MAP(i))],
 			printable_map_val[MAP_TO_INDEX(COMPANY_TO_MAP(i))],
-			attr_map_company, COMPANY_TO_MAP(i));
+			attr_map_company, option_low_bandwidth ?
+			attr_map_company : attr_map_empty, COMPANY_TO_MAP(i));
     }
 
     for (int i = 0; i < NUMBER_MOVES; i++) {
 	init_game_chstr(chtype_game_move[i], printable_game_move[i],
-			attr_map_choice, printable_game_move[i]);
+			attr_map_choice, attr_map_empty,
+			printable_game_move[i]);
     }
 
     free(buf);
+    startup_mark("preparing the map and keycode strings");
+
+    spectate_init();
 }
 
 
@@ -585,16 +751,21 @@ void init_screen (void)
 
 void end_screen (void)
 {
+    spectate_end();
     delalltxwin();
 
+    while (winpool_count > 0) {
+	delwin(winpool[--winpool_count]);
+    }
+
     curs_set(CURS_ON);
     clear();
     refresh();
     endwin();
+    headless_end();
 
     curwin = NULL;
-    topwin = NULL;
-    firstwin = NULL;
+    txdepth = 0;
 }
 
 
@@ -648,6 +819,7 @@ WINDOW *newtxwin (int nlines, int ncols, int begin_y, int begin_x,
 {
     WINDOW *win;
     txwin_t *nw;
+    int i;
 
 
     // Centre the window, if required
@@ -663,31 +835,51 @@ WINDOW *newtxwin (int nlines, int ncols, int begin_y, int begin_x,
     assert(begin_y >= 0);
     assert(begin_x >= 0);
 
-    // Create the new window
-
-    win = newwin(nlines, ncols, begin_y, begin_x);
-    if (win == NULL) {
-	err_exit_nomem();
+    if (txdepth >= MAX_TXWINS) {
+	err_exit(_("too many windows"));
     }
 
-    // Insert the new window into the txwin stack
+    // Reuse a deleted window of the same size, if there is one
 
-    nw = xmalloc(sizeof(txwin_t));
-    nw->win = win;
-    nw->next = NULL;
-    nw->prev = topwin;
+    win = NULL;
+    for (i = winpool_count - 1; i >= 0; i--) {
+	if (getmaxy(winpool[i]) == nlines && getmaxx(winpool[i]) == ncols) {
+	    win = winpool[i];
+	    winpool[i] = winpool[--winpool_count];
 
-    if (topwin != NULL) {
-	topwin->next = nw;
+	    if (mvwin(win, begin_y, begin_x) == ERR) {
+		delwin(win);
+		win = NULL;
+	    } else {
+		// Make the window look as if newwin() had just created it
+		wattrset(win, A_NORMAL);
+		wbkgdset(win, ' ' | A_NORMAL);
+		werase(win);
+	    }
+	    break;
+	}
     }
 
-    topwin = nw;
-    curwin = win;
+    // Otherwise, create the new window
 
-    if (firstwin == NULL) {
-	firstwin = nw;
+    if (win == NULL) {
+	win = newwin(nlines, ncols, begin_y, begin_x);
+	if (win == NULL) {
+	    err_exit_nomem();
+	}
     }
 
+    // Push the new window onto the txwin stack
+
+    nw = &txstack[txdepth++];
+    nw->win = win;
+    nw->begin_y = begin_y;
+    nw->begin_x = begin_x;
+    nw->nlines = nlines;
+    nw->ncols = ncols;
+
+    curwin = win;
+
     // Paint the background and border, if required
 
     if (dofill) {
@@ -708,32 +900,28 @@ WINDOW *newtxwin (int nlines, int ncols, int begin_y, int begin_x,
 
 int deltxwin (void)
 {
-    txwin_t *cur, *prev;
-    int ret;
+    txwin_t *cur;
 
 
-    if (topwin == NULL) {
+    if (txdepth == 0) {
 	return ERR;
     }
 
     // Remove window from the txwin stack
 
-    cur = topwin;
-    prev = topwin->prev;
-    topwin = prev;
+    cur = &txstack[--txdepth];
+    curwin = (txdepth > 0) ? txstack[txdepth - 1].win : stdscr;
 
-    if (prev != NULL) {
-	prev->next = NULL;
-	curwin = prev->win;
-    } else {
-	firstwin = NULL;
-	curwin = stdscr;
-    }
+    txdamage(cur->begin_y, cur->begin_x, cur->nlines, cur->ncols);
 
-    ret = delwin(cur->win);
-    free(cur);
+    // Keep the window for newtxwin() to use again, if there is room
 
-    return ret;
+    if (winpool_count < WINPOOL_SIZE) {
+	winpool[winpool_count++] = cur->win;
+	return OK;
+    } else {
+	return delwin(cur->win);
+    }
 }
 
 
@@ -742,7 +930,7 @@ int deltxwin (void)
 
 int delalltxwin (void)
 {
-    while (topwin != NULL) {
+    while (txdepth > 0) {
 	deltxwin();
     }
 
@@ -755,15 +943,73 @@ int delalltxwin (void)
 
 int txrefresh (void)
 {
-    touchwin(stdscr);
-    wnoutrefresh(stdscr);
+    txrepaint(stdscr, 0, 0, getmaxy(stdscr), getmaxx(stdscr));
+
+    for (int i = 0; i < txdepth; i++) {
+	txwin_t *p = &txstack[i];
 
-    for (txwin_t *p = firstwin; p != NULL; p = p->next) {
-	touchwin(p->win);
-	wnoutrefresh(p->win);
+	txrepaint(p->win, p->begin_y, p->begin_x, p->nlines, p->ncols);
     }
 
-    return doupdate();
+    damage_top = damage_left = damage_bottom = damage_right = 0;
+
+    if (option_low_bandwidth) {
+	// Leave the update to the next wrefresh() or keyboard read
+	refresh_pending = true;
+	return OK;
+    } else {
+	return doupdate();
+    }
+}
+
+
+/***********************************************************************/
+// txdamage: Mark an area of the screen as needing repainting
+
+void txdamage (int begin_y, int begin_x, int nlines, int ncols)
+{
+    if (nlines <= 0 || ncols <= 0) {
+	return;
+    }
+
+    if (damage_bottom <= damage_top || damage_right <= damage_left) {
+	damage_top    = begin_y;
+	damage_left   = begin_x;
+	damage_bottom = begin_y + nlines;
+	damage_right  = begin_x + ncols;
+    } else {
+	damage_top    = MIN(damage_top, begin_y);
+	damage_left   = MIN(damage_left, begin_x);
+	damage_bottom = MAX(damage_bottom, begin_y + nlines);
+	damage_right  = MAX(damage_right, begin_x + ncols);
+    }
+}
+
+
+/***********************************************************************/
+// txrepaint: Refresh one window for txrefresh()
+
+void txrepaint (WINDOW *win, int begin_y, int begin_x, int nlines,
+		int ncols)
+{
+    bool changed = is_wintouched(win);
+    int top, bottom;
+
+
+    // Only lines under the damaged area need to be copied again
+    top    = MAX(damage_top, begin_y);
+    bottom = MIN(damage_bottom, begin_y + nlines);
+
+    if (top < bottom && damage_left < begin_x + ncols
+	&& begin_x < damage_right) {
+	touchline(win, top - begin_y, bottom - top);
+    }
+
+    if (changed) {
+	txdamage(begin_y, begin_x, nlines, ncols);
+    }
+
+    wnoutrefresh(win);
 }
 
 
@@ -781,6 +1027,7 @@ void txresize (void)
        the best! */
 
     init_title();
+    txdamage(0, 0, LINES, COLS);
     txrefresh();
 }
 
@@ -797,6 +1044,7 @@ int txdlgbox (int maxlines, int ncols, int begin_y, int begin_x,
 {
     bool usetitle = (boxtitle != NULL);
 
+    scratch_mark_t mark;
     chtype *chbuf;
     int *widthbuf;
     int lines;
@@ -805,8 +1053,9 @@ int txdlgbox (int maxlines, int ncols, int begin_y, int begin_x,
 
     assert(maxlines > 0);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    widthbuf = xmalloc(maxlines * sizeof(int));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    widthbuf = scratch_alloc(maxlines * sizeof(int));
 
     va_start(args, format);
     lines = vmkchstr(chbuf, BUFSIZE, norm_attr, alt1_attr, alt2_attr, maxlines,
@@ -824,8 +1073,7 @@ int txdlgbox (int maxlines, int ncols, int begin_y, int begin_x,
     wait_for_key(curwin, getmaxy(curwin) - 2, keywait_attr);
     deltxwin();
 
-    free(widthbuf);
-    free(chbuf);
+    scratch_release(mark);
     return OK;
 }
 
@@ -850,12 +1098,75 @@ int mkchstr (chtype *restrict chbuf, int chbufsize, chtype attr_norm,
 }
 
 
+/***********************************************************************/
+// mkchstr_lookup: Return the parsed format string for mkchstr()
+
+const struct parsedfmt *mkchstr_lookup (const char *restrict format)
+{
+    struct parsedfmt *pf;
+    struct parsedfmt newpf;
+    scratch_mark_t mark;
+    wchar_t *wcformat;
+    unsigned int home, i, n;
+
+
+    home = ((uintptr_t) format >> 3) & (FMTCACHE_SIZE - 1);
+    for (n = 0; n < FMTCACHE_PROBES; n++) {
+	i = (home + n) & (FMTCACHE_SIZE - 1);
+	pf = fmtcache[i];
+	if (pf == NULL || pf->format == format) {
+	    break;
+	}
+    }
+    if (n == FMTCACHE_PROBES) {
+	// All entries tried are in use: replace the first
+	i = home;
+	pf = fmtcache[i];
+    }
+
+    if (pf != NULL && pf->format == format
+	&& strcmp(pf->format_copy, format) == 0) {
+	return pf;
+    }
+
+    // Not in the cache: convert and parse the format string
+    mark = scratch_mark();
+    wcformat = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    xmbstowcs(wcformat, format, BUFSIZE);
+
+    newpf.num_args = mkchstr_parse(wcformat, newpf.format_arg,
+				   newpf.format_spec);
+    if (newpf.num_args < 0) {
+	int saved_errno = errno;
+
+	scratch_release(mark);
+	errno = saved_errno;
+	return NULL;
+    }
+
+    newpf.format      = format;
+    newpf.format_copy = xstrdup(format);
+    newpf.wcformat    = xwcsdup(wcformat);
+    scratch_release(mark);
+
+    if (pf == NULL) {
+	pf = fmtcache[i] = xmalloc(sizeof(struct parsedfmt));
+    } else {
+	free(pf->format_copy);
+	free(pf->wcformat);
+    }
+
+    *pf = newpf;
+    return pf;
+}
+
+
 /***********************************************************************/
 // mkchstr_parse: Parse the format string for mkchstr()
 
 int mkchstr_parse (const wchar_t *restrict format,
 		   struct argument *restrict format_arg,
-		   struct convspec *restrict format_spec, va_list args)
+		   struct convspec *restrict format_spec)
 {
     int num_args = 0;			// 0 .. MAXFMTARGS
     int arg_num = 0;			// Current index into format_arg[]
@@ -1086,6 +1397,26 @@ int mkchstr_parse (const wchar_t *restrict format,
 	}
     }
 
+    for (int i = 0; i < num_args; i++) {
+	if (format_arg[i].a_type == TYPE_NONE) {
+	    /* Cannot allow unused arguments, as we have no way of
+	       knowing how much space they take (cf. int vs. long long
+	       int). */
+	    errno = EINVAL;
+	    return -1;
+	}
+    }
+
+    return num_args;
+}
+
+
+/***********************************************************************/
+// mkchstr_args: Fetch the variable arguments for mkchstr()
+
+void mkchstr_args (struct argument *restrict format_arg, int num_args,
+		   va_list args)
+{
     for (int i = 0; i < num_args; format_arg++, i++) {
 	switch (format_arg->a_type) {
 	case TYPE_CHAR:
@@ -1120,15 +1451,10 @@ int mkchstr_parse (const wchar_t *restrict format,
 	    break;
 
 	default:
-	    /* Cannot allow unused arguments, as we have no way of
-	       knowing how much space they take (cf. int vs. long long
-	       int). */
-	    errno = EINVAL;
-	    return -1;
+	    // Unused arguments are rejected by mkchstr_parse()
+	    assert(format_arg->a_type != TYPE_NONE);
 	}
     }
-
-    return 0;
 }
 
 
@@ -1306,10 +1632,9 @@ int vmkchstr (chtype *restrict chbuf, int chbufsize, chtype attr_norm,
 	      const char *restrict format, va_list args)
 {
     struct argument format_arg[MAXFMTARGS];
-    struct convspec format_spec[MAXFMTSPECS];
-    struct convspec *spec;
+    const struct parsedfmt *pf;
+    const struct convspec *spec;
     const wchar_t *wcformat;
-    wchar_t *orig_wcformat;
 
     wchar_t *outbuf, *orig_outbuf;
     chtype *attrbuf, *orig_attrbuf;
@@ -1320,7 +1645,7 @@ int vmkchstr (chtype *restrict chbuf, int chbufsize, chtype attr_norm,
     chtype *spcattr;
     int widthspc;
     chtype curattr;
-    int saved_errno;
+    scratch_mark_t mark;
 
 
     assert(chbuf != NULL);
@@ -1332,21 +1657,24 @@ int vmkchstr (chtype *restrict chbuf, int chbufsize, chtype attr_norm,
     assert(widthbufsize >= maxlines);
     assert(format != NULL);
 
-    outbuf = orig_outbuf = xmalloc(BUFSIZE * sizeof(wchar_t));
-    attrbuf = orig_attrbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    wcformat = orig_wcformat = xmalloc(chbufsize * sizeof(wchar_t));
-    fmtbuf = xmalloc(BUFSIZE * sizeof(wchar_t));
-
-    // Convert format to a wide-character string
-    xmbstowcs(orig_wcformat, format, BUFSIZE);
+    mark = scratch_mark();
+    outbuf = orig_outbuf = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    attrbuf = orig_attrbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    fmtbuf = scratch_alloc(BUFSIZE * sizeof(wchar_t));
 
-    if (mkchstr_parse(wcformat, format_arg, format_spec, args) < 0) {
+    // Find the parsed wide-character format string, then the arguments
+    pf = mkchstr_lookup(format);
+    if (pf == NULL) {
 	goto error;
     }
 
+    memcpy(format_arg, pf->format_arg, sizeof(format_arg));
+    mkchstr_args(format_arg, pf->num_args, args);
+
     // Construct the (outbuf, attrbuf) pair of arrays
 
-    spec = format_spec;
+    wcformat = pf->wcformat;
+    spec = pf->format_spec;
 
     curattr = attr_norm;
     count = BUFSIZE;			// Space left in outbuf
@@ -1537,11 +1865,7 @@ int vmkchstr (chtype *restrict chbuf, int chbufsize, chtype attr_norm,
     // Convert the (outbuf, attrbuf) pair of arrays to chbuf
     mkchstr_conv(chbuf, chbufsize, orig_outbuf, orig_attrbuf);
 
-    free(fmtbuf);
-    free(orig_wcformat);
-    free(orig_attrbuf);
-    free(orig_outbuf);
-
+    scratch_release(mark);
     return line + 1;
 
 
@@ -1549,13 +1873,7 @@ error_inval:
     errno = EINVAL;
 
 error:
-    saved_errno = errno;
-    free(fmtbuf);
-    free(orig_wcformat);
-    free(orig_attrbuf);
-    free(orig_outbuf);
-    errno = saved_errno;
-
+    scratch_release(mark);
     errno_exit(_("mkchstr: '%s'"), format);
 }
 
@@ -1654,6 +1972,7 @@ int left (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 	  chtype attr_alt2, int maxlines, const char *restrict format, ...)
 {
     va_list args;
+    scratch_mark_t mark;
     chtype *chbuf;
     int *widthbuf;
     int lines;
@@ -1662,8 +1981,9 @@ int left (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 
     assert(maxlines > 0);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    widthbuf = xmalloc(maxlines * sizeof(int));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    widthbuf = scratch_alloc(maxlines * sizeof(int));
 
     va_start(args, format);
     lines = vmkchstr(chbuf, BUFSIZE, attr_norm, attr_alt1, attr_alt2, maxlines,
@@ -1672,8 +1992,7 @@ int left (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
     assert(ret == OK);
     va_end(args);
 
-    free(widthbuf);
-    free(chbuf);
+    scratch_release(mark);
     return lines;
 }
 
@@ -1685,6 +2004,7 @@ int center (WINDOW *win, int y, int offset, chtype attr_norm, chtype attr_alt1,
 	    chtype attr_alt2, int maxlines, const char *restrict format, ...)
 {
     va_list args;
+    scratch_mark_t mark;
     chtype *chbuf;
     int *widthbuf;
     int lines;
@@ -1693,8 +2013,9 @@ int center (WINDOW *win, int y, int offset, chtype attr_norm, chtype attr_alt1,
 
     assert(maxlines > 0);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    widthbuf = xmalloc(maxlines * sizeof(int));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    widthbuf = scratch_alloc(maxlines * sizeof(int));
 
     va_start(args, format);
     lines = vmkchstr(chbuf, BUFSIZE, attr_norm, attr_alt1, attr_alt2, maxlines,
@@ -1703,8 +2024,7 @@ int center (WINDOW *win, int y, int offset, chtype attr_norm, chtype attr_alt1,
     assert(ret == OK);
     va_end(args);
 
-    free(widthbuf);
-    free(chbuf);
+    scratch_release(mark);
     return lines;
 }
 
@@ -1716,6 +2036,7 @@ int right (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 	   chtype attr_alt2, int maxlines, const char *restrict format, ...)
 {
     va_list args;
+    scratch_mark_t mark;
     chtype *chbuf;
     int *widthbuf;
     int lines;
@@ -1724,8 +2045,9 @@ int right (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 
     assert(maxlines > 0);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    widthbuf = xmalloc(maxlines * sizeof(int));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    widthbuf = scratch_alloc(maxlines * sizeof(int));
 
     va_start(args, format);
     lines = vmkchstr(chbuf, BUFSIZE, attr_norm, attr_alt1, attr_alt2, maxlines,
@@ -1734,12 +2056,120 @@ int right (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
     assert(ret == OK);
     va_end(args);
 
-    free(widthbuf);
-    free(chbuf);
+    scratch_release(mark);
     return lines;
 }
 
 
+/***********************************************************************/
+// leftlabel: Print a static label left-aligned
+
+int leftlabel (WINDOW *win, int y, int x, chlabel_t *restrict label,
+	       chtype attr_norm, chtype attr_alt1, chtype attr_alt2,
+	       int maxlines, const char *restrict format, ...)
+{
+    va_list args;
+    int ret;
+
+
+    if (label->chbuf == NULL) {
+	va_start(args, format);
+	mklabel(label, attr_norm, attr_alt1, attr_alt2, maxlines,
+		getmaxx(win) - x - 2, format, args);
+	va_end(args);
+    }
+
+    ret = leftch(win, y, x, label->chbuf, label->lines, label->widthbuf);
+    assert(ret == OK);
+
+    return label->lines;
+}
+
+
+/***********************************************************************/
+// centerlabel: Print a static label centred in window
+
+int centerlabel (WINDOW *win, int y, int offset, chlabel_t *restrict label,
+		 chtype attr_norm, chtype attr_alt1, chtype attr_alt2,
+		 int maxlines, const char *restrict format, ...)
+{
+    va_list args;
+    int ret;
+
+
+    if (label->chbuf == NULL) {
+	va_start(args, format);
+	mklabel(label, attr_norm, attr_alt1, attr_alt2, maxlines,
+		getmaxx(win) - 4, format, args);
+	va_end(args);
+    }
+
+    ret = centerch(win, y, offset, label->chbuf, label->lines,
+		   label->widthbuf);
+    assert(ret == OK);
+
+    return label->lines;
+}
+
+
+/***********************************************************************/
+// rightlabel: Print a static label right-aligned
+
+int rightlabel (WINDOW *win, int y, int x, chlabel_t *restrict label,
+		chtype attr_norm, chtype attr_alt1, chtype attr_alt2,
+		int maxlines, const char *restrict format, ...)
+{
+    va_list args;
+    int ret;
+
+
+    if (label->chbuf == NULL) {
+	va_start(args, format);
+	mklabel(label, attr_norm, attr_alt1, attr_alt2, maxlines, x - 2,
+		format, args);
+	va_end(args);
+    }
+
+    ret = rightch(win, y, x, label->chbuf, label->lines, label->widthbuf);
+    assert(ret == OK);
+
+    return label->lines;
+}
+
+
+/***********************************************************************/
+// mklabel: Prepare a static label if not already done
+
+void mklabel (chlabel_t *restrict label, chtype attr_norm, chtype attr_alt1,
+	      chtype attr_alt2, int maxlines, int maxwidth,
+	      const char *restrict format, va_list args)
+{
+    scratch_mark_t mark;
+    chtype *chbuf;
+
+
+    assert(maxlines > 0);
+
+    if (label->chbuf != NULL) {
+	return;
+    }
+
+    if (maxlines > MAX_LABEL_LINES) {
+	maxlines = MAX_LABEL_LINES;
+    }
+
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+
+    label->lines = vmkchstr(chbuf, BUFSIZE, attr_norm, attr_alt1, attr_alt2,
+			    maxlines, maxwidth, label->widthbuf,
+			    MAX_LABEL_LINES, format, args);
+    label->chbuf = xchstrdup(chbuf);
+
+    scratch_release(mark);
+}
+
+
 /***********************************************************************/
 // getwch: Get a wide character from the keyboard
 
@@ -1751,8 +2181,25 @@ int right (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 
 int getwch (WINDOW *win, wint_t *restrict wch)
 {
-    int ret = wget_wch(win, wch);
+    int ret;
+
+
+    if (option_headless != NULL || option_spectate != NULL
+	|| option_startup_profile || refresh_pending) {
+	/* Refresh the window first, as wget_wch() would.  This also sends
+	   anything txrefresh() left undone: wget_wch() only refreshes win
+	   if it has been changed since the last wnoutrefresh(). */
+	wrefresh(win);
+	refresh_pending = false;
+	spectate_update();
+	startup_end();
+    }
 
+    if (option_headless != NULL) {
+	return headless_getwch(wch);
+    }
+
+    ret = wget_wch(win, wch);
     if (ret == OK) {
 	int c = wctob(*wch);
 	if ((c >= 0 && c < ' ') || c == 0x7F) {
@@ -1782,6 +2229,21 @@ int getwch (WINDOW *win, wint_t *restrict wch)
     wchar_t val = 0;
 
 
+    if (option_headless != NULL || option_spectate != NULL
+	|| option_startup_profile || refresh_pending) {
+	/* Refresh the window first, as wgetch() would.  This also sends
+	   anything txrefresh() left undone: wgetch() only refreshes win
+	   if it has been changed since the last wnoutrefresh(). */
+	wrefresh(win);
+	refresh_pending = false;
+	spectate_update();
+	startup_end();
+    }
+
+    if (option_headless != NULL) {
+	return headless_getwch(wch);
+    }
+
     if (mbstate == NULL) {
 	mbstate = xmalloc(sizeof(mbstate_t));
 	memset(mbstate, 0, sizeof(mbstate_t));
@@ -1850,6 +2312,29 @@ int getwch (WINDOW *win, wint_t *restrict wch)
 #endif // !defined(HAVE_CURSES_ENHANCED) && !defined(HAVE_NCURSESW)
 
 
+/***********************************************************************/
+// waitwch: Wait for a wide character from the keyboard
+
+int waitwch (WINDOW *win, wint_t *restrict wch)
+{
+    int ret;
+
+
+    if (option_spectate == NULL || option_headless != NULL) {
+	return getwch(win, wch);
+    }
+
+    // Wake up regularly to keep the spectators up to date
+    wtimeout(win, SPECTATE_POLL_TIME);
+    do {
+	ret = getwch(win, wch);
+    } while (ret == ERR);
+    wtimeout(win, -1);
+
+    return ret;
+}
+
+
 /***********************************************************************/
 // gettxchar: Read a character from the keyboard
 
@@ -1866,7 +2351,7 @@ int gettxchar (WINDOW *win, wint_t *restrict wch)
     wtimeout(win, -1);
 
     while (true) {
-	ret = getwch(win, wch);
+	ret = waitwch(win, wch);
 	if (ret == OK) {
 	    break;
 	} else if (ret == KEY_CODE_YES) {
@@ -1991,6 +2476,7 @@ int gettxline (WINDOW *win, wchar_t *restrict buf, int bufsize,
     int rcode, ret;
     wint_t key;
     chtype oldattr;
+    scratch_mark_t mark;
     chtype *chbuf;
     int chbufwidth;
 
@@ -2000,7 +2486,8 @@ int gettxline (WINDOW *win, wchar_t *restrict buf, int bufsize,
     assert(bufsize > 2);
     assert(width > 2);
 
-    chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 
     keycode_defval = xmalloc(BUFSIZE * sizeof(wchar_t));
     /* TRANSLATORS: This string specifies the keycodes used to insert the
@@ -2050,7 +2537,7 @@ int gettxline (WINDOW *win, wchar_t *restrict buf, int bufsize,
 	    wrefresh(win);
 	}
 
-	rcode = getwch(win, &key);
+	rcode = waitwch(win, &key);
 
 	if (rcode == OK) {
 	    // Ordinary wide character
@@ -2704,7 +3191,7 @@ int gettxline (WINDOW *win, wchar_t *restrict buf, int bufsize,
 	*modified = mod;
     }
 
-    free(chbuf);
+    scratch_release(mark);
     free(keycode_defval);
     return ret;
 }
@@ -2796,6 +3283,7 @@ int gettxdouble (WINDOW *win, double *restrict result, double min,
 {
     struct lconv *lc = &lconvinfo;
 
+    scratch_mark_t mark;
     wchar_t *buf, *bufcopy;
     wchar_t *allowed, *emptystr, *defaultstr;
     double val;
@@ -2806,11 +3294,12 @@ int gettxdouble (WINDOW *win, double *restrict result, double min,
     assert(result != NULL);
     assert(min <= max);
 
-    buf        = xmalloc(BUFSIZE * sizeof(wchar_t));
-    bufcopy    = xmalloc(BUFSIZE * sizeof(wchar_t));
-    allowed    = xmalloc(BUFSIZE * sizeof(wchar_t));
-    emptystr   = xmalloc(BUFSIZE * sizeof(wchar_t));
-    defaultstr = xmalloc(BUFSIZE * sizeof(wchar_t));
+    mark = scratch_mark();
+    buf        = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    bufcopy    = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    allowed    = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    emptystr   = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    defaultstr = scratch_alloc(BUFSIZE * sizeof(wchar_t));
 
     *buf = L'\0';
 
@@ -2845,11 +3334,7 @@ int gettxdouble (WINDOW *win, double *restrict result, double min,
 	}
     }
 
-    free(defaultstr);
-    free(emptystr);
-    free(allowed);
-    free(bufcopy);
-    free(buf);
+    scratch_release(mark);
 
     return ret;
 }
@@ -2862,6 +3347,7 @@ int gettxlong (WINDOW *win, long int *restrict result, long int min,
 	       long int max, long int emptyval, long int defaultval,
 	       int y, int x, int width, chtype attr)
 {
+    scratch_mark_t mark;
     wchar_t *buf, *bufcopy;
     wchar_t *allowed, *emptystr, *defaultstr;
     long int val;
@@ -2872,11 +3358,12 @@ int gettxlong (WINDOW *win, long int *restrict result, long int min,
     assert(result != NULL);
     assert(min <= max);
 
-    buf        = xmalloc(BUFSIZE * sizeof(wchar_t));
-    bufcopy    = xmalloc(BUFSIZE * sizeof(wchar_t));
-    allowed    = xmalloc(BUFSIZE * sizeof(wchar_t));
-    emptystr   = xmalloc(BUFSIZE * sizeof(wchar_t));
-    defaultstr = xmalloc(BUFSIZE * sizeof(wchar_t));
+    mark = scratch_mark();
+    buf        = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    bufcopy    = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    allowed    = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    emptystr   = scratch_alloc(BUFSIZE * sizeof(wchar_t));
+    defaultstr = scratch_alloc(BUFSIZE * sizeof(wchar_t));
 
     *buf = L'\0';
 
@@ -2909,11 +3396,7 @@ int gettxlong (WINDOW *win, long int *restrict result, long int min,
 	}
     }
 
-    free(defaultstr);
-    free(emptystr);
-    free(allowed);
-    free(bufcopy);
-    free(buf);
+    scratch_release(mark);
 
     return ret;
 }
@@ -2957,7 +3440,7 @@ bool answer_yesno (WINDOW *win)
 
     while (true) {
 	wint_t key;
-	int r = getwch(win, &key);
+	int r = waitwch(win, &key);
 
 	if (r == OK) {
 	    if (wcschr(keycode_yes, key) != NULL) {
@@ -3027,7 +3510,7 @@ void wait_for_key (WINDOW *win, int y, chtype attr)
     wrefresh(win);
 
     while (true) {
-	r = getwch(win, &key);
+	r = waitwch(win, &key);
 	if (r == OK) {
 	    break;
 	} else if (r == KEY_CODE_YES) {
@@ -71,6 +71,10 @@
 #define MERGE_OLD_STOCK_COLS	8   // Space for "Old stocks" (company merger)
 #define MERGE_NEW_STOCK_COLS	8   // Space for "New stocks" (company merger)
 #define MERGE_TOTAL_STOCK_COLS	8   // Space for "Total stocks" (company merger)
+#define GAME_NUM_COLS		8   // Space for game number or name (saved games)
+#define SAVED_PLAYERS_COLS	8   // Space for "Players" (saved games)
+#define SAVED_TURN_COLS		9   // Space for "Turn" (saved games)
+#define REPLAY_TURN_COLS	8   // Space for turn number (replay viewer)
 
 
 // Check if resizing events are supported
@@ -81,6 +85,16 @@
 #endif
 
 
+// A static label, prepared by mkchstr() once and then printed many times
+#define MAX_LABEL_LINES		4
+
+typedef struct chlabel {
+    chtype		*chbuf;		// Prepared label, or NULL
+    int			lines;		// Number of lines in chbuf
+    int			widthbuf[MAX_LABEL_LINES];  // Width of each line
+} chlabel_t;
+
+
 // Visibility of the cursor in Curses (for curs_set())
 typedef enum curs_type {
     CURS_INVISIBLE	= 0,
@@ -249,6 +263,10 @@ extern void end_screen (void);
   bkgd_attr is used to fill the background and box(curwin, 0, 0) is
   called.  Note that wrefresh() is NOT called on the new window.
 
+  Windows of the same size that were deleted by deltxwin() are reused
+  rather than created afresh; they are cleared first.  At most 16
+  windows may be in the stack at any time.
+
   If newtxwin() fails to create a new window due to insufficient memory,
   this function does NOT return: it terminates the program with an "out
   of memory" error message.
@@ -264,7 +282,9 @@ extern WINDOW *newtxwin (int nlines, int ncols, int begin_y, int begin_x,
 
   This function removes the top-most window from the Curses screen and
   from the stack managed by this module.  ERR is returned if there is no
-  such window or if the Curses delwin() function fails.
+  such window or if the Curses delwin() function fails.  The window may
+  be kept by this module for newtxwin() to use again, so no pointer to
+  it may be used after this call.
 
   Note that the actual terminal screen is NOT refreshed: a call to
   txrefresh() should follow this one.  This allows multiple windows to be
@@ -295,6 +315,14 @@ extern int delalltxwin (void);
   managed by this module.  Windows are refreshed from bottom (first) to
   top (last).  The result of doupdate() is returned.
 
+  Only those lines of each window that lie under windows deleted since
+  the last call, or under windows below it that have changed, are copied
+  to the screen again; other windows are refreshed as with wnoutrefresh().
+  If option_low_bandwidth is true, doupdate() is not called at all (and
+  OK is returned): the terminal is then updated once, by the next call
+  to wrefresh() or when the keyboard is next read (which always calls
+  doupdate() after such a call).
+
   Normal window output does not require calling txrefresh(): a call to
   wrefresh(curwin) is sufficient.  However, once a window has been
   deleted with deltxwin() (or all windows with delalltxwin()), windows
@@ -561,6 +589,46 @@ extern int right (WINDOW *win, int y, int x, chtype attr_norm, chtype attr_alt1,
 		  ...);
 
 
+/*
+  Function:   leftlabel   - Print a static label left-aligned
+  Function:   centerlabel - Print a static label centred in window
+  Function:   rightlabel  - Print a static label right-aligned
+  Parameters: win         - Window to use (should be curwin)
+              y           - Line on which to print first string
+              x           - Starting or ending column number (see left()
+                            and right())
+              offset      - Column offset to add to position (see center())
+              label       - Label to print, initialised to all zeros
+              attr_norm   - Normal character rendition to use
+              attr_alt1   - First alternate character rendition to use
+              attr_alt2   - Second alternate character rendition to use
+              maxlines    - Maximum number of screen lines to use
+              format      - Format string as described for mkchstr()
+              ...         - Arguments for the format string
+  Returns:    int         - Number of lines actually used
+
+  These functions are the same as left(), center() and right(), except
+  that the chtype string is only prepared the first time, when it is
+  kept in label; each later call simply prints that string again.  They
+  are meant for titles, column headers and menu labels, usually kept in
+  a static chlabel_t by the caller.  As the string is never prepared
+  again, the format, its arguments, the character renditions and the
+  width of win must be the same on every call; the locale, the currency
+  symbol and the colour scheme do not change once init_screen() has been
+  called.  At most MAX_LABEL_LINES lines are printed.
+*/
+extern int leftlabel (WINDOW *win, int y, int x, chlabel_t *restrict label,
+		      chtype attr_norm, chtype attr_alt1, chtype attr_alt2,
+		      int maxlines, const char *restrict format, ...);
+extern int centerlabel (WINDOW *win, int y, int offset,
+			chlabel_t *restrict label, chtype attr_norm,
+			chtype attr_alt1, chtype attr_alt2, int maxlines,
+			const char *restrict format, ...);
+extern int rightlabel (WINDOW *win, int y, int x, chlabel_t *restrict label,
+		       chtype attr_norm, chtype attr_alt1, chtype attr_alt2,
+		       int maxlines, const char *restrict format, ...);
+
+
 /*
   Function:   gettxchar - Read a wide character from the keyboard
   Parameters: win       - Window to use (should be curwin)
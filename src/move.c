@@ -50,6 +50,24 @@
 	(down)  = GALAXY_MAP_DOWN((x), (y));				\
     } while (0)
 
+// Events of one move that can be shown by show_summary()
+#define MAX_SUMMARY_EVENTS	8	// New company or mergers, bankruptcies...
+#define SUMMARY_EVENT_LINES	2	// Maximum lines per event
+#define MAX_SUMMARY_LINES	(MAX_SUMMARY_EVENTS * SUMMARY_EVENT_LINES)
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+// Events of the current move collected by add_summary(), as a chtype
+// string with one line per entry of summary_widthbuf[]
+static chtype *summary_buf = NULL;
+static int summary_len = 0;
+static int summary_lines = 0;
+static int summary_widthbuf[MAX_SUMMARY_LINES];
+static int summary_dropped = 0;		// Events that did not fit
+
 
 /************************************************************************
 *                  Module-specific function prototypes                  *
@@ -93,6 +111,21 @@ static void try_start_new_company (int x, int y);
 static void merge_companies (map_val_t a, map_val_t b);
 
 
+/*
+  Function:   show_merger - Show the results of a company merger
+  Parameters: aa, bb      - Company that took over, company that merged
+              old_stock   - Shares each player had in company bb
+              new_stock   - Shares each player received in company aa
+              bonus       - Bonus paid to each player
+  Returns:    (nothing)
+
+  This function displays the transactions made by merge_companies() for
+  each player still in the game, then waits for the user to press a key.
+*/
+static void show_merger (int aa, int bb, const long int old_stock[],
+			 const long int new_stock[], const double bonus[]);
+
+
 /*
   Function:   include_outpost - Include any outposts into the company
   Parameters: num             - Company on which to operate
@@ -129,6 +162,19 @@ static void inc_share_price (int num, double inc);
 static void adjust_values (void);
 
 
+/*
+  Function:   show_bank_payout - Show what the Bank paid on a bankruptcy
+  Parameters: which            - Company that has gone bankrupt
+              rate             - Proportion of the share price paid
+  Returns:    (nothing)
+
+  This function tells the players that company which has been declared
+  bankrupt and how much the Bank paid per share, then waits for the user
+  to press a key.
+*/
+static void show_bank_payout (int which, double rate);
+
+
 /*
   Function:   cmp_game_move - Compare two game_move[] elements for sorting
   Parameters: a, b          - Elements to compare
@@ -141,6 +187,34 @@ static void adjust_values (void);
 static int cmp_game_move (const void *a, const void *b);
 
 
+/*
+  Function:   add_summary - Add an event to the summary of this move
+  Parameters: format      - Event text, as passed to mkchstr()
+              ...         - Event text format parameters
+  Returns:    (nothing)
+
+  This function is used instead of txdlgbox() when option_fast_play is
+  set: the event is added to those shown by show_summary() once the move
+  has been processed, so that no key needs to be pressed for it.  At
+  most SUMMARY_EVENT_LINES lines are used for each event.  Events after
+  the first MAX_SUMMARY_EVENTS are only counted, not shown.
+*/
+static void add_summary (const char *restrict format, ...);
+
+
+/*
+  Function:   show_summary - Show the events of this move together
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function displays all events added by add_summary() in one
+  window, waits for the user to press a key, then forgets them.  Nothing
+  is displayed if there are no such events.  Note that txrefresh() is NOT
+  called once the window is closed.
+*/
+static void show_summary (void);
+
+
 /************************************************************************
 *                    Game move function definitions                     *
 ************************************************************************/
@@ -231,7 +305,8 @@ selection_t get_move (void)
     // Show menu of choices for the player
     newtxwin(5, WIN_COLS, 19, WCENTER, false, 0);
     while (selection == SEL_NONE) {
-	chtype *promptbuf = xmalloc(BUFSIZE * sizeof(chtype));
+	scratch_mark_t mark = scratch_mark();
+	chtype *promptbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 	int promptend, promptwidth;
 
 	wbkgdset(curwin, attr_normal_window);
@@ -274,7 +349,7 @@ selection_t get_move (void)
 
 	curs_set(CURS_ON);
 	wrefresh(curwin);
-	free(promptbuf);
+	scratch_release(mark);
 
 	// Get the actual selection made by the player
 	while (selection == SEL_NONE) {
@@ -381,12 +456,21 @@ selection_t get_move (void)
 
 	// Save the game if required
 	if (selection == SEL_SAVE) {
-	    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
+	    scratch_mark_t mark = scratch_mark();
+	    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
 	    int width;
 
 	    bool saved = false;
 
-	    if (game_loaded) {
+	    if (! game_loaded && game_name != NULL) {
+		// A named new game: save it to the game of that name, if any
+		game_num = find_saved_game(game_name);
+		if (game_num == 0) {
+		    game_num = unused_game_number();
+		}
+	    }
+
+	    if (game_loaded || game_name != NULL) {
 		// Save the game to the same game number
 		mkchstr(chbuf, BUFSIZE, attr_status_window, 0, 0, 1, WIN_COLS
 			- 7, &width, 1, _("Saving game %d... "), game_num);
@@ -403,62 +487,7 @@ selection_t get_move (void)
 	    if (! saved) {
 		// Ask which game to save
 
-		bool done;
-		int widthbuf[2];
-		int lines, maxwidth;
-		int choice;
-
-		lines = mkchstr(chbuf, BUFSIZE, attr_normal, attr_keycode, 0,
-				2, WIN_COLS - 7, widthbuf, 2,
-				_("Enter game number [^{1^}-^{9^}] "
-				  "or ^{<CTRL><C>^} to cancel: "));
-		assert(lines == 1 || lines == 2);
-		maxwidth = ((lines == 1) ? widthbuf[0] :
-			    MAX(widthbuf[0], widthbuf[1])) + 5;
-
-		newtxwin(lines + 4, maxwidth, 8, WCENTER, true,
-			 attr_normal_window);
-		leftch(curwin, 2, 2, chbuf, lines, widthbuf);
-
-		curs_set(CURS_ON);
-		wrefresh(curwin);
-
-		done = false;
-		while (! done) {
-		    wint_t key;
-
-		    if (gettxchar(curwin, &key) == OK) {
-			// Ordinary wide character
-			if (key >= L'1' && key <= L'9') {
-			    left(curwin, getcury(curwin), getcurx(curwin),
-				 A_BOLD, 0, 0, 1, "%lc", key);
-			    wrefresh(curwin);
-
-			    choice = key - L'0';
-			    done = true;
-			} else {
-			    beep();
-			}
-		    } else {
-			// Function or control key
-			switch (key) {
-			case KEY_ESC:
-			case KEY_CANCEL:
-			case KEY_EXIT:
-			case KEY_CTRL('C'):
-			case KEY_CTRL('G'):
-			case KEY_CTRL('\\'):
-			    choice = ERR;
-			    done = true;
-			    break;
-
-			default:
-			    beep();
-			}
-		    }
-		}
-
-		curs_set(CURS_OFF);
+		int choice = ask_game_number(true);
 
 		if (choice != ERR) {
 		    // Try to save the game, if possible
@@ -489,11 +518,13 @@ selection_t get_move (void)
 		// Make the next try at saving ask the player for a game number
 		game_loaded = false;
 		game_num = 0;
+		free(game_name);
+		game_name = NULL;
 
 		selection = SEL_NONE;
 	    }
 
-	    free(chbuf);
+	    scratch_release(mark);
 	}
     }
 
@@ -512,9 +543,11 @@ void process_move (selection_t selection)
     }
 
     if (quit_selected || abort_game) {
-	deltxwin();			// "Select move" window
-	deltxwin();			// Galaxy map window
-	txrefresh();
+	if (! replaying) {
+	    deltxwin();			// "Select move" window
+	    deltxwin();			// Galaxy map window
+	    txrefresh();
+	}
 
 	return;
     }
@@ -643,9 +676,13 @@ void process_move (selection_t selection)
 	adjust_values();
     }
 
-    deltxwin();			// "Select move" window
-    deltxwin();			// Galaxy map window
-    txrefresh();
+    if (! replaying) {
+	show_summary();
+
+	deltxwin();			// "Select move" window
+	deltxwin();			// Galaxy map window
+	txrefresh();
+    }
 }
 
 
@@ -694,23 +731,41 @@ void next_player (void)
 
 void bankrupt_player (bool forced)
 {
-    if (forced) {
+    if (replaying) {
+	// Nothing to display
+    } else if (option_fast_play) {
+	if (forced) {
+	    /* TRANSLATORS: %ls is the player's name.  This text is shown
+	       in the summary of a move, with at most two lines of 72
+	       characters each. */
+	    add_summary(_("^{%ls^} has been declared bankrupt "
+			  "by the Interstellar Trading Bank."),
+			name_wcs(player[current_player].name));
+	} else {
+	    /* TRANSLATORS: %ls is the player's name. */
+	    add_summary(_("^{%ls^} has declared bankruptcy."),
+			name_wcs(player[current_player].name));
+	}
+    } else if (forced) {
 	txdlgbox(MAX_DLG_LINES, 50, 7, WCENTER, attr_error_window,
 		 attr_error_title, attr_error_highlight, 0, 0,
 		 attr_error_waitforkey, _("  Bankruptcy Court  "),
 		 /* TRANSLATORS: %ls is the player's name. */
 		 _("%ls has been declared bankrupt "
 		   "by the Interstellar Trading Bank."),
-		 player[current_player].name);
+		 name_wcs(player[current_player].name));
+	txrefresh();
     } else {
 	txdlgbox(MAX_DLG_LINES, 50, 7, WCENTER, attr_error_window,
 		 attr_error_title, attr_error_highlight, 0, 0,
 		 attr_error_waitforkey, _("  Bankruptcy Court  "),
 		 /* TRANSLATORS: %ls is the player's name. */
 		 _("%ls has declared bankruptcy."),
-		 player[current_player].name);
+		 name_wcs(player[current_player].name));
+	txrefresh();
     }
-    txrefresh();
+
+    export_record_player_bankrupt(current_player);
 
     // Confiscate all assets belonging to player
     player[current_player].in_game = false;
@@ -773,12 +828,21 @@ void try_start_new_company (int x, int y)
     } else {
 	// Create the new company
 
-	txdlgbox(MAX_DLG_LINES, 50, 7, WCENTER, attr_normal_window,
-		 attr_title, attr_normal, attr_highlight, 0, attr_waitforkey,
-		 _("  New Company  "),
-		 _("A new company has been formed!\nIts name is ^{%ls^}."),
-		 company[i].name);
-	txrefresh();
+	if (replaying) {
+	    // Nothing to display
+	} else if (option_fast_play) {
+	    add_summary(_("A new company has been formed!\n"
+			  "Its name is ^{%ls^}."),
+			name_wcs(company[i].name));
+	} else {
+	    txdlgbox(MAX_DLG_LINES, 50, 7, WCENTER, attr_normal_window,
+		     attr_title, attr_normal, attr_highlight, 0,
+		     attr_waitforkey, _("  New Company  "),
+		     _("A new company has been formed!\n"
+		       "Its name is ^{%ls^}."),
+		     name_wcs(company[i].name));
+	    txrefresh();
+	}
 
 	galaxy_map[x][y] = (map_val_t) COMPANY_TO_MAP(i);
 
@@ -813,13 +877,9 @@ void merge_companies (map_val_t a, map_val_t b)
     double val_bb = company[bb].share_price * company[bb].stock_issued *
 	(1.0 + company[bb].share_return);
 
-    double bonus;
-    long int old_stock, new_stock, total_new;
-    chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-    int lines, width, widthbuf[4];
-    chtype *chbuf_aa, *chbuf_bb;
-    int width_aa, width_bb;
-    int x, y, w, i, ln;
+    long int old_stock[MAX_PLAYERS], new_stock[MAX_PLAYERS], total_new;
+    double bonus[MAX_PLAYERS];
+    int x, y, i;
 
 
     if (val_aa < val_bb) {
@@ -831,26 +891,101 @@ void merge_companies (map_val_t a, map_val_t b)
 	tt = aa; aa = bb; bb = tt;
     }
 
+    total_new = 0;
+    for (i = 0; i < number_players; i++) {
+	if (player[i].in_game) {
+	    // Calculate new stock and any bonus
+	    old_stock[i] = player[i].stock_owned[bb];
+	    new_stock[i] = (double) old_stock[i] * MERGE_STOCK_RATIO;
+	    total_new += new_stock[i];
+
+	    bonus[i] = (company[bb].stock_issued == 0) ? 0.0 : MERGE_BONUS_RATE
+		* ((double) player[i].stock_owned[bb]
+		   / company[bb].stock_issued) * company[bb].share_price;
+
+	    player[i].stock_owned[aa] += new_stock[i];
+	    player[i].stock_owned[bb] = 0;
+	    player[i].cash += bonus[i];
+	}
+    }
+
+    // Adjust the company records appropriately
+    company[aa].stock_issued += total_new;
+    company[aa].max_stock    += total_new;
+    company[aa].share_price  += company[bb].share_price
+	* (randf() * (MERGE_PRICE_ADJUST_MAX - MERGE_PRICE_ADJUST_MIN)
+	   + MERGE_PRICE_ADJUST_MIN);
+
+    company[bb].stock_issued = 0;
+    company[bb].max_stock    = 0;
+    company[bb].on_map       = false;
+
+    // Adjust the galaxy map appropriately
+    for (x = 0; x < MAX_X; x++) {
+	for (y = 0; y < MAX_Y; y++) {
+	    if (galaxy_map[x][y] == b) {
+		galaxy_map[x][y] = a;
+	    }
+	}
+    }
+
+    export_record_merger(aa, bb);
+
+    if (replaying) {
+	// Nothing to display
+    } else if (option_fast_play) {
+	/* TRANSLATORS: The first %ls is the company that has ceased
+	   existence, the second the company that absorbed it; %N is the
+	   bonus paid to the current player. */
+	add_summary(_("^{%ls^} has just merged into ^{%ls^}.\n"
+		      "Your bonus is %N."),
+		    name_wcs(company[bb].name), name_wcs(company[aa].name),
+		    bonus[current_player]);
+    } else {
+	show_merger(aa, bb, old_stock, new_stock, bonus);
+    }
+}
+
+
+/***********************************************************************/
+// show_merger: Show the results of a company merger
+
+void show_merger (int aa, int bb, const long int old_stock[],
+		  const long int new_stock[], const double bonus[])
+{
+    static chlabel_t label_title;
+    static chlabel_t label_player, label_bonus, label_total;
+    static chlabel_t label_new_stock, label_old_stock;
+
+    scratch_mark_t mark = scratch_mark();
+    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    int lines, width, widthbuf[4];
+    chtype *chbuf_aa, *chbuf_bb;
+    int width_aa, width_bb;
+    int x, w, i, ln;
+
+
     // Display information about the merger
 
     lines = mkchstr(chbuf, BUFSIZE, attr_normal, attr_highlight, 0, 4,
 		    WIN_COLS - 8, widthbuf, 4,
 		    _("^{%ls^} has just merged into ^{%ls^}.\n"
 		      "Please note the following transactions:\n"),
-		    company[bb].name, company[aa].name);
+		    name_wcs(company[bb].name), name_wcs(company[aa].name));
 
     newtxwin(number_players + lines + 10, WIN_COLS - 4, lines + 6
 	     - number_players, WCENTER, true, attr_normal_window);
-    center(curwin, 1, 0, attr_title, 0, 0, 1, _("  Company Merger  "));
+    centerlabel(curwin, 1, 0, &label_title, attr_title, 0, 0, 1,
+		_("  Company Merger  "));
     centerch(curwin, 3, 0, chbuf, lines, widthbuf);
 
     mkchstr(chbuf, BUFSIZE, attr_highlight, 0, 0, 1, getmaxx(curwin) / 2,
-	    &width_aa, 1, "%ls", company[aa].name);
-    chbuf_aa = xchstrdup(chbuf);
+	    &width_aa, 1, "%ls", name_wcs(company[aa].name));
+    chbuf_aa = scratch_chstrdup(chbuf);
 
     mkchstr(chbuf, BUFSIZE, attr_highlight, 0, 0, 1, getmaxx(curwin) / 2,
-	    &width_bb, 1, "%ls", company[bb].name);
-    chbuf_bb = xchstrdup(chbuf);
+	    &width_bb, 1, "%ls", name_wcs(company[bb].name));
+    chbuf_bb = scratch_chstrdup(chbuf);
 
     mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, getmaxx(curwin) / 2,
 	    &width, 1,
@@ -876,99 +1011,68 @@ void merge_companies (map_val_t a, map_val_t b)
     leftch(curwin, lines + 4, x, chbuf_aa, 1, &width_aa);
 
     mvwhline(curwin, lines + 6, 2, ' ' | attr_subtitle, w - 4);
-    left(curwin, lines + 6, 4, attr_subtitle, 0, 0, 1,
-	 /* TRANSLATORS: "Player" is used as a column title in a
-	    table containing all player names. */
-	 pgettext("subtitle", "Player"));
-    right(curwin, lines + 6, w - 4, attr_subtitle, 0, 0, 1,
-	  /* TRANSLATORS: "Bonus" refers to the bonus cash amount paid to
-	     each player after two companies merge.  %ls is the currency
-	     symbol in the current locale.  The maximum column width is
-	     12 characters INCLUDING the currency symbol (see
-	     MERGE_BONUS_COLS in src/intf.h). */
-	  pgettext("subtitle", "Bonus (%ls)"), currency_symbol);
-    right(curwin, lines + 6, w - 6 - MERGE_BONUS_COLS, attr_subtitle, 0, 0, 1,
-	  /* TRANSLATORS: "Total" refers to the total number of shares in
-	     the new company after a merger.  The maximum column width is
-	     8 characters (see MERGE_TOTAL_STOCK_COLS in src/intf.h). */
-	  pgettext("subtitle", "Total"));
-    right(curwin, lines + 6, w - 8 - MERGE_BONUS_COLS - MERGE_TOTAL_STOCK_COLS,
-	  attr_subtitle, 0, 0, 1,
-	  /* TRANSLATORS: "New" refers to how many (new) shares each
-	     player receives in the surviving company after a merger.
-	     The maximum column width is 8 characters (see
-	     MERGE_NEW_STOCK_COLS in src/intf.h). */
-	  pgettext("subtitle", "New"));
-    right(curwin, lines + 6, w - 10 - MERGE_BONUS_COLS - MERGE_TOTAL_STOCK_COLS
-	  - MERGE_NEW_STOCK_COLS, attr_subtitle, 0, 0, 1,
-	  /* TRANSLATORS: "Old" refers to how many shares each player had
-	     in the company ceasing existence.  The maximum column width
-	     is 8 characters (see MERGE_OLD_STOCK_COLS in src/intf.h). */
-	  pgettext("subtitle", "Old"));
+    leftlabel(curwin, lines + 6, 4, &label_player, attr_subtitle, 0, 0, 1,
+	      /* TRANSLATORS: "Player" is used as a column title in a
+		 table containing all player names. */
+	      pgettext("subtitle", "Player"));
+    rightlabel(curwin, lines + 6, w - 4, &label_bonus, attr_subtitle, 0, 0, 1,
+	       /* TRANSLATORS: "Bonus" refers to the bonus cash amount
+		  paid to each player after two companies merge.  %ls is
+		  the currency symbol in the current locale.  The maximum
+		  column width is 12 characters INCLUDING the currency
+		  symbol (see MERGE_BONUS_COLS in src/intf.h). */
+	       pgettext("subtitle", "Bonus (%ls)"), currency_symbol);
+    rightlabel(curwin, lines + 6, w - 6 - MERGE_BONUS_COLS, &label_total,
+	       attr_subtitle, 0, 0, 1,
+	       /* TRANSLATORS: "Total" refers to the total number of shares
+		  in the new company after a merger.  The maximum column
+		  width is 8 characters (see MERGE_TOTAL_STOCK_COLS in
+		  src/intf.h). */
+	       pgettext("subtitle", "Total"));
+    rightlabel(curwin, lines + 6, w - 8 - MERGE_BONUS_COLS
+	       - MERGE_TOTAL_STOCK_COLS, &label_new_stock, attr_subtitle, 0, 0,
+	       1,
+	       /* TRANSLATORS: "New" refers to how many (new) shares each
+		  player receives in the surviving company after a merger.
+		  The maximum column width is 8 characters (see
+		  MERGE_NEW_STOCK_COLS in src/intf.h). */
+	       pgettext("subtitle", "New"));
+    rightlabel(curwin, lines + 6, w - 10 - MERGE_BONUS_COLS
+	       - MERGE_TOTAL_STOCK_COLS - MERGE_NEW_STOCK_COLS,
+	       &label_old_stock, attr_subtitle, 0, 0, 1,
+	       /* TRANSLATORS: "Old" refers to how many shares each player
+		  had in the company ceasing existence.  The maximum column
+		  width is 8 characters (see MERGE_OLD_STOCK_COLS in
+		  src/intf.h). */
+	       pgettext("subtitle", "Old"));
 
-    total_new = 0;
     for (ln = lines + 7, i = 0; i < number_players; i++) {
 	if (player[i].in_game) {
-	    // Calculate new stock and any bonus
-	    old_stock = player[i].stock_owned[bb];
-	    new_stock = (double) old_stock * MERGE_STOCK_RATIO;
-	    total_new += new_stock;
-
-	    bonus = (company[bb].stock_issued == 0) ? 0.0 : MERGE_BONUS_RATE
-		* ((double) player[i].stock_owned[bb]
-		   / company[bb].stock_issued) * company[bb].share_price;
-
-	    player[i].stock_owned[aa] += new_stock;
-	    player[i].stock_owned[bb] = 0;
-	    player[i].cash += bonus;
-
 	    mkchstr(chbuf, BUFSIZE, attr_normal, 0, 0, 1, w - 12
 		    - MERGE_BONUS_COLS - MERGE_TOTAL_STOCK_COLS
 		    - MERGE_NEW_STOCK_COLS - MERGE_OLD_STOCK_COLS,
-		    &width, 1, "%ls", player[i].name);
+		    &width, 1, "%ls", name_wcs(player[i].name));
 	    leftch(curwin, ln, 4, chbuf, 1, &width);
 
-	    right(curwin, ln, w - 4, attr_normal, 0, 0, 1, "%!N", bonus);
+	    right(curwin, ln, w - 4, attr_normal, 0, 0, 1, "%!N", bonus[i]);
 	    right(curwin, ln, w - 6 - MERGE_BONUS_COLS, attr_normal, 0, 0, 1,
 		  "%'ld", player[i].stock_owned[aa]);
 	    right(curwin, ln, w - 8 - MERGE_BONUS_COLS - MERGE_TOTAL_STOCK_COLS,
-		  attr_normal, 0, 0, 1, "%'ld", new_stock);
+		  attr_normal, 0, 0, 1, "%'ld", new_stock[i]);
 	    right(curwin, ln, w - 10 - MERGE_BONUS_COLS - MERGE_TOTAL_STOCK_COLS
 		  - MERGE_NEW_STOCK_COLS, attr_normal, 0, 0, 1, "%'ld",
-		  old_stock);
+		  old_stock[i]);
 
 	    ln++;
 	}
     }
 
-    // Adjust the company records appropriately
-    company[aa].stock_issued += total_new;
-    company[aa].max_stock    += total_new;
-    company[aa].share_price  += company[bb].share_price
-	* (randf() * (MERGE_PRICE_ADJUST_MAX - MERGE_PRICE_ADJUST_MIN)
-	   + MERGE_PRICE_ADJUST_MIN);
-
-    company[bb].stock_issued = 0;
-    company[bb].max_stock    = 0;
-    company[bb].on_map       = false;
-
-    // Adjust the galaxy map appropriately
-    for (x = 0; x < MAX_X; x++) {
-	for (y = 0; y < MAX_Y; y++) {
-	    if (galaxy_map[x][y] == b) {
-		galaxy_map[x][y] = a;
-	    }
-	}
-    }
-
     wait_for_key(curwin, getmaxy(curwin) - 2, attr_waitforkey);
 
     deltxwin();			// "Company merger" window
     txrefresh();
 
-    free(chbuf_bb);
-    free(chbuf_aa);
-    free(chbuf);
+    scratch_release(mark);
 }
 
 
@@ -1059,26 +1163,35 @@ void adjust_values (void)
 	which = randi(MAX_COMPANIES);
 
 	if (company[which].on_map && company[which].share_return <= 0.0) {
+	    export_record_company_bankrupt(which);
+
 	    if (randf() < ALL_ASSETS_TAKEN) {
-		txdlgbox(MAX_DLG_LINES, 60, 6, WCENTER, attr_error_window,
-			 attr_error_title, attr_error_highlight,
-			 attr_error_normal, 0, attr_error_waitforkey,
-			 _("  Bankruptcy Court  "),
-			 /* TRANSLATORS: %ls represents the company name. */
-			 _("%ls has been declared bankrupt "
-			   "by the Interstellar Trading Bank.\n\n"
-			   "^{All assets have been taken "
-			   "to repay outstanding loans.^}"),
-			 company[which].name);
-		txrefresh();
+		if (replaying) {
+		    // Nothing to display
+		} else if (option_fast_play) {
+		    /* TRANSLATORS: %ls represents the company name. */
+		    add_summary(_("^{%ls^} has been declared bankrupt: all "
+				  "assets have been taken to repay "
+				  "outstanding loans."),
+				name_wcs(company[which].name));
+		} else {
+		    txdlgbox(MAX_DLG_LINES, 60, 6, WCENTER, attr_error_window,
+			     attr_error_title, attr_error_highlight,
+			     attr_error_normal, 0, attr_error_waitforkey,
+			     _("  Bankruptcy Court  "),
+			     /* TRANSLATORS: %ls represents the company
+				name. */
+			     _("%ls has been declared bankrupt "
+			       "by the Interstellar Trading Bank.\n\n"
+			       "^{All assets have been taken "
+			       "to repay outstanding loans.^}"),
+			     name_wcs(company[which].name));
+		    txrefresh();
+		}
 
 	    } else {
 		double rate = randf();
 
-		chtype *chbuf = xmalloc(BUFSIZE * sizeof(chtype));
-		chtype *chbuf_amt;
-		int w, x, lines, width, width_amt, widthbuf[6];
-
 		for (int i = 0; i < number_players; i++) {
 		    if (player[i].in_game) {
 			player[i].cash += player[i].stock_owned[which]
@@ -1086,58 +1199,17 @@ void adjust_values (void)
 		    }
 		}
 
-		lines = mkchstr(chbuf, BUFSIZE, attr_error_highlight,
-				attr_error_normal, 0, 6, 60 - 4, widthbuf, 6,
-				/* TRANSLATORS: %ls represents the company name. */
-				_("%ls has been declared bankrupt by the "
-				  "Interstellar Trading Bank.\n\n"
-				  "^{The Bank has agreed to pay stock holders ^}"
-				  "%.2f%%^{ of the share value on each share "
-				  "owned.^}"),
-				company[which].name, rate * 100.0);
-
-		newtxwin(9 + lines, 60, 4, WCENTER, true, attr_error_window);
-		w = getmaxx(curwin);
-
-		center(curwin, 1, 0, attr_error_title, 0, 0, 1,
-		       _("  Bankruptcy Court  "));
-		centerch(curwin, 3, 0, chbuf, lines, widthbuf);
-
-		mkchstr(chbuf, BUFSIZE, attr_error_highlight, 0, 0, 1, w / 2,
-			&width_amt, 1, "%N", company[which].share_price);
-		chbuf_amt = xchstrdup(chbuf);
-
-		mkchstr(chbuf, BUFSIZE, attr_error_normal, 0, 0, 1, w / 2,
-			&width, 1,
-			/* TRANSLATORS: The label "Amount paid per share"
-			   refers to payment made by the Interstellar
-			   Trading Bank to each player upon company
-			   bankruptcy.  This label MUST be the same
-			   length as "Old share value" and MUST have at
-			   least one trailing space for the display
-			   routines to work correctly.  The maximum
-			   length is 28 characters. */
-			pgettext("label", "Amount paid per share: "));
-		x = (w + width - width_amt) / 2;
-
-		right(curwin, lines + 4, x, attr_error_normal, 0, 0, 1,
-		      /* TRANSLATORS: "Old share value" refers to the
-			 share price of a company before it was forced
-			 into bankruptcy by the Bank.  This label must be
-			 the same width as "Amount paid per share". */
-		      pgettext("label", "Old share value:       "));
-		leftch(curwin, lines + 4, x, chbuf_amt, 1, &width_amt);
-
-		rightch(curwin, lines + 5, x, chbuf, 1, &width);
-		left(curwin, lines + 5, x, attr_error_highlight, 0, 0, 1,
-		     "%N", company[which].share_price * rate);
-
-		wait_for_key(curwin, getmaxy(curwin) - 2, attr_error_waitforkey);
-		deltxwin();
-		txrefresh();
-
-		free(chbuf_amt);
-		free(chbuf);
+		if (replaying) {
+		    // Nothing to display
+		} else if (option_fast_play) {
+		    /* TRANSLATORS: %ls represents the company name. */
+		    add_summary(_("^{%ls^} has been declared bankrupt: the "
+				  "Bank has paid stock holders %.2f%% of the "
+				  "share value."),
+				name_wcs(company[which].name), rate * 100.0);
+		} else {
+		    show_bank_payout(which, rate);
+		}
 	    }
 
 	    for (int i = 0; i < number_players; i++) {
@@ -1206,14 +1278,23 @@ void adjust_values (void)
     if (player[current_player].cash < 0.0) {
 	double borrowed = -player[current_player].cash;
 
-	txdlgbox(MAX_DLG_LINES, 60, 7, WCENTER, attr_error_window,
-		 attr_error_title, attr_error_highlight, 0, 0,
-		 attr_error_waitforkey, _("  Interstellar Trading Bank  "),
-		 /* xgettext:c-format */
-		 _("You were forced to borrow %N\n"
-		   "to cover losses from company shares."),
-		 borrowed);
-	txrefresh();
+	if (replaying) {
+	    // Nothing to display
+	} else if (option_fast_play) {
+	    /* xgettext:c-format */
+	    add_summary(_("You were forced to borrow %N\n"
+			  "to cover losses from company shares."),
+			borrowed);
+	} else {
+	    txdlgbox(MAX_DLG_LINES, 60, 7, WCENTER, attr_error_window,
+		     attr_error_title, attr_error_highlight, 0, 0,
+		     attr_error_waitforkey, _("  Interstellar Trading Bank  "),
+		     /* xgettext:c-format */
+		     _("You were forced to borrow %N\n"
+		       "to cover losses from company shares."),
+		     borrowed);
+	    txrefresh();
+	}
 
 	player[current_player].cash = 0.0;
 	player[current_player].debt += borrowed;
@@ -1241,14 +1322,24 @@ void adjust_values (void)
 	double impounded = MIN(player[current_player].cash,
 			       player[current_player].debt);
 
-	txdlgbox(MAX_DLG_LINES, 60, 7, WCENTER, attr_error_window,
-		 attr_error_title, attr_error_highlight, attr_error_normal,
-		 0, attr_error_waitforkey, _("  Interstellar Trading Bank  "),
-		 /* xgettext:c-format */
-		 _("Your debt has amounted to %N!\n"
-		   "^{The Bank has impounded ^}%N^{ from your cash.^}"),
-		 player[current_player].debt, impounded);
-	txrefresh();
+	if (replaying) {
+	    // Nothing to display
+	} else if (option_fast_play) {
+	    /* xgettext:c-format */
+	    add_summary(_("Your debt has amounted to %N!\n"
+			  "^{The Bank has impounded ^}%N^{ from your cash.^}"),
+			player[current_player].debt, impounded);
+	} else {
+	    txdlgbox(MAX_DLG_LINES, 60, 7, WCENTER, attr_error_window,
+		     attr_error_title, attr_error_highlight, attr_error_normal,
+		     0, attr_error_waitforkey,
+		     _("  Interstellar Trading Bank  "),
+		     /* xgettext:c-format */
+		     _("Your debt has amounted to %N!\n"
+		       "^{The Bank has impounded ^}%N^{ from your cash.^}"),
+		     player[current_player].debt, impounded);
+	    txrefresh();
+	}
 
 	player[current_player].cash -= impounded;
 	player[current_player].debt -= impounded;
@@ -1267,6 +1358,70 @@ void adjust_values (void)
 }
 
 
+/***********************************************************************/
+// show_bank_payout: Show what the Bank paid on a bankruptcy
+
+void show_bank_payout (int which, double rate)
+{
+    static chlabel_t label_title;
+
+    scratch_mark_t mark = scratch_mark();
+    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+    chtype *chbuf_amt;
+    int w, x, lines, width, width_amt, widthbuf[6];
+
+
+    lines = mkchstr(chbuf, BUFSIZE, attr_error_highlight, attr_error_normal,
+		    0, 6, 60 - 4, widthbuf, 6,
+		    /* TRANSLATORS: %ls represents the company name. */
+		    _("%ls has been declared bankrupt by the "
+		      "Interstellar Trading Bank.\n\n"
+		      "^{The Bank has agreed to pay stock holders ^}"
+		      "%.2f%%^{ of the share value on each share "
+		      "owned.^}"),
+		    name_wcs(company[which].name), rate * 100.0);
+
+    newtxwin(9 + lines, 60, 4, WCENTER, true, attr_error_window);
+    w = getmaxx(curwin);
+
+    centerlabel(curwin, 1, 0, &label_title, attr_error_title, 0, 0, 1,
+		_("  Bankruptcy Court  "));
+    centerch(curwin, 3, 0, chbuf, lines, widthbuf);
+
+    mkchstr(chbuf, BUFSIZE, attr_error_highlight, 0, 0, 1, w / 2,
+	    &width_amt, 1, "%N", company[which].share_price);
+    chbuf_amt = scratch_chstrdup(chbuf);
+
+    mkchstr(chbuf, BUFSIZE, attr_error_normal, 0, 0, 1, w / 2, &width, 1,
+	    /* TRANSLATORS: The label "Amount paid per share" refers to
+	       payment made by the Interstellar Trading Bank to each
+	       player upon company bankruptcy.  This label MUST be the
+	       same length as "Old share value" and MUST have at least
+	       one trailing space for the display routines to work
+	       correctly.  The maximum length is 28 characters. */
+	    pgettext("label", "Amount paid per share: "));
+    x = (w + width - width_amt) / 2;
+
+    right(curwin, lines + 4, x, attr_error_normal, 0, 0, 1,
+	  /* TRANSLATORS: "Old share value" refers to the share price of
+	     a company before it was forced into bankruptcy by the Bank.
+	     This label must be the same width as "Amount paid per
+	     share". */
+	  pgettext("label", "Old share value:       "));
+    leftch(curwin, lines + 4, x, chbuf_amt, 1, &width_amt);
+
+    rightch(curwin, lines + 5, x, chbuf, 1, &width);
+    left(curwin, lines + 5, x, attr_error_highlight, 0, 0, 1,
+	 "%N", company[which].share_price * rate);
+
+    wait_for_key(curwin, getmaxy(curwin) - 2, attr_error_waitforkey);
+    deltxwin();
+    txrefresh();
+
+    scratch_release(mark);
+}
+
+
 /***********************************************************************/
 // cmp_game_move: Compare two game_move[] elements for sorting
 
@@ -1292,5 +1447,87 @@ int cmp_game_move (const void *a, const void *b)
 }
 
 
+/***********************************************************************/
+// add_summary: Add an event to the summary of this move
+
+void add_summary (const char *restrict format, ...)
+{
+    scratch_mark_t mark;
+    chtype *chbuf;
+    int lines, len;
+    va_list args;
+
+
+    if (summary_buf == NULL) {
+	summary_buf = xmalloc(BUFSIZE * sizeof(chtype));
+    }
+
+    if (summary_lines + SUMMARY_EVENT_LINES > MAX_SUMMARY_LINES) {
+	// No room left in summary_widthbuf[]
+	summary_dropped++;
+	return;
+    }
+
+    mark = scratch_mark();
+    chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+
+    va_start(args, format);
+    lines = vmkchstr(chbuf, BUFSIZE, attr_normal, attr_highlight, 0,
+		     SUMMARY_EVENT_LINES, WIN_COLS - 8,
+		     summary_widthbuf + summary_lines, SUMMARY_EVENT_LINES,
+		     format, args);
+    va_end(args);
+
+    for (len = 0; chbuf[len] != 0; len++)
+	;
+
+    if (lines > 0 && summary_len + len + 2 <= BUFSIZE) {
+	if (summary_lines > 0) {
+	    summary_buf[summary_len++] = '\n';
+	}
+	memcpy(summary_buf + summary_len, chbuf, len * sizeof(chtype));
+	summary_len += len;
+	summary_buf[summary_len] = 0;
+	summary_lines += lines;
+    }
+
+    scratch_release(mark);
+}
+
+
+/***********************************************************************/
+// show_summary: Show the events of this move together
+
+void show_summary (void)
+{
+    static chlabel_t label_title;
+
+
+    if (summary_lines == 0) {
+	return;
+    }
+
+    newtxwin(summary_lines + ((summary_dropped > 0) ? 7 : 6), WIN_COLS - 4,
+	     WCENTER, WCENTER, true, attr_normal_window);
+    centerlabel(curwin, 1, 0, &label_title, attr_title, 0, 0, 1,
+		_("  Move Summary  "));
+    leftch(curwin, 3, 2, summary_buf, summary_lines, summary_widthbuf);
+
+    if (summary_dropped > 0) {
+	center(curwin, summary_lines + 3, 0, attr_normal, attr_highlight, 0, 1,
+	       ngettext("(and ^{one^} other event)",
+			"(and ^{%'d^} other events)", summary_dropped),
+	       summary_dropped);
+    }
+
+    wait_for_key(curwin, getmaxy(curwin) - 2, attr_waitforkey);
+    deltxwin();
+
+    summary_len = 0;
+    summary_lines = 0;
+    summary_dropped = 0;
+}
+
+
 /***********************************************************************/
 // End of file
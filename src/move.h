@@ -76,6 +76,9 @@ extern selection_t get_move (void);
   move" and galaxy map windows are still open.  In particular, this
   function tries to start new companies, merge companies, bankrupt
   companies and/or players, adjust values, etc.
+
+  If replaying is true, the move is processed without displaying
+  anything, and no windows need be open.
 */
 extern void process_move (selection_t selection);
 
@@ -0,0 +1,1454 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, replay.c, contains the implementation of the game replay
+  functions used in Star Traders.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  A game replay consists of an eight-byte header (REPLAY_MAGIC), then a
+  keyframe record with the state of the game when recording started,
+  then one record for every move made, with a further keyframe record at
+  the start of every REPLAY_KEYFRAME_TURNS turns.  An index of the
+  keyframes follows.  The last sixteen bytes of the file give the offset
+  of the index (eight bytes, least significant first) and
+  REPLAY_INDEX_MAGIC.  All other numbers are unsigned LEB128 varints (see
+  put_varint()).
+
+  A keyframe record starts with REPLAY_KEYFRAME_TAG and the length of the
+  state that follows.  The state holds the turn number, maximum turn,
+  number of players, first and current players, the 48-bit state of the
+  random number generator and the interest rate.  The galaxy map follows
+  as runs of equal values, column by column, each as one varint: the run
+  length less one times MAP_CODES, plus the value (0 for MAP_EMPTY, 1
+  for MAP_OUTPOST, 2 for MAP_STAR, then companies from 3).  Then come
+  each company's on_map flag, share price and return, shares issued and
+  maximum shares, and each player's name (its length,
+  then its wide characters), cash, debt, in_game flag and shares owned.
+  Floating-point numbers are stored as one byte giving the number of
+  trailing zero bits (DOUBLE_ZERO_BITS if zero), then a varint with the
+  remaining bits; round numbers such as INITIAL_CASH are thus short.
+
+  Each move record starts with the selection made times two, plus one if
+  Stock Exchange actions follow.  If so, the number of actions comes
+  next, then each action: its type (REPLAY_ACTION_xxx) plus four times
+  the company number, then for trades the change in shares owned
+  (zigzag-encoded, so small sales are as short as small purchases), and
+  for the Bank the amount in cents times two, or one followed by the
+  eight bytes of the amount (least significant first) if it is not a
+  whole number of cents.
+
+  The index holds the number of moves in the replay and the number of
+  keyframes, then for each keyframe the number of moves before it, its
+  turn number and the offset of its record.
+
+  Anything that happens at random, such as price changes, mergers and
+  bankruptcies, is not stored: it follows from the state of the random
+  number generator and the moves made.  To show the game at any point,
+  the nearest keyframe before it is read, then the moves after it are
+  processed again (with replaying set to true) up to that point.  A
+  whole game typically takes a few kilobytes, about the same as a single
+  saved game.
+*/
+
+
+/************************************************************************
+*                        Module-specific macros                         *
+************************************************************************/
+
+#define REPLAY_MAGIC		"STRRPL01"	// Start of every game replay
+#define REPLAY_INDEX_MAGIC	"STRRIX01"	// End of every game replay
+#define REPLAY_MAGIC_LEN	8		// Length of both magic strings
+#define REPLAY_TRAILER_LEN	16		// Index offset and index magic
+
+#define REPLAY_KEYFRAME_TURNS	10		// Turns between keyframes
+#define REPLAY_KEYFRAME_TAG	((SEL_QUIT + 1) * 2)	// First non-move tag
+
+#define DOUBLE_ZERO_BITS	64		// Trailing zeros if value is 0.0
+#define MAP_CODES		16		// Codes for galaxy map values
+
+// Types of Stock Exchange actions in a move record
+#define REPLAY_ACTION_TRADE	0
+#define REPLAY_ACTION_BID	1
+#define REPLAY_ACTION_BORROW	2
+#define REPLAY_ACTION_REPAY	3
+#define REPLAY_ACTION_TYPES	4
+
+
+/************************************************************************
+*                   Module-specific type declarations                   *
+************************************************************************/
+
+// A game replay being viewed
+typedef struct replay_view {
+    const char		*filename;	// Name of the replay, for messages
+    replay_reader_t	rd;		// Position within the replay
+    replay_keyframe_t	*kf;		// Keyframes, from replay_read_index()
+    size_t		num_kf;		// Number of keyframes
+    uint64_t		num_moves;	// Number of moves in the replay
+    uint64_t		pos;		// Moves made to reach the game shown
+} replay_view_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static bool replay_recording = false;	// True if recording a replay
+static byte_buf_t replay_buf;		// Replay recorded so far
+
+static bool move_pending = false;	// Move not yet added to replay_buf
+static selection_t pending_selection;	// ... the selection made
+static byte_buf_t pending_actions;	// ... and actions since then
+static unsigned int num_pending_actions;
+
+static replay_keyframe_t *keyframes = NULL;	// Keyframes recorded so far
+static size_t num_keyframes = 0;
+static size_t alloc_keyframes = 0;
+static uint64_t num_moves = 0;		// Moves recorded so far
+static byte_buf_t state_buf;		// Game state for a keyframe
+static byte_buf_t record_buf;		// ... and the whole keyframe record
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   put_double - Append a floating-point number to a buffer
+  Parameters: buf        - Buffer to append to
+              val        - Value to append
+  Returns:    (nothing)
+*/
+static void put_double (byte_buf_t *buf, double val);
+
+
+/*
+  Function:   get_double - Read a floating-point number
+  Parameters: p          - Pointer to current position (updated)
+              end        - End of the available data
+              val        - Resulting value (output)
+  Returns:    bool       - True if a valid number was read
+*/
+static bool get_double (const unsigned char **restrict p,
+			const unsigned char *restrict end,
+			double *restrict val);
+
+
+/*
+  Function:   put_amount - Append a monetary amount to a buffer
+  Function:   get_amount - Read a monetary amount
+  Parameters: buf        - Buffer to append to
+              p          - Pointer to current position (updated)
+              end        - End of the available data
+              val        - Value to append, or resulting value (output)
+  Returns:    bool       - True if a valid amount was read
+*/
+static void put_amount (byte_buf_t *buf, double val);
+static bool get_amount (const unsigned char **restrict p,
+			const unsigned char *restrict end,
+			double *restrict val);
+
+
+/*
+  Function:   put_state - Append the current game state to a buffer
+  Parameters: buf       - Buffer to append to
+  Returns:    (nothing)
+*/
+static void put_state (byte_buf_t *buf);
+
+
+/*
+  Function:   put_keyframe - Add a keyframe record to the replay
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function appends a keyframe record with the current game state to
+  the replay being recorded, and adds it to keyframes[].
+*/
+static void put_keyframe (void);
+
+
+/*
+  Function:   apply_actions - Process the actions of a move again
+  Parameters: rd            - Reader, just after a REPLAY_MOVE event
+  Returns:    bool          - True if all actions could be read
+
+  This function reads the Stock Exchange actions that follow a move and
+  makes them again on behalf of the current player.
+*/
+static bool apply_actions (replay_reader_t *rd);
+
+
+/*
+  Function:   view_goto_move - Go to a given move of a replay being viewed
+  Parameters: view           - Replay being viewed
+              move           - Number of moves to have been made
+  Returns:    (nothing)
+
+  This function sets the game state to that after move moves have been
+  made, starting from the current state if possible and from the nearest
+  keyframe otherwise.  The program is terminated with a message if the
+  replay is corrupt.
+*/
+static void view_goto_move (replay_view_t *view, uint64_t move);
+
+
+/*
+  Function:   view_goto_turn - Go to a given turn of a replay being viewed
+  Parameters: view           - Replay being viewed
+              turn           - Turn number to go to
+  Returns:    (nothing)
+
+  This function sets the game state to that at the start of turn turn,
+  or to the end of the replay if that turn was never reached.
+*/
+static void view_goto_turn (replay_view_t *view, int turn);
+
+
+/*
+  Function:   view_step - Process the next move of a replay being viewed
+  Parameters: view      - Replay being viewed
+  Returns:    (nothing)
+*/
+static void view_step (replay_view_t *view);
+
+
+/*
+  Function:   view_show - Show the game state of a replay being viewed
+  Parameters: view      - Replay being viewed
+  Returns:    (nothing)
+
+  This function shows the galaxy map with the moves that were offered to
+  the current player and the move they selected, then leaves the map and
+  a window for the viewer's commands open.
+*/
+static void view_show (replay_view_t *view);
+
+
+/*
+  Function:   record_action - Record a Stock Exchange action
+  Parameters: type          - Type of action (REPLAY_ACTION_xxx)
+              num           - Company number, or 0
+  Returns:    byte_buf_t *  - Buffer for any further details, or NULL
+
+  This function adds the type of action to the pending move, returning
+  NULL if no replay is being recorded.
+*/
+static byte_buf_t *record_action (int type, int num);
+
+
+/*
+  Function:   flush_move - Add the pending move to the replay
+  Parameters: (none)
+  Returns:    (nothing)
+*/
+static void flush_move (void);
+
+
+/************************************************************************
+*                   Game replay function definitions                    *
+************************************************************************/
+
+/* These functions are documented either in the file "replay.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// replay_start: Start recording a game replay
+
+void replay_start (void)
+{
+    if (option_replay == NULL) {
+	return;
+    }
+
+    replay_buf.len = 0;
+    pending_actions.len = 0;
+    num_pending_actions = 0;
+    move_pending = false;
+    num_keyframes = 0;
+    num_moves = 0;
+
+    put_bytes(&replay_buf, REPLAY_MAGIC, REPLAY_MAGIC_LEN);
+    put_keyframe();
+
+    replay_recording = true;
+}
+
+
+/***********************************************************************/
+// replay_record_keyframe: Record the game state if a keyframe is due
+
+void replay_record_keyframe (void)
+{
+    if (! replay_recording) {
+	return;
+    }
+
+    if (turn_number >= keyframes[num_keyframes - 1].turn
+	+ REPLAY_KEYFRAME_TURNS) {
+	flush_move();
+	put_keyframe();
+    }
+}
+
+
+/***********************************************************************/
+// replay_record_move: Record a selection in the game replay
+
+void replay_record_move (selection_t selection)
+{
+    if (! replay_recording) {
+	return;
+    }
+
+    flush_move();
+
+    assert(selection >= 0 && selection <= SEL_QUIT);
+    pending_selection = selection;
+    move_pending = true;
+    num_moves++;
+}
+
+
+/***********************************************************************/
+// replay_record_trade: Record a trade in the game replay
+
+void replay_record_trade (int num, long int shares)
+{
+    byte_buf_t *buf = record_action(REPLAY_ACTION_TRADE, num);
+
+
+    if (buf != NULL) {
+	uint64_t d = (int64_t) shares;
+
+	// Zigzag encoding: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+	put_varint(buf, (d << 1) ^ (0 - (d >> 63)));
+    }
+}
+
+
+/***********************************************************************/
+// replay_record_bid: Record a bid in the game replay
+
+void replay_record_bid (int num)
+{
+    record_action(REPLAY_ACTION_BID, num);
+}
+
+
+/***********************************************************************/
+// replay_record_borrow: Record a loan in the game replay
+
+void replay_record_borrow (double amount)
+{
+    byte_buf_t *buf = record_action(REPLAY_ACTION_BORROW, 0);
+
+
+    if (buf != NULL) {
+	put_amount(buf, amount);
+    }
+}
+
+
+/***********************************************************************/
+// replay_record_repay: Record a repayment in the game replay
+
+void replay_record_repay (double amount)
+{
+    byte_buf_t *buf = record_action(REPLAY_ACTION_REPAY, 0);
+
+
+    if (buf != NULL) {
+	put_amount(buf, amount);
+    }
+}
+
+
+/***********************************************************************/
+// replay_save: Write out the game replay
+
+void replay_save (void)
+{
+    const char *filename = option_replay;
+    unsigned char trailer[REPLAY_TRAILER_LEN];
+    uint64_t index_off;
+    FILE *file;
+
+
+    if (! replay_recording || abort_game) {
+	return;
+    }
+
+    flush_move();
+
+    // Add the index and trailer
+    index_off = replay_buf.len;
+
+    put_varint(&replay_buf, num_moves);
+    put_varint(&replay_buf, num_keyframes);
+    for (size_t n = 0; n < num_keyframes; n++) {
+	put_varint(&replay_buf, keyframes[n].move);
+	put_varint(&replay_buf, keyframes[n].turn);
+	put_varint(&replay_buf, keyframes[n].offset);
+    }
+
+    for (int i = 0; i < 8; i++) {
+	trailer[i] = (index_off >> (i * 8)) & 0xFF;
+    }
+    memcpy(trailer + 8, REPLAY_INDEX_MAGIC, REPLAY_MAGIC_LEN);
+    put_bytes(&replay_buf, trailer, REPLAY_TRAILER_LEN);
+
+    file = fopen(filename, "wb");
+    if (file == NULL) {
+	errno_exit("%s", filename);
+    }
+
+    if (fwrite(replay_buf.data, 1, replay_buf.len, file) != replay_buf.len) {
+	errno_exit("%s", filename);
+    }
+
+    if (fclose(file) == EOF) {
+	errno_exit("%s", filename);
+    }
+
+    replay_recording = false;
+}
+
+
+/***********************************************************************/
+// replay_reader_init: Start reading a game replay
+
+bool replay_reader_init (replay_reader_t *restrict rd,
+			 const void *restrict data, size_t len)
+{
+    const unsigned char *trailer;
+    uint64_t index_off = 0;
+
+
+    rd->data = data;
+    rd->p = rd->data;
+    rd->end = rd->data + len;
+    rd->index_end = rd->end;
+    rd->actions_left = 0;
+
+    if (len < REPLAY_MAGIC_LEN + REPLAY_TRAILER_LEN
+	|| memcmp(data, REPLAY_MAGIC, REPLAY_MAGIC_LEN) != 0) {
+	return false;
+    }
+
+    trailer = rd->data + len - REPLAY_TRAILER_LEN;
+    if (memcmp(trailer + 8, REPLAY_INDEX_MAGIC, REPLAY_MAGIC_LEN) != 0) {
+	return false;
+    }
+    for (int i = 0; i < 8; i++) {
+	index_off |= (uint64_t) trailer[i] << (i * 8);
+    }
+    if (index_off < REPLAY_MAGIC_LEN || index_off > len - REPLAY_TRAILER_LEN) {
+	return false;
+    }
+
+    rd->p += REPLAY_MAGIC_LEN;
+    rd->end = rd->data + index_off;
+    rd->index_end = trailer;
+    return true;
+}
+
+
+/***********************************************************************/
+// replay_read_index: Read the keyframe index of a game replay
+
+replay_keyframe_t *replay_read_index (const replay_reader_t *rd,
+				      size_t *restrict num,
+				      uint64_t *restrict nmoves)
+{
+    const unsigned char *p = rd->end;
+    replay_keyframe_t *kf;
+    uint64_t n, move, turn, offset;
+
+
+    if (   ! get_varint(&p, rd->index_end, nmoves)
+	|| ! get_varint(&p, rd->index_end, &n)
+	|| n < 1 || n > (uint64_t) (rd->index_end - p) / 3) {
+	return NULL;
+    }
+
+    kf = xmalloc(n * sizeof(replay_keyframe_t));
+    for (size_t i = 0; i < n; i++) {
+	if (   ! get_varint(&p, rd->index_end, &move)
+	    || ! get_varint(&p, rd->index_end, &turn)
+	    || ! get_varint(&p, rd->index_end, &offset)
+	    || move > *nmoves || turn < 1 || turn > INT_MAX
+	    || offset < REPLAY_MAGIC_LEN
+	    || offset >= (uint64_t) (rd->end - rd->data)
+	    || (i == 0 && move != 0)
+	    || (i > 0 && (move < kf[i - 1].move || turn < kf[i - 1].turn))) {
+	    free(kf);
+	    return NULL;
+	}
+
+	kf[i].move = move;
+	kf[i].turn = turn;
+	kf[i].offset = offset;
+    }
+
+    *num = n;
+    return kf;
+}
+
+
+/***********************************************************************/
+// replay_seek: Go to a keyframe of a game replay
+
+bool replay_seek (replay_reader_t *restrict rd,
+		  const replay_keyframe_t *restrict kf)
+{
+    rd->p = rd->data + kf->offset;
+    rd->actions_left = 0;
+
+    return replay_read_state(rd);
+}
+
+
+/***********************************************************************/
+// replay_read_state: Read the game state of a game replay
+
+bool replay_read_state (replay_reader_t *rd)
+{
+    const unsigned char *end;
+    wchar_t *buf;
+    uint64_t v, run;
+    unsigned short int rand_state[3];
+    int i, j;
+
+
+    if (   ! get_varint(&rd->p, rd->end, &v) || v != REPLAY_KEYFRAME_TAG
+	|| ! get_varint(&rd->p, rd->end, &v)
+	|| v > (uint64_t) (rd->end - rd->p)) {
+	return false;
+    }
+    end = rd->p + v;
+
+    if (! get_varint(&rd->p, end, &v) || v < 1 || v > INT_MAX) {
+	return false;
+    }
+    turn_number = v;
+
+    if (! get_varint(&rd->p, end, &v) || v < 1 || v > INT_MAX) {
+	return false;
+    }
+    max_turn = v;
+
+    if (! get_varint(&rd->p, end, &v) || v < 1 || v > MAX_PLAYERS) {
+	return false;
+    }
+    number_players = v;
+
+    if (! get_varint(&rd->p, end, &v) || v >= (uint64_t) number_players) {
+	return false;
+    }
+    first_player = v;
+
+    if (! get_varint(&rd->p, end, &v) || v >= (uint64_t) number_players) {
+	return false;
+    }
+    current_player = v;
+
+    if (! get_varint(&rd->p, end, &v) || v >= (uint64_t) 1 << 48) {
+	return false;
+    }
+    for (i = 0; i < 3; i++) {
+	rand_state[i] = (v >> (i * 16)) & 0xFFFF;
+    }
+    set_rand_state(rand_state);
+
+    if (! get_double(&rd->p, end, &interest_rate)) {
+	return false;
+    }
+
+    // Galaxy map, as runs of equal values
+    for (i = 0; i < MAX_X * MAX_Y; i += run + 1) {
+	map_val_t m;
+
+	if (! get_varint(&rd->p, end, &v)) {
+	    return false;
+	}
+
+	run = v / MAP_CODES;
+	if (run >= (uint64_t) (MAX_X * MAX_Y - i)) {
+	    return false;
+	}
+
+	switch (v % MAP_CODES) {
+	case 0:
+	    m = MAP_EMPTY;
+	    break;
+	case 1:
+	    m = MAP_OUTPOST;
+	    break;
+	case 2:
+	    m = MAP_STAR;
+	    break;
+	default:
+	    if (v % MAP_CODES - 3 >= MAX_COMPANIES) {
+		return false;
+	    }
+	    m = COMPANY_TO_MAP(v % MAP_CODES - 3);
+	}
+
+	for (j = i; j <= i + (int) run; j++) {
+	    galaxy_map[j / MAX_Y][j % MAX_Y] = m;
+	}
+    }
+
+    // Company data, replacing all names from any earlier state
+    clear_names();
+    for (i = 0; i < MAX_COMPANIES; i++) {
+	company[i].name = intern_name(company_wname(i), NULL);
+
+	if (! get_varint(&rd->p, end, &v) || v > 1) {
+	    return false;
+	}
+	company[i].on_map = v;
+
+	if (   ! get_double(&rd->p, end, &company[i].share_price)
+	    || ! get_double(&rd->p, end, &company[i].share_return)) {
+	    return false;
+	}
+
+	if (! get_varint(&rd->p, end, &v) || v > LONG_MAX) {
+	    return false;
+	}
+	company[i].stock_issued = v;
+
+	if (! get_varint(&rd->p, end, &v) || v > LONG_MAX) {
+	    return false;
+	}
+	company[i].max_stock = v;
+    }
+
+    // Player data
+    buf = xmalloc(BUFSIZE * sizeof(wchar_t));
+    for (i = 0; i < number_players; i++) {
+	uint64_t len;
+
+	if (! get_varint(&rd->p, end, &len) || len < 1 || len >= BUFSIZE) {
+	    free(buf);
+	    return false;
+	}
+	for (j = 0; j < (int) len; j++) {
+	    if (! get_varint(&rd->p, end, &v) || v == 0 || v > WCHAR_MAX) {
+		free(buf);
+		return false;
+	    }
+	    buf[j] = v;
+	}
+	buf[j] = L'\0';
+
+	player[i].name = intern_name(buf, NULL);
+
+	if (   ! get_double(&rd->p, end, &player[i].cash)
+	    || ! get_double(&rd->p, end, &player[i].debt)) {
+	    free(buf);
+	    return false;
+	}
+
+	if (! get_varint(&rd->p, end, &v) || v > 1) {
+	    free(buf);
+	    return false;
+	}
+	player[i].in_game = v;
+
+	for (j = 0; j < MAX_COMPANIES; j++) {
+	    if (! get_varint(&rd->p, end, &v) || v > LONG_MAX) {
+		free(buf);
+		return false;
+	    }
+	    player[i].stock_owned[j] = v;
+	}
+    }
+    free(buf);
+
+    quit_selected = false;
+    abort_game = false;
+
+    return rd->p == end;
+}
+
+
+/***********************************************************************/
+// replay_save_state: Save the game state to memory
+
+const void *replay_save_state (size_t *restrict len)
+{
+    state_buf.len = 0;
+    put_state(&state_buf);
+
+    record_buf.len = 0;
+    put_varint(&record_buf, REPLAY_KEYFRAME_TAG);
+    put_varint(&record_buf, state_buf.len);
+    put_bytes(&record_buf, state_buf.data, state_buf.len);
+
+    *len = record_buf.len;
+    return record_buf.data;
+}
+
+
+/***********************************************************************/
+// replay_load_state: Restore the game state from memory
+
+bool replay_load_state (const void *restrict data, size_t len)
+{
+    replay_reader_t rd;
+
+
+    rd.data = data;
+    rd.p = rd.data;
+    rd.end = rd.data + len;
+    rd.index_end = rd.end;
+    rd.actions_left = 0;
+
+    return replay_read_state(&rd) && rd.p == rd.end;
+}
+
+
+/***********************************************************************/
+// replay_next_event: Read the next event of a game replay
+
+bool replay_next_event (replay_reader_t *restrict rd,
+			replay_event_t *restrict ev)
+{
+    uint64_t v;
+
+
+    memset(ev, 0, sizeof(*ev));
+
+    if (rd->actions_left == 0) {
+	// Start of a move record, or the end of the replay
+	if (rd->p == rd->end) {
+	    ev->type = REPLAY_END;
+	    return true;
+	}
+
+	if (! get_varint(&rd->p, rd->end, &v)) {
+	    return false;
+	}
+
+	if (v == REPLAY_KEYFRAME_TAG) {
+	    // Skip over the game state
+	    if (   ! get_varint(&rd->p, rd->end, &v)
+		|| v > (uint64_t) (rd->end - rd->p)) {
+		return false;
+	    }
+	    rd->p += v;
+	    ev->type = REPLAY_KEYFRAME;
+	    return true;
+	}
+
+	if ((v >> 1) > SEL_QUIT || (v >> 1) == SEL_SAVE) {
+	    return false;
+	}
+	ev->type = REPLAY_MOVE;
+	ev->selection = v >> 1;
+
+	if ((v & 1) != 0) {
+	    if (! get_varint(&rd->p, rd->end, &v) || v < 1 || v > UINT_MAX) {
+		return false;
+	    }
+	    rd->actions_left = v;
+	}
+
+	return true;
+    }
+
+    // A Stock Exchange action within the current move record
+    if (! get_varint(&rd->p, rd->end, &v)
+	|| v / REPLAY_ACTION_TYPES >= MAX_COMPANIES) {
+	return false;
+    }
+    ev->company = v / REPLAY_ACTION_TYPES;
+    rd->actions_left--;
+
+    switch (v % REPLAY_ACTION_TYPES) {
+    case REPLAY_ACTION_TRADE:
+	ev->type = REPLAY_TRADE;
+	if (! get_varint(&rd->p, rd->end, &v)) {
+	    return false;
+	}
+	ev->shares = (int64_t) ((v >> 1) ^ (0 - (v & 1)));
+	break;
+
+    case REPLAY_ACTION_BID:
+	ev->type = REPLAY_BID;
+	break;
+
+    case REPLAY_ACTION_BORROW:
+	ev->type = REPLAY_BORROW;
+	return get_amount(&rd->p, rd->end, &ev->amount);
+
+    case REPLAY_ACTION_REPAY:
+	ev->type = REPLAY_REPAY;
+	return get_amount(&rd->p, rd->end, &ev->amount);
+    }
+
+    return true;
+}
+
+
+/***********************************************************************/
+// replay_step: Process the next move of a game replay again
+
+bool replay_step (replay_reader_t *rd)
+{
+    replay_event_t ev;
+    bool ok;
+
+
+    do {
+	if (! replay_next_event(rd, &ev)) {
+	    return false;
+	}
+    } while (ev.type == REPLAY_KEYFRAME);
+
+    if (ev.type != REPLAY_MOVE) {
+	return false;
+    }
+
+    replaying = true;
+
+    select_moves();
+    process_move(ev.selection);
+    ok = apply_actions(rd);
+    next_player();
+
+    replaying = false;
+    return ok;
+}
+
+
+/***********************************************************************/
+// replay_view: View a game replay
+
+void replay_view (const char *filename)
+{
+    replay_view_t view;
+    struct stat statbuf;
+    void *data;
+    int fd;
+    bool done;
+
+
+    // Map the whole replay into memory
+    fd = open(filename, O_RDONLY);
+    if (fd == -1 || fstat(fd, &statbuf) != 0) {
+	errno_exit("%s", filename);
+    }
+    if (statbuf.st_size < REPLAY_MAGIC_LEN + REPLAY_TRAILER_LEN) {
+	err_exit(_("%s: not a game replay"), filename);
+    }
+
+    data = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+	errno_exit("%s", filename);
+    }
+    close(fd);
+
+    memset(&view, 0, sizeof(view));
+    view.filename = filename;
+
+    if (! replay_reader_init(&view.rd, data, statbuf.st_size)) {
+	err_exit(_("%s: not a game replay"), filename);
+    }
+
+    view.kf = replay_read_index(&view.rd, &view.num_kf, &view.num_moves);
+    if (view.kf == NULL || ! replay_seek(&view.rd, &view.kf[0])) {
+	err_exit(_("%s: corrupt game replay"), filename);
+    }
+
+    done = false;
+    while (! done) {
+	wint_t key;
+	int w;
+
+	view_show(&view);
+	w = getmaxx(curwin);
+
+	if (gettxchar(curwin, &key) == OK) {
+	    // Ordinary wide character
+	    if (key >= L'1' && key < (wint_t) L'1' + number_players) {
+		show_status(key - L'1');
+	    } else if (key == L' ') {
+		view_goto_move(&view, MIN(view.pos + 1, view.num_moves));
+	    } else {
+		beep();
+	    }
+	} else {
+	    // Function or control key
+	    switch (key) {
+	    case KEY_RIGHT:
+		view_goto_move(&view, MIN(view.pos + 1, view.num_moves));
+		break;
+
+	    case KEY_LEFT:
+	    case KEY_BS:
+	    case KEY_BACKSPACE:
+		view_goto_move(&view, (view.pos == 0) ? 0 : view.pos - 1);
+		break;
+
+	    case KEY_DOWN:
+	    case KEY_NPAGE:
+		view_goto_turn(&view, turn_number + 1);
+		break;
+
+	    case KEY_UP:
+	    case KEY_PPAGE:
+		view_goto_turn(&view, turn_number - 1);
+		break;
+
+	    case KEY_HOME:
+		view_goto_move(&view, 0);
+		break;
+
+	    case KEY_END:
+		view_goto_move(&view, view.num_moves);
+		break;
+
+	    case KEY_ENTER:
+	    case KEY_CTRL('J'):
+	    case KEY_CTRL('M'):
+		// Ask which turn to go to
+		{
+		    scratch_mark_t mark = scratch_mark();
+		    chtype *chbuf = scratch_alloc(BUFSIZE * sizeof(chtype));
+		    int width, first = view.kf[0].turn;
+		    long int val;
+
+		    mvwhline(curwin, 3, 2, ' ' | attr_normal, w - 4);
+		    mkchstr(chbuf, BUFSIZE, attr_normal, attr_highlight, 0, 1,
+			    w - REPLAY_TURN_COLS - 6, &width, 1,
+			    _("Go to turn [^{%d^}-^{%d^}]: "), first,
+			    MAX(first, max_turn));
+		    leftch(curwin, 3, 2, chbuf, 1, &width);
+		    scratch_release(mark);
+
+		    curs_set(CURS_ON);
+		    if (gettxlong(curwin, &val, first, MAX(first, max_turn),
+				  turn_number, turn_number, 3, width + 2,
+				  REPLAY_TURN_COLS, attr_input_field) == OK) {
+			view_goto_turn(&view, val);
+		    }
+		    curs_set(CURS_OFF);
+		}
+		break;
+
+	    case KEY_ESC:
+	    case KEY_CANCEL:
+	    case KEY_EXIT:
+	    case KEY_CTRL('C'):
+	    case KEY_CTRL('G'):
+	    case KEY_CTRL('\\'):
+		done = true;
+		break;
+
+	    default:
+		beep();
+	    }
+	}
+
+	deltxwin();			// Viewer commands window
+	deltxwin();			// Galaxy map window
+	txrefresh();
+    }
+
+    free(view.kf);
+    munmap(data, statbuf.st_size);
+}
+
+
+/***********************************************************************/
+// put_double: Append a floating-point number to a buffer
+
+void put_double (byte_buf_t *buf, double val)
+{
+    uint64_t x;
+    unsigned char tz = 0;
+
+
+    assert(sizeof(x) == sizeof(val));
+    memcpy(&x, &val, sizeof(x));
+
+    if (x == 0) {
+	tz = DOUBLE_ZERO_BITS;
+	put_bytes(buf, &tz, 1);
+    } else {
+	while ((x & 1) == 0) {
+	    x >>= 1;
+	    tz++;
+	}
+	put_bytes(buf, &tz, 1);
+	put_varint(buf, x);
+    }
+}
+
+
+/***********************************************************************/
+// get_double: Read a floating-point number
+
+bool get_double (const unsigned char **restrict p,
+		 const unsigned char *restrict end, double *restrict val)
+{
+    uint64_t x = 0;
+    unsigned char tz;
+
+
+    if (*p >= end) {
+	return false;
+    }
+
+    tz = *(*p)++;
+    if (tz == DOUBLE_ZERO_BITS) {
+	x = 0;
+    } else if (tz < DOUBLE_ZERO_BITS && get_varint(p, end, &x)) {
+	x <<= tz;
+    } else {
+	return false;
+    }
+
+    memcpy(val, &x, sizeof(x));
+    return true;
+}
+
+
+/***********************************************************************/
+// put_amount: Append a monetary amount to a buffer
+
+void put_amount (byte_buf_t *buf, double val)
+{
+    uint64_t cents = 0;
+
+
+    if (val >= 0.0 && val < (double) ((uint64_t) 1 << 48)) {
+	cents = val * 100.0 + 0.5;
+    }
+
+    if ((double) cents / 100.0 == val) {
+	put_varint(buf, cents << 1);
+    } else {
+	unsigned char tmp[8];
+	uint64_t x;
+
+	memcpy(&x, &val, sizeof(x));
+	for (int i = 0; i < 8; i++) {
+	    tmp[i] = (x >> (i * 8)) & 0xFF;
+	}
+
+	put_varint(buf, 1);
+	put_bytes(buf, tmp, sizeof(tmp));
+    }
+}
+
+
+/***********************************************************************/
+// get_amount: Read a monetary amount
+
+bool get_amount (const unsigned char **restrict p,
+		 const unsigned char *restrict end, double *restrict val)
+{
+    uint64_t v;
+
+
+    if (! get_varint(p, end, &v)) {
+	return false;
+    }
+
+    if ((v & 1) == 0) {
+	*val = (double) (v >> 1) / 100.0;
+    } else {
+	uint64_t x = 0;
+
+	if (v != 1 || end - *p < 8) {
+	    return false;
+	}
+	for (int i = 0; i < 8; i++) {
+	    x |= (uint64_t) *(*p)++ << (i * 8);
+	}
+	memcpy(val, &x, sizeof(x));
+    }
+
+    return true;
+}
+
+
+/***********************************************************************/
+// put_state: Append the current game state to a buffer
+
+void put_state (byte_buf_t *buf)
+{
+    unsigned short int rand_state[3];
+    int i, j, run, code;
+
+
+    put_varint(buf, turn_number);
+    put_varint(buf, max_turn);
+    put_varint(buf, number_players);
+    put_varint(buf, first_player);
+    put_varint(buf, current_player);
+
+    get_rand_state(rand_state);
+    put_varint(buf, (uint64_t) rand_state[0]
+	       | (uint64_t) rand_state[1] << 16
+	       | (uint64_t) rand_state[2] << 32);
+
+    put_double(buf, interest_rate);
+
+    // Galaxy map, as runs of equal values
+    for (i = 0; i < MAX_X * MAX_Y; i += run + 1) {
+	map_val_t m = galaxy_map[i / MAX_Y][i % MAX_Y];
+
+	for (run = 0; i + run + 1 < MAX_X * MAX_Y; run++) {
+	    j = i + run + 1;
+	    if (galaxy_map[j / MAX_Y][j % MAX_Y] != m) {
+		break;
+	    }
+	}
+
+	switch (m) {
+	case MAP_EMPTY:
+	    code = 0;
+	    break;
+	case MAP_OUTPOST:
+	    code = 1;
+	    break;
+	case MAP_STAR:
+	    code = 2;
+	    break;
+	default:
+	    assert(IS_MAP_COMPANY(m));
+	    code = MAP_TO_COMPANY(m) + 3;
+	}
+
+	put_varint(buf, (uint64_t) run * MAP_CODES + code);
+    }
+
+    // Company data
+    for (i = 0; i < MAX_COMPANIES; i++) {
+	put_varint(buf, company[i].on_map);
+	put_double(buf, company[i].share_price);
+	put_double(buf, company[i].share_return);
+	put_varint(buf, company[i].stock_issued);
+	put_varint(buf, company[i].max_stock);
+    }
+
+    // Player data
+    for (i = 0; i < number_players; i++) {
+	const wchar_t *name = name_wcs(player[i].name);
+	size_t len = wcslen(name);
+
+	put_varint(buf, len);
+	for (size_t n = 0; n < len; n++) {
+	    put_varint(buf, (uint64_t) name[n]);
+	}
+
+	put_double(buf, player[i].cash);
+	put_double(buf, player[i].debt);
+	put_varint(buf, player[i].in_game);
+
+	for (j = 0; j < MAX_COMPANIES; j++) {
+	    put_varint(buf, player[i].stock_owned[j]);
+	}
+    }
+}
+
+
+/***********************************************************************/
+// put_keyframe: Add a keyframe record to the replay
+
+void put_keyframe (void)
+{
+    const void *state;
+    size_t len;
+
+
+    if (num_keyframes == alloc_keyframes) {
+	alloc_keyframes = (alloc_keyframes == 0) ? 16 : alloc_keyframes * 2;
+	keyframes = xrealloc(keyframes,
+			     alloc_keyframes * sizeof(replay_keyframe_t));
+    }
+
+    keyframes[num_keyframes].move   = num_moves;
+    keyframes[num_keyframes].turn   = turn_number;
+    keyframes[num_keyframes].offset = replay_buf.len;
+    num_keyframes++;
+
+    state = replay_save_state(&len);
+    put_bytes(&replay_buf, state, len);
+}
+
+
+/***********************************************************************/
+// apply_actions: Process the actions of a move again
+
+bool apply_actions (replay_reader_t *rd)
+{
+    replay_event_t ev;
+
+
+    while (rd->actions_left > 0) {
+	if (! replay_next_event(rd, &ev)) {
+	    return false;
+	}
+
+	switch (ev.type) {
+	case REPLAY_TRADE:
+	    trade_stock(ev.company, ev.shares);
+	    break;
+
+	case REPLAY_BID:
+	    bid_for_stock(ev.company);
+	    break;
+
+	case REPLAY_BORROW:
+	    borrow_money(ev.amount);
+	    break;
+
+	case REPLAY_REPAY:
+	    repay_debt(ev.amount);
+	    break;
+
+	default:
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+
+/***********************************************************************/
+// view_goto_move: Go to a given move of a replay being viewed
+
+void view_goto_move (replay_view_t *view, uint64_t move)
+{
+    size_t k;
+
+
+    assert(move <= view->num_moves);
+
+    // Find the last keyframe at or before that move
+    for (k = view->num_kf - 1; k > 0 && view->kf[k].move > move; k--)
+	;
+
+    if (view->pos > move || view->pos < view->kf[k].move) {
+	if (! replay_seek(&view->rd, &view->kf[k])) {
+	    err_exit(_("%s: corrupt game replay"), view->filename);
+	}
+	view->pos = view->kf[k].move;
+    }
+
+    while (view->pos < move) {
+	view_step(view);
+    }
+}
+
+
+/***********************************************************************/
+// view_goto_turn: Go to a given turn of a replay being viewed
+
+void view_goto_turn (replay_view_t *view, int turn)
+{
+    size_t k;
+
+
+    // Find the last keyframe at or before that turn
+    for (k = view->num_kf - 1; k > 0 && view->kf[k].turn > turn; k--)
+	;
+
+    if (turn_number > turn || view->pos < view->kf[k].move) {
+	if (! replay_seek(&view->rd, &view->kf[k])) {
+	    err_exit(_("%s: corrupt game replay"), view->filename);
+	}
+	view->pos = view->kf[k].move;
+    }
+
+    while (view->pos < view->num_moves && turn_number < turn) {
+	view_step(view);
+    }
+}
+
+
+/***********************************************************************/
+// view_step: Process the next move of a replay being viewed
+
+void view_step (replay_view_t *view)
+{
+    if (! replay_step(&view->rd)) {
+	err_exit(_("%s: corrupt game replay"), view->filename);
+    }
+    view->pos++;
+}
+
+
+/***********************************************************************/
+// view_show: Show the game state of a replay being viewed
+
+void view_show (replay_view_t *view)
+{
+    selection_t selection = SEL_NONE;
+    bool offered = false;
+    int w;
+
+
+    if (view->pos < view->num_moves) {
+	replay_reader_t next = view->rd;
+	replay_event_t ev;
+	unsigned short int rand_state[3];
+
+	// Find the move that was selected next
+	do {
+	    if (! replay_next_event(&next, &ev)) {
+		err_exit(_("%s: corrupt game replay"), view->filename);
+	    }
+	} while (ev.type == REPLAY_KEYFRAME);
+	selection = ev.selection;
+
+	// Find the moves that were offered, without disturbing anything
+	get_rand_state(rand_state);
+	select_moves();
+	set_rand_state(rand_state);
+
+	offered = ! quit_selected;
+	quit_selected = false;
+    }
+
+    // Display map without closing window
+    show_map(false);
+
+    if (offered) {
+	for (int i = 0; i < NUMBER_MOVES; i++) {
+	    chtype *movestr = CHTYPE_GAME_MOVE(i);
+
+	    wmove(curwin, game_move[i].y + 3, game_move[i].x * 2 + 2);
+	    while (*movestr != 0) {
+		waddch(curwin, *movestr++);
+	    }
+	}
+    }
+    wrefresh(curwin);
+
+    // Show the viewer's commands
+    newtxwin(5, WIN_COLS, 19, WCENTER, true, attr_normal_window);
+    w = getmaxx(curwin);
+
+    left(curwin, 1, 2, attr_normal, attr_highlight, 0, 1,
+	 /* TRANSLATORS: This shows the position within a game replay,
+	    counted in moves.  The maximum width is 38 characters. */
+	 _("Move ^{%'ld^} of ^{%'ld^}"), (long int) view->pos,
+	 (long int) view->num_moves);
+
+    if (selection == SEL_NONE) {
+	right(curwin, 1, w - 2, attr_normal, attr_highlight, 0, 1,
+	      _("^{End of the game^}"));
+    } else if (selection == SEL_BANKRUPT) {
+	right(curwin, 1, w - 2, attr_normal, attr_highlight, 0, 1,
+	      _("Next: ^{Declare bankruptcy^}"));
+    } else if (selection == SEL_QUIT) {
+	right(curwin, 1, w - 2, attr_normal, attr_highlight, 0, 1,
+	      _("Next: ^{Quit the game^}"));
+    } else {
+	right(curwin, 1, w - 2, attr_normal, attr_choice, 0, 1,
+	      _("Next move: ^{%lc^}"),
+	      (wint_t) PRINTABLE_GAME_MOVE(selection));
+    }
+
+    left(curwin, 2, 2, attr_normal, attr_keycode, 0, 1,
+	 /* TRANSLATORS: Each label may be up to 37 characters wide.  The
+	    sequences "^{" and "^}" change the character rendition
+	    (attributes) and take up no space. */
+	 _("^{<LEFT>^}/^{<RIGHT>^} Previous/next move"));
+    left(curwin, 2, w / 2, attr_normal, attr_keycode, 0, 1,
+	 _("^{<UP>^}/^{<DOWN>^} Previous/next turn"));
+    if (number_players == 1) {
+	left(curwin, 3, 2, attr_normal, attr_keycode, 0, 1,
+	     _("^{<1>^} Display stock portfolio"));
+    } else {
+	left(curwin, 3, 2, attr_normal, attr_keycode, 0, 1,
+	     _("^{<1>^}-^{<%d>^} Display stock portfolio"), number_players);
+    }
+    left(curwin, 3, w / 2, attr_normal, attr_keycode, 0, 1,
+	 _("^{<ENTER>^} Turn  ^{<CTRL><C>^} Quit"));
+
+    wrefresh(curwin);
+}
+
+
+/***********************************************************************/
+// record_action: Record a Stock Exchange action
+
+byte_buf_t *record_action (int type, int num)
+{
+    if (! replay_recording) {
+	return NULL;
+    }
+
+    assert(move_pending);
+    assert(num >= 0 && num < MAX_COMPANIES);
+
+    put_varint(&pending_actions, type + num * REPLAY_ACTION_TYPES);
+    num_pending_actions++;
+
+    return &pending_actions;
+}
+
+
+/***********************************************************************/
+// flush_move: Add the pending move to the replay
+
+void flush_move (void)
+{
+    if (! move_pending) {
+	return;
+    }
+
+    if (num_pending_actions == 0) {
+	put_varint(&replay_buf, (uint64_t) pending_selection << 1);
+    } else {
+	put_varint(&replay_buf, ((uint64_t) pending_selection << 1) | 1);
+	put_varint(&replay_buf, num_pending_actions);
+	put_bytes(&replay_buf, pending_actions.data, pending_actions.len);
+    }
+
+    pending_actions.len = 0;
+    num_pending_actions = 0;
+    move_pending = false;
+}
+
+
+/***********************************************************************/
+// End of file
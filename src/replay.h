@@ -0,0 +1,282 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, replay.h, contains declarations for the game replay
+  functions used in Star Traders.  A replay holds the state of a game
+  when it started, followed by everything the players did: the move each
+  player selected and each trade they made.  As the game is otherwise
+  driven by the random number generator, whose state is included, this
+  is enough to play the game through again.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_REPLAY_H
+#define included_REPLAY_H 1
+
+
+/************************************************************************
+*                    Game replay constants and types                    *
+************************************************************************/
+
+// Types of events in a game replay
+typedef enum replay_event_type {
+    REPLAY_END = 0,			// No more events
+    REPLAY_MOVE,			// Selection made by the current player
+    REPLAY_TRADE,			// Shares bought or sold
+    REPLAY_BID,				// Bid for more shares to be issued
+    REPLAY_BORROW,			// Money borrowed from the Bank
+    REPLAY_REPAY,			// Debt repaid to the Bank
+    REPLAY_KEYFRAME			// Full game state (skipped over)
+} replay_event_type_t;
+
+// One event of a game replay
+typedef struct replay_event {
+    replay_event_type_t	type;
+    selection_t		selection;	// REPLAY_MOVE: selection made
+    int			company;	// REPLAY_TRADE, REPLAY_BID: company
+    long int		shares;		// REPLAY_TRADE: shares bought (> 0)
+					//   or sold (< 0)
+    double		amount;		// REPLAY_BORROW, REPLAY_REPAY: amount
+} replay_event_t;
+
+// Position within a game replay held in memory
+typedef struct replay_reader {
+    const unsigned char	*data;		// Start of the replay
+    const unsigned char	*p;		// Next byte to decode
+    const unsigned char	*end;		// End of the replay records
+    const unsigned char	*index_end;	// End of the keyframe index
+    unsigned int	actions_left;	// Trades left for the current move
+} replay_reader_t;
+
+// Entry in the keyframe index of a game replay
+typedef struct replay_keyframe {
+    uint64_t		move;		// Moves recorded before the keyframe
+    int			turn;		// Turn number at the keyframe
+    uint64_t		offset;		// Offset of the keyframe record
+} replay_keyframe_t;
+
+
+/************************************************************************
+*                    Game replay function prototypes                    *
+************************************************************************/
+
+/*
+  Function:   replay_start - Start recording a game replay
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function starts recording the current game, including its state
+  and that of the random number generator, if option_replay is not NULL.
+  It must be called after init_game() and before the first call to
+  select_moves().
+*/
+extern void replay_start (void);
+
+
+/*
+  Function:   replay_record_keyframe - Record the game state if needed
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function records the full state of the game as a keyframe if
+  enough turns have passed since the last one.  It must be called before
+  select_moves() for each move; it does nothing if no replay is being
+  recorded.
+*/
+extern void replay_record_keyframe (void);
+
+
+/*
+  Function:   replay_record_move - Record a selection in the game replay
+  Parameters: selection          - Selection returned by get_move()
+  Returns:    (nothing)
+
+  This function records the selection made by the current player.  It
+  does nothing if no replay is being recorded.
+*/
+extern void replay_record_move (selection_t selection);
+
+
+/*
+  Function:   replay_record_trade  - Record a trade in the game replay
+  Function:   replay_record_bid    - Record a bid in the game replay
+  Function:   replay_record_borrow - Record a loan in the game replay
+  Function:   replay_record_repay  - Record a repayment in the game replay
+  Parameters: num                  - Company traded with
+              shares               - Shares bought (> 0) or sold (< 0)
+              amount               - Amount borrowed or repaid
+  Returns:    (nothing)
+
+  These functions record what the current player did in the Stock
+  Exchange since the last call to replay_record_move().  A bid need only
+  be recorded if it used the random number generator.  These functions
+  do nothing if no replay is being recorded.
+*/
+extern void replay_record_trade (int num, long int shares);
+extern void replay_record_bid (int num);
+extern void replay_record_borrow (double amount);
+extern void replay_record_repay (double amount);
+
+
+/*
+  Function:   replay_save - Write out the game replay
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function writes the game replay to the file named by
+  option_replay, replacing any existing file.  Nothing is done if no
+  replay is being recorded or if the game was aborted.  On any error, the
+  program is terminated with an appropriate message.
+*/
+extern void replay_save (void);
+
+
+/*
+  Function:   replay_reader_init - Start reading a game replay
+  Parameters: rd                 - Reader to initialise
+              data               - Replay, as written by replay_save()
+              len                - Length of the replay in bytes
+  Returns:    bool               - True if data is a game replay
+
+  This function prepares rd for reading the replay in data, which must
+  remain in memory for as long as rd is used.  Many replays can be read
+  at once, as all decoding state is kept in rd.  The game state must
+  then be read with replay_read_state() before the events can be read.
+*/
+extern bool replay_reader_init (replay_reader_t *restrict rd,
+				const void *restrict data, size_t len);
+
+
+/*
+  Function:   replay_read_index - Read the keyframe index of a game replay
+  Parameters: rd                - Reader, after replay_reader_init()
+              num               - Number of keyframes (output)
+              nmoves            - Number of moves in the replay (output)
+  Returns:    replay_keyframe_t * - Keyframes, or NULL if corrupt
+
+  This function returns the keyframes of the replay in order, in an
+  array allocated with malloc().  The first keyframe is always the start
+  of the game.
+*/
+extern replay_keyframe_t *replay_read_index (const replay_reader_t *rd,
+					     size_t *restrict num,
+					     uint64_t *restrict nmoves);
+
+
+/*
+  Function:   replay_seek - Go to a keyframe of a game replay
+  Parameters: rd          - Reader
+              kf          - Keyframe, as returned by replay_read_index()
+  Returns:    bool        - True if the game state could be read
+
+  This function reads the game state at keyframe kf, as with
+  replay_read_state(), leaving rd positioned at the move after it.
+*/
+extern bool replay_seek (replay_reader_t *restrict rd,
+			 const replay_keyframe_t *restrict kf);
+
+
+/*
+  Function:   replay_read_state - Read the game state of a game replay
+  Parameters: rd                - Reader, at a keyframe record
+  Returns:    bool              - True if the state could be read
+
+  This function reads the keyframe record at rd and sets the global game
+  variables (galaxy_map, company[], player[], interest_rate and so on)
+  and the state of the random number generator from it.  Just after
+  replay_reader_init(), this is the state at the start of the replay.
+  If false is returned, those variables are left in an undefined state.
+*/
+extern bool replay_read_state (replay_reader_t *rd);
+
+
+/*
+  Function:   replay_save_state - Save the game state to memory
+  Parameters: len               - Length of the result in bytes (output)
+  Returns:    const void *      - Game state, as a keyframe record
+
+  This function returns the current game state, including the state of
+  the random number generator, as a keyframe record.  Only a few hundred
+  bytes are needed, so many games can be held in memory at once this
+  way.  The result is overwritten by the next call to this function.
+*/
+extern const void *replay_save_state (size_t *restrict len);
+
+
+/*
+  Function:   replay_load_state - Restore the game state from memory
+  Parameters: data              - State written by replay_save_state()
+              len               - Length of data in bytes
+  Returns:    bool              - True if the state could be restored
+
+  This function sets the global game variables from data, exactly as
+  replay_read_state() does for a keyframe of a replay.
+*/
+extern bool replay_load_state (const void *restrict data, size_t len);
+
+
+/*
+  Function:   replay_next_event - Read the next event of a game replay
+  Parameters: rd                - Reader
+              ev                - Event that was read (output)
+  Returns:    bool              - True if an event (or the end) was read
+
+  This function reads the next event from the replay.  Each REPLAY_MOVE
+  is followed by the trades, bids and Bank transactions made by the same
+  player.  At the end of the replay, ev->type is set to REPLAY_END.
+  False is returned if the replay is corrupt.
+*/
+extern bool replay_next_event (replay_reader_t *restrict rd,
+			       replay_event_t *restrict ev);
+
+
+/*
+  Function:   replay_step - Process the next move of a game replay again
+  Parameters: rd          - Reader, positioned at a move
+  Returns:    bool        - True if the move could be processed
+
+  This function makes the next move of the replay, together with its
+  trades, as if the current player had made it, without displaying
+  anything.  The game state must have been set by replay_read_state()
+  or replay_seek().  False is returned if the replay is corrupt or no
+  moves are left.
+*/
+extern bool replay_step (replay_reader_t *rd);
+
+
+/*
+  Function:   replay_view - View a game replay
+  Parameters: filename    - Name of the game replay
+  Returns:    (nothing)
+
+  This function lets the user step through the game replay filename,
+  move by move or turn by turn, or jump straight to any turn.  The
+  replay is mapped into memory rather than read.  On any error, the
+  program is terminated with an appropriate message.
+*/
+extern void replay_view (const char *filename);
+
+
+#endif /* included_REPLAY_H */
@@ -0,0 +1,1313 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, server.c, contains the implementation of the game server
+  used in Star Traders.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  Clients send one command per line and receive one or more lines in
+  reply, the last of which starts with "OK" or "ERR".  Commands must be
+  in upper case; players and seats are numbered from 1, and companies are
+  given by their letter on the galaxy map (A to H).  The commands are:
+
+    NEW players         Create a game; replies "OK game"
+    JOIN game seat name Take a seat in a game; the game starts once
+                        every seat has been taken.  The name may be
+                        left out to take a seat back after reconnecting
+    STATE               Show the game: TURN, BANK, MAP, COMPANY and
+                        PLAYER lines, then "OK"
+    MOVE letter         Make the move shown by letter (a to t) on MAP
+    BANKRUPT            Declare bankruptcy instead of moving
+    BUY company shares  Buy shares after moving
+    SELL company shares Sell shares after moving
+    BID company         Ask a company to issue more shares; replies
+                        "OK shares" with the number of shares issued
+    BORROW amount       Borrow money from the Bank after moving
+    REPAY amount        Repay debt to the Bank after moving
+    DONE                Leave the Stock Exchange, ending the turn
+    QUIT                Disconnect
+
+  Whenever the game moves on, every client in that game is sent a line
+  "TURN turn max_turn player phase", where phase is "move", "trade" or
+  "over".  All numbers are written and read with "." as the radix
+  character, whatever the locale.
+
+  A game that is over, or that is waiting for players but has been left
+  by everyone (including the client that created it), is kept only until
+  its number is needed for a new game.  At most SERVER_MAX_GAMES games
+  are hosted at once.
+
+  The state of each game is kept between commands as a keyframe record
+  written by replay_save_state(): a few hundred bytes, including the
+  state of its random number generator.  A command is carried out by
+  restoring that state into the global game variables, calling the same
+  functions used to replay a game (with replaying set to true, so
+  nothing is displayed), then saving the state again.  The server thus
+  uses little memory for each game, whether or not anyone is connected.
+*/
+
+
+/************************************************************************
+*                   Module-specific type declarations                   *
+************************************************************************/
+
+// Phases of a hosted game
+typedef enum game_phase {
+    PHASE_WAITING = 0,			// Waiting for every seat to be taken
+    PHASE_MOVE,				// Current player must select a move
+    PHASE_TRADE,			// Current player is in the Stock Exchange
+    PHASE_OVER				// Game has finished
+} game_phase_t;
+
+// One hosted game
+typedef struct server_game {
+    unsigned char	*state;		// Game state, or NULL while waiting
+    size_t		state_len;	// Length of state in bytes
+    char		**names;	// Names of players while waiting
+    unsigned char	number_players;	// Number of seats in the game
+    unsigned char	phase;		// Current phase (game_phase_t)
+    bool		bid_used;	// True if a bid was made this turn
+} server_game_t;
+
+// One connected client
+typedef struct client {
+    int			fd;		// Socket, or -1 if disconnected
+    int			game;		// Index into games[], or -1
+    int			seat;		// Player number in that game
+    int			created;	// Game last created, or -1
+    bool		closing;	// True to disconnect once out is sent
+    size_t		line_len;	// Length of line so far
+    char		line[SERVER_LINE_LEN];	// Command being received
+    byte_buf_t		out;		// Output not yet accepted by fd
+    size_t		out_off;	// Bytes of out already written
+} client_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static const char *phase_name[] = {
+    "waiting", "move", "trade", "over"
+};
+
+static int listen_fd = -1;		// Socket accepting clients
+static bool listen_unix = false;	// True if option_server is a file
+
+static client_t *clients = NULL;	// Connected clients
+static int num_clients = 0;		// Number of clients
+static int max_clients = 0;		// Size of clients[]
+static struct pollfd *pollfds = NULL;	// Sockets to wait for
+
+static server_game_t *games = NULL;	// Hosted games
+static int num_games = 0;		// Number of games
+static int max_games = 0;		// Size of games[]
+
+static unsigned short int server_rand[3]; // Seeds each new game
+
+static volatile sig_atomic_t server_stop = false; // True on SIGINT or SIGTERM
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   server_signal - Note that the server should stop
+  Parameters: sig           - Signal received
+  Returns:    (nothing)
+*/
+static void server_signal (int sig);
+
+
+/*
+  Function:   open_listener - Create the socket accepting clients
+  Parameters: address       - UNIX-domain socket or [HOST:]PORT
+  Returns:    (nothing)
+*/
+static void open_listener (const char *address);
+
+
+/*
+  Function:   accept_clients - Accept any waiting clients
+  Parameters: (none)
+  Returns:    (nothing)
+*/
+static void accept_clients (void);
+
+
+/*
+  Function:   read_client - Read and carry out commands from a client
+  Parameters: c           - Client whose socket is readable
+  Returns:    (nothing)
+*/
+static void read_client (client_t *c);
+
+
+/*
+  Function:   write_client - Write out what is pending for a client
+  Parameters: c            - Client
+  Returns:    (nothing)
+*/
+static void write_client (client_t *c);
+
+
+/*
+  Function:   drop_client - Disconnect a client
+  Parameters: c           - Client
+  Returns:    (nothing)
+
+  The client is removed from clients[] by server_run().
+*/
+static void drop_client (client_t *c);
+
+
+/*
+  Function:   reply - Send a line to a client
+  Parameters: c     - Client
+              format - Format string, as for printf()
+              ...   - Arguments for the format string
+  Returns:    (nothing)
+
+  A newline is added to the line.  A client that has not read what it
+  was sent before, so that more than SERVER_MAX_OUTPUT bytes are
+  pending, is disconnected.
+*/
+static void reply (client_t *restrict c, const char *restrict format, ...)
+    __attribute__((format (printf, 2, 3)));
+
+
+/*
+  Function:   do_command - Carry out a command from a client
+  Parameters: c          - Client
+              line       - Command, without the newline (modified)
+  Returns:    (nothing)
+*/
+static void do_command (client_t *restrict c, char *restrict line);
+
+
+/*
+  Function:   new_game_slot - Find room in games[] for a new game
+  Parameters: (none)
+  Returns:    int           - Index into games[], or -1 if there is none
+
+  A game that can be reclaimed (as described at the start of this file)
+  is freed and its place used again.  Otherwise, games[] is enlarged, up
+  to SERVER_MAX_GAMES games.
+*/
+static int new_game_slot (void);
+
+
+/*
+  Function:   free_game - Free the memory used by a game
+  Parameters: gm        - Game
+  Returns:    (nothing)
+*/
+static void free_game (server_game_t *gm);
+
+
+/*
+  Function:   join_game - Take a seat in a game
+  Parameters: c         - Client not yet in a game
+              g         - Index into games[]
+              seat      - Player number
+              name      - Name of the player, or NULL
+  Returns:    (nothing)
+*/
+static void join_game (client_t *restrict c, int g, int seat,
+		       const char *restrict name);
+
+
+/*
+  Function:   send_state - Send the state of a game to a client
+  Parameters: c          - Client in a game that has started
+  Returns:    (nothing)
+
+  The game must already be in the global game variables.
+*/
+static void send_state (client_t *c);
+
+
+/*
+  Function:   do_exchange - Carry out a Stock Exchange or Bank command
+  Parameters: c           - Client whose turn it is to trade
+              cmd         - Command name
+              arg1        - First argument, or NULL
+              arg2        - Second argument, or NULL
+  Returns:    bool        - True if the game state was changed
+
+  The game must already be in the global game variables.  An error is
+  sent to the client if false is returned; nothing is sent otherwise.
+*/
+static bool do_exchange (client_t *restrict c, const char *restrict cmd,
+			 const char *restrict arg1, const char *restrict arg2);
+
+
+/*
+  Function:   client_game - Restore the game of a client
+  Parameters: c           - Client
+              turn        - True if it must be the client's turn
+  Returns:    server_game_t * - Game, or NULL on error
+
+  The game is restored into the global game variables.  If NULL is
+  returned, an error has been sent to the client.
+*/
+static server_game_t *client_game (client_t *c, bool turn);
+
+
+/*
+  Function:   start_game - Set up a game once every seat is taken
+  Parameters: gm         - Game in PHASE_WAITING
+  Returns:    (nothing)
+*/
+static void start_game (server_game_t *gm);
+
+
+/*
+  Function:   end_turn - Move on to the next player
+  Parameters: gm       - Game in the global game variables
+  Returns:    (nothing)
+
+  The game is saved, so the global game variables are no longer valid.
+*/
+static void end_turn (server_game_t *gm);
+
+
+/*
+  Function:   save_game_state - Save the global game variables to a game
+  Parameters: gm              - Game to save to
+  Returns:    (nothing)
+*/
+static void save_game_state (server_game_t *gm);
+
+
+/*
+  Function:   broadcast_turn - Tell every client in a game whose turn it is
+  Parameters: g              - Index into games[]
+  Returns:    (nothing)
+*/
+static void broadcast_turn (int g);
+
+
+/*
+  Function:   seat_taken - Check whether a seat is held by a client
+  Parameters: g          - Index into games[]
+              seat       - Player number
+  Returns:    bool       - True if a connected client holds the seat
+*/
+static bool seat_taken (int g, int seat);
+
+
+/*
+  Function:   game_in_use - Check whether any client is using a game
+  Parameters: g           - Index into games[]
+  Returns:    bool        - True if a connected client is in or created it
+*/
+static bool game_in_use (int g);
+
+
+/*
+  Function:   parse_company - Convert a company letter to its number
+  Parameters: arg           - Argument, or NULL
+  Returns:    int           - Company on the galaxy map, or ERR
+*/
+static int parse_company (const char *arg);
+
+
+/*
+  Function:   parse_long - Convert an argument to a number
+  Parameters: arg        - Argument, or NULL
+              val        - Resulting number (output)
+  Returns:    bool       - True if arg is a valid number
+*/
+static bool parse_long (const char *restrict arg, long int *restrict val);
+
+
+/************************************************************************
+*                   Game server function definitions                    *
+************************************************************************/
+
+/* These functions are documented either in the file "server.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// server_run: Host games for clients until terminated
+
+void server_run (void)
+{
+    struct sigaction sa;
+
+
+    // Disconnected clients must not terminate the server
+    sa.sa_handler = SIG_IGN;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPIPE, &sa, NULL) == -1) {
+	errno_exit("sigaction(SIGPIPE)");
+    }
+
+    // Stop cleanly, removing any UNIX-domain socket, when asked to
+    sa.sa_handler = server_signal;
+    if (sigaction(SIGINT, &sa, NULL) == -1) {
+	errno_exit("sigaction(SIGINT)");
+    }
+    if (sigaction(SIGTERM, &sa, NULL) == -1) {
+	errno_exit("sigaction(SIGTERM)");
+    }
+
+    get_rand_state(server_rand);
+    open_listener(option_server);
+
+    while (! server_stop) {
+	int nfds, i, n;
+
+	pollfds = xrealloc(pollfds, (num_clients + 1) * sizeof(struct pollfd));
+	pollfds[0].fd = listen_fd;
+	pollfds[0].events = POLLIN;
+	for (i = 0; i < num_clients; i++) {
+	    pollfds[i + 1].fd = clients[i].fd;
+	    pollfds[i + 1].events = POLLIN
+		| ((clients[i].out.len > 0) ? POLLOUT : 0);
+	}
+	nfds = num_clients + 1;
+
+	if (poll(pollfds, nfds, -1) == -1) {
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    errno_exit("poll");
+	}
+
+	// New clients are added after those being polled
+	if (pollfds[0].revents & POLLIN) {
+	    accept_clients();
+	}
+
+	for (i = 0; i < nfds - 1; i++) {
+	    short int revents = pollfds[i + 1].revents;
+
+	    if (clients[i].fd != -1 && (revents & (POLLIN | POLLHUP | POLLERR))
+		&& ! clients[i].closing) {
+		read_client(&clients[i]);
+	    }
+	}
+
+	// Commands may have sent output to any client
+	for (i = 0; i < num_clients; i++) {
+	    if (clients[i].fd != -1 && clients[i].out.len > 0) {
+		write_client(&clients[i]);
+	    }
+	}
+
+	// Remove clients who have disconnected
+	for (i = 0, n = 0; i < num_clients; i++) {
+	    if (clients[i].fd != -1) {
+		clients[n++] = clients[i];
+	    }
+	}
+	num_clients = n;
+    }
+
+    for (int i = 0; i < num_clients; i++) {
+	drop_client(&clients[i]);
+    }
+    close(listen_fd);
+    listen_fd = -1;
+    if (listen_unix) {
+	unlink(option_server);
+    }
+
+    for (int i = 0; i < num_games; i++) {
+	free_game(&games[i]);
+    }
+    free(games);
+    free(clients);
+    free(pollfds);
+}
+
+
+/***********************************************************************/
+// server_signal: Note that the server should stop
+
+void server_signal (int sig)
+{
+    (void) sig;
+    server_stop = true;
+}
+
+
+/***********************************************************************/
+// open_listener: Create the socket accepting clients
+
+void open_listener (const char *address)
+{
+    if (strchr(address, '/') != NULL) {
+	struct sockaddr_un addr;
+	struct stat statbuf;
+
+
+	if (strlen(address) >= sizeof(addr.sun_path)) {
+	    err_exit(_("%s: socket name is too long"), address);
+	}
+
+	// Remove a socket left over from an earlier server, but nothing else
+	if (lstat(address, &statbuf) == 0 && S_ISSOCK(statbuf.st_mode)) {
+	    unlink(address);
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, address);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd == -1
+	    || bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+	    errno_exit("%s", address);
+	}
+	listen_unix = true;
+
+    } else {
+	struct addrinfo hints, *res, *ai;
+	const char *colon = strrchr(address, ':');
+	const char *port = (colon == NULL) ? address : colon + 1;
+	char *host;
+	int ret, saved_errno = 0;
+
+
+	if (colon == NULL || colon == address) {
+	    host = xstrdup(SERVER_DEFAULT_HOST);
+	} else {
+	    host = xmalloc(colon - address + 1);
+	    memcpy(host, address, colon - address);
+	    host[colon - address] = '\0';
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+
+	ret = getaddrinfo(host, port, &hints, &res);
+	if (ret != 0) {
+	    err_exit("%s: %s", address, gai_strerror(ret));
+	}
+
+	for (ai = res; ai != NULL; ai = ai->ai_next) {
+	    int on = 1;
+
+	    listen_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	    if (listen_fd == -1) {
+		saved_errno = errno;
+		continue;
+	    }
+
+	    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	    if (bind(listen_fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+		break;
+	    }
+
+	    saved_errno = errno;
+	    close(listen_fd);
+	    listen_fd = -1;
+	}
+
+	freeaddrinfo(res);
+	free(host);
+
+	if (listen_fd == -1) {
+	    errno = saved_errno;
+	    errno_exit("%s", address);
+	}
+    }
+
+    if (listen(listen_fd, SERVER_BACKLOG) == -1
+	|| fcntl(listen_fd, F_SETFL, O_NONBLOCK) == -1) {
+	errno_exit("%s", address);
+    }
+}
+
+
+/***********************************************************************/
+// accept_clients: Accept any waiting clients
+
+void accept_clients (void)
+{
+    int fd;
+
+
+    while ((fd = accept(listen_fd, NULL, NULL)) != -1) {
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+	    close(fd);
+	    continue;
+	}
+
+	if (num_clients == max_clients) {
+	    max_clients = (max_clients == 0) ? SERVER_BACKLOG
+		: max_clients * 2;
+	    clients = xrealloc(clients, max_clients * sizeof(client_t));
+	}
+
+	client_t *c = &clients[num_clients++];
+
+	memset(c, 0, sizeof(client_t));
+	c->fd = fd;
+	c->game = -1;
+	c->seat = -1;
+	c->created = -1;
+    }
+}
+
+
+/***********************************************************************/
+// read_client: Read and carry out commands from a client
+
+void read_client (client_t *c)
+{
+    ssize_t n;
+    char *nl;
+
+
+    n = read(c->fd, c->line + c->line_len, SERVER_LINE_LEN - c->line_len);
+    if (n == -1) {
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	    drop_client(c);
+	}
+	return;
+    } else if (n == 0) {
+	drop_client(c);
+	return;
+    }
+    c->line_len += n;
+
+    while (c->fd != -1 && ! c->closing
+	   && (nl = memchr(c->line, '\n', c->line_len)) != NULL) {
+	size_t len = nl - c->line;
+
+	*nl = '\0';
+	if (len > 0 && c->line[len - 1] == '\r') {
+	    c->line[len - 1] = '\0';
+	}
+
+	do_command(c, c->line);
+
+	c->line_len -= len + 1;
+	memmove(c->line, nl + 1, c->line_len);
+    }
+
+    if (c->line_len == SERVER_LINE_LEN) {
+	reply(c, "ERR command too long");
+	c->closing = true;
+    }
+}
+
+
+/***********************************************************************/
+// write_client: Write out what is pending for a client
+
+void write_client (client_t *c)
+{
+    ssize_t n;
+
+
+    n = write(c->fd, c->out.data + c->out_off, c->out.len - c->out_off);
+    if (n == -1) {
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	    drop_client(c);
+	}
+	return;
+    }
+
+    c->out_off += n;
+    if (c->out_off < c->out.len) {
+	return;
+    }
+
+    // Idle clients should hold no buffers
+    free(c->out.data);
+    memset(&c->out, 0, sizeof(c->out));
+    c->out_off = 0;
+
+    if (c->closing) {
+	drop_client(c);
+    }
+}
+
+
+/***********************************************************************/
+// drop_client: Disconnect a client
+
+void drop_client (client_t *c)
+{
+    if (c->fd != -1) {
+	close(c->fd);
+	c->fd = -1;
+    }
+
+    free(c->out.data);
+    memset(&c->out, 0, sizeof(c->out));
+    c->out_off = 0;
+}
+
+
+/***********************************************************************/
+// reply: Send a line to a client
+
+void reply (client_t *restrict c, const char *restrict format, ...)
+{
+    char buf[BUFSIZE];
+    va_list args;
+    int n;
+
+
+    if (c->fd == -1) {
+	return;
+    }
+
+    va_start(args, format);
+    n = vsnprintf(buf, sizeof(buf) - 1, format, args);
+    va_end(args);
+
+    if (n < 0) {
+	n = snprintf(buf, sizeof(buf) - 1, "ERR cannot be shown");
+    } else if ((size_t) n >= sizeof(buf) - 1) {
+	n = sizeof(buf) - 2;
+    }
+    buf[n++] = '\n';
+
+    put_bytes(&c->out, buf, n);
+    if (c->out.len - c->out_off > SERVER_MAX_OUTPUT) {
+	drop_client(c);
+    }
+}
+
+
+/***********************************************************************/
+// do_command: Carry out a command from a client
+
+void do_command (client_t *restrict c, char *restrict line)
+{
+    char *saveptr, *cmd, *arg1, *arg2;
+    server_game_t *gm;
+    long int val, seat;
+    int g;
+
+
+    cmd = strtok_r(line, " \t", &saveptr);
+    if (cmd == NULL) {
+	return;				// Ignore empty lines
+    }
+
+    arg1 = strtok_r(NULL, " \t", &saveptr);
+    arg2 = strtok_r(NULL, " \t", &saveptr);
+
+    if (strcmp(cmd, "NEW") == 0) {
+	if (! parse_long(arg1, &val) || val < 1 || val > MAX_PLAYERS) {
+	    reply(c, "ERR number of players must be 1 to %d", MAX_PLAYERS);
+	    return;
+	}
+
+	if ((g = new_game_slot()) == -1) {
+	    reply(c, "ERR too many games");
+	    return;
+	}
+
+	gm = &games[g];
+	gm->state = NULL;
+	gm->state_len = 0;
+	gm->names = xmalloc(val * sizeof(char *));
+	for (int i = 0; i < val; i++) {
+	    gm->names[i] = NULL;
+	}
+	gm->number_players = val;
+	gm->phase = PHASE_WAITING;
+	gm->bid_used = false;
+
+	c->created = g;
+	reply(c, "OK %d", g + 1);
+
+    } else if (strcmp(cmd, "JOIN") == 0) {
+	char *name = NULL;
+
+	if (! parse_long(arg1, &val) || val < 1 || val > num_games) {
+	    reply(c, "ERR no such game");
+	    return;
+	}
+	if (! parse_long(arg2, &seat) || seat < 1
+	    || seat > games[val - 1].number_players) {
+	    reply(c, "ERR no such seat");
+	    return;
+	}
+	if (c->game != -1) {
+	    reply(c, "ERR already in a game");
+	    return;
+	}
+
+	// The name is everything else on the line
+	if (arg2 != NULL) {
+	    name = strtok_r(NULL, "", &saveptr);
+	    while (name != NULL && (*name == ' ' || *name == '\t')) {
+		name++;
+	    }
+	    if (name != NULL && *name == '\0') {
+		name = NULL;
+	    }
+	}
+
+	join_game(c, val - 1, seat - 1, name);
+
+    } else if (strcmp(cmd, "STATE") == 0) {
+	if (c->game != -1 && games[c->game].phase == PHASE_WAITING) {
+	    int joined = 0;
+
+	    gm = &games[c->game];
+	    for (int i = 0; i < gm->number_players; i++) {
+		if (gm->names[i] != NULL) {
+		    joined++;
+		}
+	    }
+	    reply(c, "WAITING %d %d", joined, gm->number_players);
+	    reply(c, "OK");
+	} else if (client_game(c, false) != NULL) {
+	    send_state(c);
+	}
+
+    } else if (strcmp(cmd, "MOVE") == 0 || strcmp(cmd, "BANKRUPT") == 0) {
+	selection_t selection;
+
+	if (cmd[0] == 'M') {
+	    if (arg1 == NULL || arg1[0] < 'a' || arg1[0] >= 'a' + NUMBER_MOVES
+		|| arg1[1] != '\0') {
+		reply(c, "ERR move must be a to %c", 'a' + NUMBER_MOVES - 1);
+		return;
+	    }
+	    selection = SEL_MOVE_FIRST + (arg1[0] - 'a');
+	} else {
+	    selection = SEL_BANKRUPT;
+	}
+
+	if ((gm = client_game(c, true)) == NULL) {
+	    return;
+	} else if (gm->phase != PHASE_MOVE) {
+	    reply(c, "ERR move already made");
+	    return;
+	}
+
+	replaying = true;
+	select_moves();
+	process_move(selection);
+	replaying = false;
+
+	reply(c, "OK");
+
+	if (quit_selected || abort_game || ! player[current_player].in_game) {
+	    end_turn(gm);
+	} else {
+	    gm->phase = PHASE_TRADE;
+	    gm->bid_used = false;
+	    save_game_state(gm);
+	}
+	broadcast_turn(c->game);
+
+    } else if (strcmp(cmd, "BUY") == 0 || strcmp(cmd, "SELL") == 0
+	       || strcmp(cmd, "BID") == 0 || strcmp(cmd, "BORROW") == 0
+	       || strcmp(cmd, "REPAY") == 0 || strcmp(cmd, "DONE") == 0) {
+	if ((gm = client_game(c, true)) == NULL) {
+	    return;
+	} else if (gm->phase != PHASE_TRADE) {
+	    reply(c, "ERR move must be made first");
+	    return;
+	}
+
+	if (strcmp(cmd, "DONE") == 0) {
+	    reply(c, "OK");
+	    end_turn(gm);
+	    broadcast_turn(c->game);
+	} else if (do_exchange(c, cmd, arg1, arg2)) {
+	    save_game_state(gm);
+	}
+
+    } else if (strcmp(cmd, "QUIT") == 0) {
+	reply(c, "OK");
+	c->closing = true;
+
+    } else {
+	reply(c, "ERR unknown command");
+    }
+}
+
+
+/***********************************************************************/
+// new_game_slot: Find room in games[] for a new game
+
+int new_game_slot (void)
+{
+    for (int g = 0; g < num_games; g++) {
+	if ((games[g].phase == PHASE_OVER || games[g].phase == PHASE_WAITING)
+	    && ! game_in_use(g)) {
+	    free_game(&games[g]);
+	    return g;
+	}
+    }
+
+    if (num_games == SERVER_MAX_GAMES) {
+	return -1;
+    }
+
+    if (num_games == max_games) {
+	max_games = (max_games == 0) ? SERVER_BACKLOG : max_games * 2;
+	games = xrealloc(games, max_games * sizeof(server_game_t));
+    }
+
+    return num_games++;
+}
+
+
+/***********************************************************************/
+// free_game: Free the memory used by a game
+
+void free_game (server_game_t *gm)
+{
+    if (gm->names != NULL) {
+	for (int i = 0; i < gm->number_players; i++) {
+	    free(gm->names[i]);
+	}
+    }
+    free(gm->names);
+    free(gm->state);
+
+    gm->names = NULL;
+    gm->state = NULL;
+    gm->state_len = 0;
+}
+
+
+/***********************************************************************/
+// join_game: Take a seat in a game
+
+void join_game (client_t *restrict c, int g, int seat,
+		const char *restrict name)
+{
+    server_game_t *gm = &games[g];
+
+
+    if (seat_taken(g, seat)) {
+	reply(c, "ERR seat is taken");
+	return;
+    }
+
+    if (gm->phase == PHASE_WAITING) {
+	if (name != NULL) {
+	    free(gm->names[seat]);
+	    gm->names[seat] = xstrdup(name);
+	} else if (gm->names[seat] == NULL) {
+	    reply(c, "ERR name is needed");
+	    return;
+	}
+    }
+
+    c->game = g;
+    c->seat = seat;
+    reply(c, "OK");
+
+    if (gm->phase == PHASE_WAITING) {
+	for (int i = 0; i < gm->number_players; i++) {
+	    if (gm->names[i] == NULL) {
+		return;
+	    }
+	}
+
+	start_game(gm);
+	broadcast_turn(g);
+    } else if (client_game(c, false) != NULL) {
+	reply(c, "TURN %d %d %d %s", turn_number, max_turn,
+	      current_player + 1, phase_name[gm->phase]);
+    }
+}
+
+
+/***********************************************************************/
+// send_state: Send the state of a game to a client
+
+void send_state (client_t *c)
+{
+    server_game_t *gm = &games[c->game];
+    char line[MAX_X + 1];
+    char num1[DTOSTR_BUFSIZE], num2[DTOSTR_BUFSIZE], num3[DTOSTR_BUFSIZE];
+    int x, y, i, j;
+
+
+    reply(c, "TURN %d %d %d %s", turn_number, max_turn, current_player + 1,
+	  phase_name[gm->phase]);
+    reply(c, "BANK %s", xdtofixed(num1, sizeof(num1), interest_rate, 4));
+
+    // The moves are only known once they have been selected
+    if (gm->phase == PHASE_MOVE) {
+	select_moves();
+    }
+
+    for (y = 0; y < MAX_Y; y++) {
+	for (x = 0; x < MAX_X; x++) {
+	    map_val_t m = galaxy_map[x][y];
+
+	    line[x] = (m == MAP_EMPTY) ? '.' : (m == MAP_OUTPOST) ? '+' :
+		(m == MAP_STAR) ? '*' : 'A' + MAP_TO_COMPANY(m);
+	}
+	line[MAX_X] = '\0';
+
+	if (gm->phase == PHASE_MOVE) {
+	    for (i = 0; i < NUMBER_MOVES; i++) {
+		if (game_move[i].y == y) {
+		    line[game_move[i].x] = 'a' + i;
+		}
+	    }
+	}
+
+	reply(c, "MAP %s", line);
+    }
+
+    for (i = 0; i < MAX_COMPANIES; i++) {
+	if (company[i].on_map) {
+	    reply(c, "COMPANY %c %s %s %ld %ld", 'A' + i,
+		  xdtofixed(num1, sizeof(num1), company[i].share_price, 2),
+		  xdtofixed(num2, sizeof(num2), company[i].share_return, 4),
+		  company[i].stock_issued, company[i].max_stock);
+	}
+    }
+
+    for (i = 0; i < number_players; i++) {
+	char stock[MAX_COMPANIES * 22];
+	int len = 0;
+
+	for (j = 0; j < MAX_COMPANIES; j++) {
+	    len += snprintf(stock + len, sizeof(stock) - len, " %ld",
+			    player[i].stock_owned[j]);
+	}
+
+	reply(c, "PLAYER %d %d %s %s %s%s %ls", i + 1,
+	      player[i].in_game ? 1 : 0,
+	      xdtofixed(num1, sizeof(num1), player[i].cash, 2),
+	      xdtofixed(num2, sizeof(num2), player[i].debt, 2),
+	      xdtofixed(num3, sizeof(num3), total_value(i), 2),
+	      stock, name_wcs(player[i].name));
+    }
+
+    reply(c, "OK");
+}
+
+
+/***********************************************************************/
+// do_exchange: Carry out a Stock Exchange or Bank command
+
+bool do_exchange (client_t *restrict c, const char *restrict cmd,
+		  const char *restrict arg1, const char *restrict arg2)
+{
+    server_game_t *gm = &games[c->game];
+    char numbuf[DTOSTR_BUFSIZE];
+    long int shares;
+    double amount, max;
+    char *p;
+    int num;
+
+
+    if (strcmp(cmd, "BORROW") == 0 || strcmp(cmd, "REPAY") == 0) {
+	amount = (arg1 == NULL) ? 0.0 : xstrtod(arg1, &p);
+	if (arg1 == NULL || p == arg1 || *p != '\0' || ! isfinite(amount)
+	    || amount <= ROUNDING_AMOUNT) {
+	    reply(c, "ERR amount must be more than %s",
+		  xdtofixed(numbuf, sizeof(numbuf), ROUNDING_AMOUNT, 2));
+	    return false;
+	}
+
+	if (cmd[0] == 'B') {
+	    max = (total_value(current_player) - player[current_player].debt)
+		* CREDIT_LIMIT_RATE;
+	    if (amount > max + ROUNDING_AMOUNT) {
+		reply(c, "ERR credit limit is %s",
+		      xdtofixed(numbuf, sizeof(numbuf), MAX(max, 0.0), 2));
+		return false;
+	    }
+	    borrow_money(amount);
+	} else {
+	    max = MIN(player[current_player].cash,
+		      player[current_player].debt);
+	    if (amount > max + ROUNDING_AMOUNT) {
+		reply(c, "ERR at most %s can be repaid",
+		      xdtofixed(numbuf, sizeof(numbuf), max, 2));
+		return false;
+	    }
+	    repay_debt(amount);
+	}
+
+	reply(c, "OK");
+	return true;
+    }
+
+    if ((num = parse_company(arg1)) == ERR) {
+	reply(c, "ERR no such company on the map");
+	return false;
+    }
+
+    if (strcmp(cmd, "BID") == 0) {
+	shares = gm->bid_used ? 0 : bid_for_stock(num);
+	gm->bid_used = true;
+
+	reply(c, "OK %ld", shares);
+	return true;
+    }
+
+    if (! parse_long(arg2, &shares) || shares < 1) {
+	reply(c, "ERR number of shares must be positive");
+	return false;
+    }
+
+    if (cmd[0] == 'B') {
+	long int maxshares = MIN(player[current_player].cash
+				 / company[num].share_price,
+				 company[num].max_stock
+				 - company[num].stock_issued);
+
+	if (shares > maxshares) {
+	    reply(c, "ERR at most %ld shares can be bought", maxshares);
+	    return false;
+	}
+	trade_stock(num, shares);
+    } else {
+	if (shares > player[current_player].stock_owned[num]) {
+	    reply(c, "ERR at most %ld shares can be sold",
+		  player[current_player].stock_owned[num]);
+	    return false;
+	}
+	trade_stock(num, -shares);
+    }
+
+    reply(c, "OK");
+    return true;
+}
+
+
+/***********************************************************************/
+// client_game: Restore the game of a client
+
+server_game_t *client_game (client_t *c, bool turn)
+{
+    server_game_t *gm;
+
+
+    if (c->game == -1) {
+	reply(c, "ERR not in a game");
+	return NULL;
+    }
+
+    gm = &games[c->game];
+    if (gm->phase == PHASE_WAITING) {
+	reply(c, "ERR game has not started");
+	return NULL;
+    }
+
+    if (! replay_load_state(gm->state, gm->state_len)) {
+	reply(c, "ERR game is corrupt");
+	gm->phase = PHASE_OVER;
+	return NULL;
+    }
+
+    if (turn && gm->phase == PHASE_OVER) {
+	reply(c, "ERR game is over");
+	return NULL;
+    } else if (turn && current_player != c->seat) {
+	reply(c, "ERR not your turn");
+	return NULL;
+    }
+
+    return gm;
+}
+
+
+/***********************************************************************/
+// start_game: Set up a game once every seat is taken
+
+void start_game (server_game_t *gm)
+{
+    wchar_t *buf = xmalloc(BUFSIZE * sizeof(wchar_t));
+    unsigned short int rand_state[3];
+
+
+    number_players = gm->number_players;
+    clear_names();
+    for (int i = 0; i < number_players; i++) {
+	xmbstowcs(buf, gm->names[i], BUFSIZE);
+	player[i].name = intern_name(buf, NULL);
+
+	free(gm->names[i]);
+    }
+    free(gm->names);
+    gm->names = NULL;
+    free(buf);
+
+    // Each game has its own random number generator
+    for (int i = 0; i < 3; i++) {
+	rand_state[i] = nrand48(server_rand) >> 15;
+    }
+    set_rand_state(rand_state);
+
+    new_game();
+
+    gm->phase = PHASE_MOVE;
+    save_game_state(gm);
+}
+
+
+/***********************************************************************/
+// end_turn: Move on to the next player
+
+void end_turn (server_game_t *gm)
+{
+    next_player();
+
+    gm->phase = (quit_selected || turn_number > max_turn) ?
+	PHASE_OVER : PHASE_MOVE;
+    save_game_state(gm);
+
+    // Selecting the moves tells whether the galaxy is full
+    if (gm->phase == PHASE_MOVE) {
+	select_moves();
+	if (quit_selected) {
+	    gm->phase = PHASE_OVER;
+	}
+    }
+}
+
+
+/***********************************************************************/
+// save_game_state: Save the global game variables to a game
+
+void save_game_state (server_game_t *gm)
+{
+    const void *state;
+    size_t len;
+
+
+    state = replay_save_state(&len);
+    if (len != gm->state_len) {
+	gm->state = xrealloc(gm->state, len);
+	gm->state_len = len;
+    }
+    memcpy(gm->state, state, len);
+}
+
+
+/***********************************************************************/
+// broadcast_turn: Tell every client in a game whose turn it is
+
+void broadcast_turn (int g)
+{
+    if (! replay_load_state(games[g].state, games[g].state_len)) {
+	return;
+    }
+
+    for (int i = 0; i < num_clients; i++) {
+	if (clients[i].fd != -1 && clients[i].game == g) {
+	    reply(&clients[i], "TURN %d %d %d %s", turn_number, max_turn,
+		  current_player + 1, phase_name[games[g].phase]);
+	}
+    }
+}
+
+
+/***********************************************************************/
+// seat_taken: Check whether a seat is held by a client
+
+bool seat_taken (int g, int seat)
+{
+    for (int i = 0; i < num_clients; i++) {
+	if (clients[i].fd != -1 && clients[i].game == g
+	    && clients[i].seat == seat) {
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+
+/***********************************************************************/
+// game_in_use: Check whether any client is using a game
+
+bool game_in_use (int g)
+{
+    for (int i = 0; i < num_clients; i++) {
+	if (clients[i].fd != -1
+	    && (clients[i].game == g || clients[i].created == g)) {
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+
+/***********************************************************************/
+// parse_company: Convert a company letter to its number
+
+int parse_company (const char *arg)
+{
+    int num;
+
+
+    if (arg == NULL || arg[0] < 'A' || arg[0] >= 'A' + MAX_COMPANIES
+	|| arg[1] != '\0') {
+	return ERR;
+    }
+
+    num = arg[0] - 'A';
+    return company[num].on_map ? num : ERR;
+}
+
+
+/***********************************************************************/
+// parse_long: Convert an argument to a number
+
+bool parse_long (const char *restrict arg, long int *restrict val)
+{
+    char *p;
+
+
+    if (arg == NULL) {
+	return false;
+    }
+
+    errno = 0;
+    *val = strtol(arg, &p, 10);
+    return p != arg && *p == '\0' && errno == 0;
+}
+
+
+/***********************************************************************/
+// End of file
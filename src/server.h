@@ -0,0 +1,68 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, server.h, contains declarations for the game server used in
+  Star Traders.  The server hosts any number of independent games at
+  once, each with its own random number generator.  Players connect to
+  it over a UNIX-domain or TCP socket and play their seat in a game by
+  sending simple text commands.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_SERVER_H
+#define included_SERVER_H 1
+
+
+/************************************************************************
+*                  Game server constants and variables                  *
+************************************************************************/
+
+#define SERVER_BACKLOG		64	// Connections waiting to be accepted
+#define SERVER_LINE_LEN		256	// Longest command accepted, with '\n'
+#define SERVER_MAX_OUTPUT	65536	// Most output held for one client
+#define SERVER_MAX_GAMES	4096	// Most games hosted at once
+#define SERVER_DEFAULT_HOST	"localhost"	// Host if ADDRESS is just :PORT
+
+
+/************************************************************************
+*                    Game server function prototypes                    *
+************************************************************************/
+
+/*
+  Function:   server_run - Host games for clients until terminated
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function listens on the address named by option_server, then
+  serves clients until the program receives SIGINT or SIGTERM.  If the
+  address contains a "/", it names a UNIX-domain socket; otherwise, it
+  is a TCP port, optionally preceded by a host name and ":".  The
+  terminal is not used.  On any error in setting up the socket, the
+  program is terminated with an appropriate message.
+*/
+extern void server_run (void);
+
+
+#endif /* included_SERVER_H */
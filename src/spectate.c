@@ -0,0 +1,465 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, spectate.c, contains the implementation of the spectator
+  functions used in Star Traders.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#include "trader.h"
+
+
+/*
+  Spectators only ever read from the socket: whatever they send is
+  ignored.  What they are sent can simply be copied to a terminal of at
+  least the same size as the player's, for example with:
+
+    socat -u UNIX-CONNECT:socket STDOUT
+
+  Each time the screen is updated, it is read from curscr with
+  read_screen() and compared line by line with the last screen sent.
+  The lines that differ are written once, each positioned with an ANSI
+  cursor movement, into a buffer shared by all spectators.  A spectator
+  who has just connected, or who has missed some changes, needs the
+  whole screen instead; that is also written at most once per update.
+
+  All sockets are non-blocking.  Whatever a spectator's socket does not
+  accept at once is kept in a buffer belonging to that spectator and
+  written as the socket allows; no more changes are sent to it until
+  then, so a slow spectator costs no more than one screen of memory and
+  never holds up the game.
+*/
+
+
+/************************************************************************
+*                   Module-specific type declarations                   *
+************************************************************************/
+
+// One connected spectator
+typedef struct spectator {
+    int			fd;		// Socket, or -1 if disconnected
+    char		*pending;	// Output not yet accepted by fd
+    size_t		pending_len;	// Length of pending
+    size_t		pending_off;	// Bytes of pending already written
+    bool		resync;		// True if the whole screen is needed
+} spectator_t;
+
+
+/************************************************************************
+*                       Module-specific variables                       *
+************************************************************************/
+
+static int listen_fd = -1;		// Socket accepting spectators
+
+static spectator_t *spectators = NULL;	// Connected spectators
+static int num_spectators = 0;		// Number of spectators
+static int max_spectators = 0;		// Size of spectators[]
+
+static frame_cell_t *screen = NULL;	// Screen as it is now
+static frame_cell_t *last_screen = NULL; // Screen last sent
+static bool have_last_screen = false;	// True if last_screen is valid
+static int screen_lines, screen_cols;	// Size of each screen
+
+
+/************************************************************************
+*                  Module-specific function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   accept_spectators - Accept any waiting spectators
+  Parameters: (none)
+  Returns:    (nothing)
+*/
+static void accept_spectators (void);
+
+
+/*
+  Function:   make_update - Write the changes to the screen to memory
+  Parameters: last        - Screen last sent, or NULL for the whole screen
+              len         - Length of the result (output)
+  Returns:    char *      - Changes as ANSI escape sequences (malloc()ed)
+*/
+static char *make_update (const frame_cell_t *restrict last,
+			  size_t *restrict len);
+
+
+/*
+  Function:   send_spectator - Send data to a spectator without waiting
+  Parameters: sp             - Spectator with nothing pending
+              data           - Data to send
+              len            - Length of data
+  Returns:    (nothing)
+
+  Whatever cannot be written straight away is copied to sp->pending.
+*/
+static void send_spectator (spectator_t *restrict sp,
+			    const char *restrict data, size_t len);
+
+
+/*
+  Function:   flush_spectator - Write out what is pending for a spectator
+  Parameters: sp              - Spectator
+  Returns:    bool            - True if nothing is left pending
+*/
+static bool flush_spectator (spectator_t *sp);
+
+
+/*
+  Function:   drop_spectator - Disconnect a spectator
+  Parameters: sp             - Spectator
+  Returns:    (nothing)
+
+  The spectator is removed from spectators[] by spectate_update().
+*/
+static void drop_spectator (spectator_t *sp);
+
+
+/************************************************************************
+*                    Spectator function definitions                     *
+************************************************************************/
+
+/* These functions are documented either in the file "spectate.h" or in
+   the comments above. */
+
+
+/***********************************************************************/
+// spectate_init: Start accepting spectators
+
+void spectate_init (void)
+{
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    struct stat statbuf;
+
+
+    if (option_spectate == NULL) {
+	return;
+    }
+
+    if (strlen(option_spectate) >= sizeof(addr.sun_path)) {
+	err_exit(_("%s: socket name is too long"), option_spectate);
+    }
+
+    // Disconnected spectators must not terminate the game
+    sa.sa_handler = SIG_IGN;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPIPE, &sa, NULL) == -1) {
+	errno_exit("sigaction(SIGPIPE)");
+    }
+
+    // Remove a socket left over from an earlier game, but nothing else
+    if (lstat(option_spectate, &statbuf) == 0 && S_ISSOCK(statbuf.st_mode)) {
+	unlink(option_spectate);
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, option_spectate);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd == -1
+	|| bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) == -1
+	|| listen(listen_fd, SPECTATE_BACKLOG) == -1
+	|| fcntl(listen_fd, F_SETFL, O_NONBLOCK) == -1) {
+	errno_exit("%s", option_spectate);
+    }
+
+    num_spectators = 0;
+    have_last_screen = false;
+}
+
+
+/***********************************************************************/
+// spectate_update: Send the screen to all spectators
+
+void spectate_update (void)
+{
+    char *update = NULL, *whole = NULL;
+    size_t update_len = 0, whole_len = 0;
+    bool changed;
+    int i, n;
+
+
+    if (listen_fd == -1) {
+	return;
+    }
+
+    accept_spectators();
+
+    if (num_spectators == 0) {
+	// Nobody is watching: don't even read the screen
+	have_last_screen = false;
+	return;
+    }
+
+    if (screen == NULL || screen_lines != LINES || screen_cols != COLS) {
+	free(screen);
+	free(last_screen);
+
+	screen_lines = LINES;
+	screen_cols = COLS;
+	screen = xmalloc(screen_lines * screen_cols * sizeof(frame_cell_t));
+	last_screen = xmalloc(screen_lines * screen_cols
+			      * sizeof(frame_cell_t));
+	have_last_screen = false;
+    }
+
+    read_screen(screen, screen_lines, screen_cols);
+    changed = ! have_last_screen
+	|| memcmp(screen, last_screen, screen_lines * screen_cols
+		  * sizeof(frame_cell_t)) != 0;
+
+    for (i = 0; i < num_spectators; i++) {
+	spectator_t *sp = &spectators[i];
+
+	if (! flush_spectator(sp)) {
+	    // Still busy with earlier output: catch up later
+	    if (changed) {
+		sp->resync = true;
+	    }
+	} else if (sp->resync || ! have_last_screen) {
+	    if (whole == NULL) {
+		whole = make_update(NULL, &whole_len);
+	    }
+	    send_spectator(sp, whole, whole_len);
+	    sp->resync = false;
+	} else if (changed) {
+	    if (update == NULL) {
+		update = make_update(last_screen, &update_len);
+	    }
+	    send_spectator(sp, update, update_len);
+	}
+    }
+
+    free(update);
+    free(whole);
+
+    if (changed) {
+	frame_cell_t *t = last_screen;
+	last_screen = screen;
+	screen = t;
+	have_last_screen = true;
+    }
+
+    // Remove spectators who have disconnected
+    for (i = 0, n = 0; i < num_spectators; i++) {
+	if (spectators[i].fd != -1) {
+	    spectators[n++] = spectators[i];
+	}
+    }
+    num_spectators = n;
+}
+
+
+/***********************************************************************/
+// spectate_end: Stop accepting spectators
+
+void spectate_end (void)
+{
+    if (listen_fd == -1) {
+	return;
+    }
+
+    for (int i = 0; i < num_spectators; i++) {
+	spectator_t *sp = &spectators[i];
+
+	// Show the cursor again, if that can be done without waiting
+	if (sp->pending == NULL) {
+	    send_spectator(sp, "\033[?25h\r\n", 8);
+	}
+	drop_spectator(sp);
+    }
+    num_spectators = 0;
+
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(option_spectate);
+
+    free(spectators);
+    free(screen);
+    free(last_screen);
+    spectators = NULL;
+    screen = last_screen = NULL;
+    max_spectators = 0;
+}
+
+
+/***********************************************************************/
+// accept_spectators: Accept any waiting spectators
+
+void accept_spectators (void)
+{
+    int fd;
+
+
+    while ((fd = accept(listen_fd, NULL, NULL)) != -1) {
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+	    close(fd);
+	    continue;
+	}
+
+	if (num_spectators == max_spectators) {
+	    max_spectators = (max_spectators == 0) ? SPECTATE_BACKLOG
+		: max_spectators * 2;
+	    spectators = xrealloc(spectators, max_spectators
+				  * sizeof(spectator_t));
+	}
+
+	spectator_t *sp = &spectators[num_spectators++];
+
+	sp->fd = fd;
+	sp->pending = NULL;
+	sp->pending_len = sp->pending_off = 0;
+	sp->resync = true;
+
+	// Hide the cursor, as the player's is hidden most of the time
+	send_spectator(sp, "\033[?25l", 6);
+    }
+}
+
+
+/***********************************************************************/
+// make_update: Write the changes to the screen to memory
+
+char *make_update (const frame_cell_t *restrict last, size_t *restrict len)
+{
+    char *buf = NULL;
+    FILE *file;
+
+
+    file = open_memstream(&buf, len);
+    if (file == NULL) {
+	errno_exit("open_memstream");
+    }
+
+    if (last == NULL) {
+	fputs("\033[H\033[2J", file);
+    }
+
+    for (int y = 0; y < screen_lines; y++) {
+	const frame_cell_t *line = &screen[y * screen_cols];
+
+	if (last != NULL && memcmp(line, &last[y * screen_cols], screen_cols
+				   * sizeof(frame_cell_t)) == 0) {
+	    continue;
+	}
+
+	fprintf(file, "\033[%d;1H", y + 1);
+	write_ansi_line(file, line, screen_cols);
+    }
+
+    if (fclose(file) == EOF) {
+	errno_exit("open_memstream");
+    }
+
+    return buf;
+}
+
+
+/***********************************************************************/
+// send_spectator: Send data to a spectator without waiting
+
+void send_spectator (spectator_t *restrict sp, const char *restrict data,
+		     size_t len)
+{
+    ssize_t n;
+
+
+    if (sp->fd == -1) {
+	return;
+    }
+
+    assert(sp->pending == NULL);
+
+    n = write(sp->fd, data, len);
+    if (n == -1) {
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	    drop_spectator(sp);
+	    return;
+	}
+	n = 0;
+    }
+
+    if ((size_t) n < len) {
+	sp->pending_len = len - n;
+	sp->pending_off = 0;
+	sp->pending = xmalloc(sp->pending_len);
+	memcpy(sp->pending, data + n, sp->pending_len);
+    }
+}
+
+
+/***********************************************************************/
+// flush_spectator: Write out what is pending for a spectator
+
+bool flush_spectator (spectator_t *sp)
+{
+    ssize_t n;
+
+
+    if (sp->pending == NULL) {
+	return true;
+    }
+
+    n = write(sp->fd, sp->pending + sp->pending_off,
+	      sp->pending_len - sp->pending_off);
+    if (n == -1) {
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+	    drop_spectator(sp);
+	}
+	return false;
+    }
+
+    sp->pending_off += n;
+    if (sp->pending_off < sp->pending_len) {
+	return false;
+    }
+
+    free(sp->pending);
+    sp->pending = NULL;
+    sp->pending_len = sp->pending_off = 0;
+    return true;
+}
+
+
+/***********************************************************************/
+// drop_spectator: Disconnect a spectator
+
+void drop_spectator (spectator_t *sp)
+{
+    if (sp->fd != -1) {
+	close(sp->fd);
+	sp->fd = -1;
+    }
+
+    free(sp->pending);
+    sp->pending = NULL;
+    sp->pending_len = sp->pending_off = 0;
+}
+
+
+/***********************************************************************/
+// End of file
@@ -0,0 +1,91 @@
+/************************************************************************
+*                                                                       *
+*             Star Traders: A Game of Interstellar Trading              *
+*                Copyright (C) 1990-2021, John Zaitseff                 *
+*                                                                       *
+************************************************************************/
+
+/*
+  Author: John Zaitseff <J.Zaitseff@zap.org.au>
+  $Id$
+
+  This file, spectate.h, contains declarations for the spectator
+  functions used in Star Traders.  While a game is being played, the
+  screen is sent to any number of spectators connected to a UNIX-domain
+  socket, so that others may watch the game on their own terminals.
+
+
+  This program is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the
+  Free Software Foundation, either version 3 of the License, or (at your
+  option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#ifndef included_SPECTATE_H
+#define included_SPECTATE_H 1
+
+
+/************************************************************************
+*                   Spectator constants and variables                   *
+************************************************************************/
+
+#define SPECTATE_POLL_TIME	100	// Milliseconds between updates
+#define SPECTATE_BACKLOG	8	// Connections waiting to be accepted
+
+
+/************************************************************************
+*                     Spectator function prototypes                     *
+************************************************************************/
+
+/*
+  Function:   spectate_init - Start accepting spectators
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function creates and listens on the UNIX-domain socket named by
+  option_spectate, if that option is not NULL.  Any socket left over
+  from an earlier game is removed first.  It must be called after the
+  screen has been initialised.  On any error, the program is terminated
+  with an appropriate message.
+*/
+extern void spectate_init (void);
+
+
+/*
+  Function:   spectate_update - Send the screen to all spectators
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function accepts any new spectators, then sends each spectator
+  the lines of the screen that have changed since the last call, as
+  ANSI escape sequences.  The changes are prepared only once, however
+  many spectators there are.  Nothing is ever waited for: a spectator
+  that has not yet read what it was sent before misses the changes, and
+  is sent the whole screen once it has caught up.  New spectators are
+  likewise sent the whole screen.  This function does nothing if no
+  spectators are being accepted.
+*/
+extern void spectate_update (void);
+
+
+/*
+  Function:   spectate_end - Stop accepting spectators
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function disconnects all spectators, closes the socket and
+  removes it from the file system.
+*/
+extern void spectate_end (void);
+
+
+#endif /* included_SPECTATE_H */
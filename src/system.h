@@ -58,19 +58,31 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <float.h>
+#include <math.h>
 #include <locale.h>
 #include <string.h>
 #include <errno.h>
 #include <wchar.h>
 #include <wctype.h>
+#include <time.h>
 
 
 // Headers defined by X/Open Single Unix Specification v4
 
 #include <unistd.h>
 #include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <poll.h>
 #include <monetary.h>
 #include <langinfo.h>
 
@@ -44,7 +44,21 @@
 enum options_char {
     OPTION_NO_COLOR = 1,
     OPTION_DONT_ENCRYPT,
-    OPTION_MAX_TURN
+    OPTION_FILE_CHECKSUM,
+    OPTION_MAX_TURN,
+    OPTION_ARCHIVE,
+    OPTION_ARCHIVE_COLUMN,
+    OPTION_REPLAY,
+    OPTION_VIEW_REPLAY,
+    OPTION_EXPORT,
+    OPTION_FAST_PLAY,
+    OPTION_HEADLESS,
+    OPTION_ANSI_FRAMES,
+    OPTION_FRAME_BYTES,
+    OPTION_LOW_BANDWIDTH,
+    OPTION_SPECTATE,
+    OPTION_SERVER,
+    OPTION_STARTUP_PROFILE
 };
 
 static const char options_short[] = "hV";
@@ -52,13 +66,27 @@ static const char options_short[] = "hV";
     // -V, --version
 
 static struct option const options_long[] = {
-    { "help",         no_argument,       NULL, 'h' },
-    { "version",      no_argument,       NULL, 'V' },
-    { "no-color",     no_argument,       NULL, OPTION_NO_COLOR },
-    { "no-colour",    no_argument,       NULL, OPTION_NO_COLOR },
-    { "dont-encrypt", no_argument,       NULL, OPTION_DONT_ENCRYPT },
-    { "max-turn",     required_argument, NULL, OPTION_MAX_TURN },
-    { NULL,           0,                 NULL, 0 }
+    { "help",           no_argument,       NULL, 'h' },
+    { "version",        no_argument,       NULL, 'V' },
+    { "no-color",       no_argument,       NULL, OPTION_NO_COLOR },
+    { "no-colour",      no_argument,       NULL, OPTION_NO_COLOR },
+    { "dont-encrypt",   no_argument,       NULL, OPTION_DONT_ENCRYPT },
+    { "file-checksum",  no_argument,       NULL, OPTION_FILE_CHECKSUM },
+    { "max-turn",       required_argument, NULL, OPTION_MAX_TURN },
+    { "archive",        required_argument, NULL, OPTION_ARCHIVE },
+    { "archive-column", required_argument, NULL, OPTION_ARCHIVE_COLUMN },
+    { "replay",         required_argument, NULL, OPTION_REPLAY },
+    { "view-replay",    required_argument, NULL, OPTION_VIEW_REPLAY },
+    { "export",         required_argument, NULL, OPTION_EXPORT },
+    { "fast-play",      no_argument,       NULL, OPTION_FAST_PLAY },
+    { "headless",       required_argument, NULL, OPTION_HEADLESS },
+    { "ansi-frames",    no_argument,       NULL, OPTION_ANSI_FRAMES },
+    { "frame-bytes",    required_argument, NULL, OPTION_FRAME_BYTES },
+    { "low-bandwidth",  no_argument,       NULL, OPTION_LOW_BANDWIDTH },
+    { "spectate",       required_argument, NULL, OPTION_SPECTATE },
+    { "server",         required_argument, NULL, OPTION_SERVER },
+    { "startup-profile", no_argument,      NULL, OPTION_STARTUP_PROFILE },
+    { NULL,             0,                 NULL, 0 }
 };
 
 
@@ -160,26 +188,53 @@ static void end_program (void);
 int main (int argc, char *argv[])
 {
     // Initialise program name, locale and message catalogs
+    startup_mark(NULL);
     init_program_prelim(argc, argv);
+    startup_mark("initialising the locale and message catalogs");
 
     // Process command line arguments
     process_cmdline(argc, argv);
+    startup_mark("processing the command line");
 
     // Set up the display, internal low-level routines, etc.
     init_program();
 
+    // Host games for clients instead of playing, if requested
+    if (option_server != NULL) {
+	server_run();
+	end_program();
+	return EXIT_SUCCESS;
+    }
+
+    // View a game replay instead of playing, if requested
+    if (option_view_replay != NULL) {
+	replay_view(option_view_replay);
+	end_program();
+	return EXIT_SUCCESS;
+    }
+
     // Play the actual game
     init_game();
+    replay_start();
+    export_start();
     while (! quit_selected && ! abort_game && turn_number <= max_turn) {
 	selection_t selection;
 
+	replay_record_keyframe();
 	select_moves();
 	selection = get_move();
+	archive_record_move(selection);
+	replay_record_move(selection);
+	export_record_move(selection);
 	process_move(selection);
 	exchange_stock();
 	next_player();
+	export_move();
     }
     end_game();
+    archive_game();
+    replay_save();
+    export_end();
 
     // Finish up...
     end_program();
@@ -199,6 +254,9 @@ int main (int argc, char *argv[])
 
 void process_cmdline (int argc, char *argv[])
 {
+    const char *archive_column = NULL;
+
+
     // Process arguments starting with "-" or "--"
     opterr = true;
     while (true) {
@@ -227,6 +285,11 @@ void process_cmdline (int argc, char *argv[])
 	    option_dont_encrypt = true;
 	    break;
 
+	case OPTION_FILE_CHECKSUM:
+	    // --file-checksum: use one checksum for the whole game file
+	    option_file_checksum = true;
+	    break;
+
 	case OPTION_MAX_TURN:
 	    // --max-turn: specify the maximum turn number
 	    {
@@ -242,11 +305,94 @@ void process_cmdline (int argc, char *argv[])
 	    }
 	    break;
 
+	case OPTION_ARCHIVE:
+	    // --archive: append each finished game to a game archive
+	    option_archive = optarg;
+	    break;
+
+	case OPTION_ARCHIVE_COLUMN:
+	    // --archive-column: print one column of the game archive
+	    archive_column = optarg;
+	    break;
+
+	case OPTION_REPLAY:
+	    // --replay: write a replay of the game
+	    option_replay = optarg;
+	    break;
+
+	case OPTION_VIEW_REPLAY:
+	    // --view-replay: view a game replay instead of playing
+	    option_view_replay = optarg;
+	    break;
+
+	case OPTION_EXPORT:
+	    // --export: write the state of the game after each move
+	    option_export = optarg;
+	    break;
+
+	case OPTION_FAST_PLAY:
+	    // --fast-play: show the events of each move together
+	    option_fast_play = true;
+	    break;
+
+	case OPTION_HEADLESS:
+	    // --headless: play without a terminal, writing each screen
+	    option_headless = optarg;
+	    break;
+
+	case OPTION_ANSI_FRAMES:
+	    // --ansi-frames: write --headless screens as ANSI sequences
+	    option_ansi_frames = true;
+	    break;
+
+	case OPTION_FRAME_BYTES:
+	    // --frame-bytes: write the bytes output for each --headless screen
+	    option_frame_bytes = optarg;
+	    break;
+
+	case OPTION_LOW_BANDWIDTH:
+	    // --low-bandwidth: send as few bytes to the terminal as possible
+	    option_low_bandwidth = true;
+	    break;
+
+	case OPTION_SPECTATE:
+	    // --spectate: let others watch the game through a socket
+	    option_spectate = optarg;
+	    break;
+
+	case OPTION_SERVER:
+	    // --server: host games for clients instead of playing
+	    option_server = optarg;
+	    break;
+
+	case OPTION_STARTUP_PROFILE:
+	    // --startup-profile: show how long starting up took
+	    option_startup_profile = true;
+	    break;
+
 	default:
 	    show_usage(EXIT_FAILURE);
 	}
     }
 
+    // Print a column of the game archive instead of playing, if requested
+    if (archive_column != NULL) {
+	if (option_archive == NULL) {
+	    fprintf(stderr, _("%s: --archive-column requires --archive\n"),
+		    program_name);
+	    show_usage(EXIT_FAILURE);
+	}
+
+	archive_print_column(option_archive, archive_column);
+	exit(EXIT_SUCCESS);
+    }
+
+    if (option_frame_bytes != NULL && option_headless == NULL) {
+	fprintf(stderr, _("%s: --frame-bytes requires --headless\n"),
+		program_name);
+	show_usage(EXIT_FAILURE);
+    }
+
     // Process remaining arguments
 
     if (optind < argc && argv[optind] != NULL) {
@@ -256,13 +402,18 @@ void process_cmdline (int argc, char *argv[])
 	    show_usage(EXIT_FAILURE);
 	}
 
-	if (strlen(argv[optind]) == 1
-	    && *argv[optind] >= '1' && *argv[optind] <= '9') {
-	    game_num = *argv[optind] - '0';
-	} else {
-	    fprintf(stderr, _("%s: invalid game number '%s'\n"),
+	char *p;
+	long int num = strtol(argv[optind], &p, 10);
+
+	if (valid_game_name(argv[optind])) {
+	    game_name = xstrdup(argv[optind]);
+	} else if (num < 1 || num > MAX_GAME_NUM || p == argv[optind]
+		   || *p != '\0') {
+	    fprintf(stderr, _("%s: invalid game number or name '%s'\n"),
 		    program_name, argv[optind]);
 	    show_usage(EXIT_FAILURE);
+	} else {
+	    game_num = num;
 	}
 
 	optind++;
@@ -320,12 +471,37 @@ Options:\n\
   -V, --version        output version information and exit\n\
   -h, --help           display this help and exit\n\
       --no-color       don't use color for displaying text\n\
-      --max-turn=NUM   set the number of turns to NUM\n\n\
+      --max-turn=NUM   set the number of turns to NUM\n\
+      --archive=FILE   append each finished game to the game archive FILE\n\
+      --archive-column=NAME\n\
+                       print column NAME of the game archive and exit\n\
+      --replay=FILE    write a replay of the game to FILE\n\
+      --view-replay=FILE\n\
+                       view the game replay FILE instead of playing\n\
+      --export=FILE    append the state of the game after each move to FILE\n\
+      --fast-play      show the events of each move together in one window\n\
+      --low-bandwidth  send as little as possible to the terminal\n\
+      --spectate=SOCKET\n\
+                       let others watch the game by connecting to SOCKET\n\
+      --server=ADDRESS host games for clients connecting to ADDRESS, a\n\
+                       UNIX-domain socket or [HOST:]PORT, instead of playing\n\
+      --startup-profile\n\
+                       show how long each part of starting up took on\n\
+                       standard error when the program ends\n\
+      --headless=FILE  read keys from standard input instead of a terminal\n\
+                       and write each screen shown to FILE\n\
+      --ansi-frames    write those screens as ANSI escape sequences\n\
+      --frame-bytes=FILE\n\
+                       write the bytes sent to the terminal for each of\n\
+                       those screens to FILE\n\n\
 "));
 	printf(_("\
-If GAME is specified as a number between 1 and 9, load and continue\n\
-playing that game.  If GAME is not specified, start a new game.\n\n\
-"));
+If GAME is specified as a number between 1 and %d, load and continue\n\
+playing that game.  If GAME is specified as a name of up to %d letters,\n\
+digits, '.', '-' and '_', load the game saved under that name, or start\n\
+a new game to be saved under that name.  If GAME is not specified, start\n\
+a new game.\n\n\
+"), MAX_GAME_NUM, GAME_NAME_LEN);
 
 #ifdef PACKAGE_AUTHOR
 	/* TRANSLATORS: The first %s is the proper name of the package
@@ -384,12 +560,16 @@ void init_program (void)
 {
     // Initialise the random number generator
     init_rand();
+    startup_mark("initialising the random number generator");
 
     // Initialise locale-specific variables
     init_locale_vars();
+    startup_mark("initialising locale-specific variables");
 
-    // Initialise the terminal display
-    init_screen();
+    // Initialise the terminal display, unless hosting games instead
+    if (option_server == NULL) {
+	init_screen();
+    }
 }
 
 
@@ -398,7 +578,11 @@ void init_program (void)
 
 void end_program (void)
 {
-    end_screen();
+    if (option_server == NULL) {
+	end_screen();
+    }
+
+    startup_report();
 }
 
 
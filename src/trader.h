@@ -43,8 +43,14 @@
 #include "move.h"		// Making and processing a move
 #include "exch.h"		// Stock Exchange and Bank functions
 #include "fileio.h"		// Load and save game file functions
+#include "archive.h"		// Game archive functions
+#include "replay.h"		// Game replay functions
+#include "export.h"		// Game state export functions
 #include "help.h"		// Help text functions: how to play
 #include "intf.h"		// Basic text input/output functions
+#include "headless.h"		// Running without a terminal
+#include "spectate.h"		// Sending the screen to spectators
+#include "server.h"		// Hosting games for network clients
 #include "utils.h"		// Utility functions needed by Star Traders
 
 
@@ -53,9 +59,17 @@
 ************************************************************************/
 
 #define GAME_FILE_HEADER	"Star Traders Saved Game"
-#define GAME_FILE_API_VERSION	"File API 7.5"	// For game loads and saves
+#define GAME_FILE_API_VERSION	"File API 7.6"	// For game loads and saves
+#define GAME_FILE_API_OLD_VERSION "File API 7.5" // Loadable, has no summary
+						 // or whole-file checksum
+#define GAME_INDEX_HEADER	"Star Traders Game Index"
 #define GAME_FILE_SENTINEL	42		// End of game file sentinel
 
+// Values for the encryption status field in the game file
+#define GAME_FILE_PLAIN		0	// Not encrypted
+#define GAME_FILE_ENCRYPTED	1	// Encrypted, checksum on every line
+#define GAME_FILE_WHOLE_CRC	2	// Encrypted, one checksum for the file
+
 #ifdef USE_UTF8_GAME_FILE
 #  define GAME_FILE_CHARSET	"UTF-8"		// For strings in game file
 #  define GAME_FILE_TRANSLIT	"//TRANSLIT"	// Transliterate (GNU libiconv)
@@ -37,6 +37,8 @@
 
 const char *program_name = NULL;	// Canonical program name
 
+unsigned long int random_seed = 0;	// Seed used by init_rand()
+
 
 // Global copy, suitably modified, of localeconv() information
 struct lconv lconvinfo;
@@ -62,6 +64,8 @@ wchar_t *mon_thousands_sep;		// Locale's monetary thousands separator
 #define GAME_FILENAME_PROTO	"game%d"
 #define GAME_FILENAME_BUFSIZE	16
 
+#define STARTUP_MAX_PHASES	16		// Phases timed by startup_mark()
+
 // Values used to override the standard POSIX locale
 #define MOD_POSIX_DECIMAL_POINT		"."
 #define MOD_POSIX_THOUSANDS_SEP		""
@@ -184,44 +188,80 @@ static const signed char unscramble_table[] = {
 
 #define UNSCRAMBLE_TABLE_SIZE (sizeof(unscramble_table) / sizeof(unscramble_table[0]))
 
-static const unsigned char xor_table[] = {
-    /* Set of bytes 0x00 to 0xFF in random order; each byte in an input
-       string is XORed with successive bytes in this table. */
-    0x00, 0xCE, 0xB1, 0x9F, 0xE4, 0xE0, 0xE3, 0x79,
-    0xA1, 0x3B, 0x4E, 0x89, 0x81, 0x84, 0x43, 0xC8,
-    0xBE, 0x0F, 0x67, 0x2A, 0xB4, 0xD8, 0xBA, 0x5D,
-    0x94, 0x06, 0x69, 0x0E, 0x1C, 0x48, 0x9E, 0x0A,
-    0x1D, 0x09, 0x02, 0xCD, 0xD4, 0xF6, 0x5B, 0x8A,
-    0xAE, 0x65, 0xB3, 0xB5, 0xA7, 0x13, 0x03, 0xF2,
-    0x42, 0xF0, 0xA6, 0xAA, 0x35, 0xCB, 0x2C, 0x55,
-    0xF5, 0xC7, 0x32, 0xB7, 0x6B, 0xEA, 0xC3, 0x6F,
-    0x41, 0xFF, 0xD1, 0x24, 0x54, 0xA9, 0xC6, 0xC2,
-    0x74, 0xEE, 0xBC, 0x99, 0x59, 0x71, 0x3D, 0x85,
-    0x0B, 0xF7, 0x3A, 0x7E, 0xDB, 0x45, 0xE8, 0x96,
-    0xD0, 0xC1, 0xE6, 0xFD, 0x86, 0x8C, 0x9B, 0x0C,
-    0x66, 0x5F, 0xE5, 0x14, 0x98, 0x3C, 0xBD, 0xE2,
-    0x88, 0xA3, 0x30, 0x38, 0x2F, 0xA2, 0x37, 0x70,
-    0xB8, 0x11, 0x61, 0x93, 0x52, 0x1B, 0xDD, 0x20,
-    0x60, 0x19, 0xEF, 0xD2, 0xEC, 0x73, 0x07, 0x92,
-    0x4C, 0x6A, 0xA8, 0x9D, 0x34, 0x04, 0x87, 0x2E,
-    0x1E, 0xA4, 0xCA, 0x72, 0x63, 0xD7, 0x7F, 0xFB,
-    0x68, 0xE1, 0xBF, 0x10, 0x8E, 0xAF, 0x9A, 0xFA,
-    0xA0, 0xDE, 0x1F, 0x31, 0x15, 0x97, 0xED, 0x2B,
-    0x36, 0x8D, 0x12, 0xC5, 0x23, 0x95, 0x33, 0x56,
-    0x4F, 0xE7, 0xAD, 0x5C, 0x4B, 0x83, 0xDC, 0x29,
-    0xE9, 0xCF, 0x8F, 0x58, 0x4D, 0x5A, 0x08, 0x49,
-    0xFC, 0x6D, 0x7C, 0xB6, 0xD3, 0x7B, 0xD6, 0x53,
-    0x57, 0x82, 0x0D, 0xD9, 0x7D, 0xDA, 0x4A, 0xDF,
-    0x27, 0x40, 0x1A, 0x22, 0xC9, 0x51, 0x3E, 0x6C,
-    0xC4, 0x18, 0xCC, 0xAC, 0xEB, 0xA5, 0xF4, 0x44,
-    0xFE, 0x76, 0xF8, 0x75, 0xF3, 0x2D, 0xB0, 0xB9,
-    0x9C, 0x47, 0x7A, 0x28, 0xBB, 0xF1, 0x16, 0x64,
-    0x46, 0x21, 0x78, 0x90, 0xD5, 0x80, 0x3F, 0x39,
-    0x25, 0xB2, 0x6E, 0x8B, 0x77, 0xC0, 0x05, 0x50,
+/* Set of bytes 0x00 to 0xFF in random order; each byte in an input
+   string is XORed with successive bytes in this table. */
+#define XOR_TABLE_BYTES							     \
+    0x00, 0xCE, 0xB1, 0x9F, 0xE4, 0xE0, 0xE3, 0x79,			     \
+    0xA1, 0x3B, 0x4E, 0x89, 0x81, 0x84, 0x43, 0xC8,			     \
+    0xBE, 0x0F, 0x67, 0x2A, 0xB4, 0xD8, 0xBA, 0x5D,			     \
+    0x94, 0x06, 0x69, 0x0E, 0x1C, 0x48, 0x9E, 0x0A,			     \
+    0x1D, 0x09, 0x02, 0xCD, 0xD4, 0xF6, 0x5B, 0x8A,			     \
+    0xAE, 0x65, 0xB3, 0xB5, 0xA7, 0x13, 0x03, 0xF2,			     \
+    0x42, 0xF0, 0xA6, 0xAA, 0x35, 0xCB, 0x2C, 0x55,			     \
+    0xF5, 0xC7, 0x32, 0xB7, 0x6B, 0xEA, 0xC3, 0x6F,			     \
+    0x41, 0xFF, 0xD1, 0x24, 0x54, 0xA9, 0xC6, 0xC2,			     \
+    0x74, 0xEE, 0xBC, 0x99, 0x59, 0x71, 0x3D, 0x85,			     \
+    0x0B, 0xF7, 0x3A, 0x7E, 0xDB, 0x45, 0xE8, 0x96,			     \
+    0xD0, 0xC1, 0xE6, 0xFD, 0x86, 0x8C, 0x9B, 0x0C,			     \
+    0x66, 0x5F, 0xE5, 0x14, 0x98, 0x3C, 0xBD, 0xE2,			     \
+    0x88, 0xA3, 0x30, 0x38, 0x2F, 0xA2, 0x37, 0x70,			     \
+    0xB8, 0x11, 0x61, 0x93, 0x52, 0x1B, 0xDD, 0x20,			     \
+    0x60, 0x19, 0xEF, 0xD2, 0xEC, 0x73, 0x07, 0x92,			     \
+    0x4C, 0x6A, 0xA8, 0x9D, 0x34, 0x04, 0x87, 0x2E,			     \
+    0x1E, 0xA4, 0xCA, 0x72, 0x63, 0xD7, 0x7F, 0xFB,			     \
+    0x68, 0xE1, 0xBF, 0x10, 0x8E, 0xAF, 0x9A, 0xFA,			     \
+    0xA0, 0xDE, 0x1F, 0x31, 0x15, 0x97, 0xED, 0x2B,			     \
+    0x36, 0x8D, 0x12, 0xC5, 0x23, 0x95, 0x33, 0x56,			     \
+    0x4F, 0xE7, 0xAD, 0x5C, 0x4B, 0x83, 0xDC, 0x29,			     \
+    0xE9, 0xCF, 0x8F, 0x58, 0x4D, 0x5A, 0x08, 0x49,			     \
+    0xFC, 0x6D, 0x7C, 0xB6, 0xD3, 0x7B, 0xD6, 0x53,			     \
+    0x57, 0x82, 0x0D, 0xD9, 0x7D, 0xDA, 0x4A, 0xDF,			     \
+    0x27, 0x40, 0x1A, 0x22, 0xC9, 0x51, 0x3E, 0x6C,			     \
+    0xC4, 0x18, 0xCC, 0xAC, 0xEB, 0xA5, 0xF4, 0x44,			     \
+    0xFE, 0x76, 0xF8, 0x75, 0xF3, 0x2D, 0xB0, 0xB9,			     \
+    0x9C, 0x47, 0x7A, 0x28, 0xBB, 0xF1, 0x16, 0x64,			     \
+    0x46, 0x21, 0x78, 0x90, 0xD5, 0x80, 0x3F, 0x39,			     \
+    0x25, 0xB2, 0x6E, 0x8B, 0x77, 0xC0, 0x05, 0x50,			     \
     0x17, 0xF9, 0x01, 0x26, 0x91, 0x5E, 0x62, 0xAB
+
+/* The table is stored twice in succession, so that the keystream for any
+   starting key is available as one contiguous run of up to XOR_TABLE_SIZE
+   bytes: apply_xor() can then XOR a machine word at a time. */
+static const unsigned char xor_keystream[] = {
+    XOR_TABLE_BYTES,
+    XOR_TABLE_BYTES
 };
 
-#define XOR_TABLE_SIZE (sizeof(xor_table) / sizeof(xor_table[0]))
+#define XOR_TABLE_SIZE (sizeof(xor_keystream) / sizeof(xor_keystream[0]) / 2)
+
+// Each entry of the pair table holds two scramble_table[] characters
+#define B64_PAIR_TABLE_SIZE	(1 << 12)	// Indexed by 12 bits of input
+
+// Constants used for scratch memory
+#define SCRATCH_BLOCK_SIZE	(64 * 1024)	// Minimum size of each block
+#define SCRATCH_ALIGN		16		// Alignment of each allocation
+
+// Monetary values are formatted without strfmon() if, once multiplied by
+// 10 to the power of frac_digits, they are less than this (2^53), and
+// are not so close to halfway between two values that the rounding is
+// in doubt
+#define MONFMT_MAX_SCALED	9007199254740992.0
+#define MONFMT_ROUND_MARGIN	4.0e-16
+#define MONFMT_MAX_FRAC_DIGITS	8
+#define MONFMT_NUMBUFSIZE	128	// Digits, separators and radix
+
+// Rules for formatting monetary values, prepared by init_locale_vars()
+// from lconvinfo; index 0 is for positive values, 1 for negative ones
+struct monfmt {
+    bool		valid;		// True if these rules may be used
+    int			frac_digits;	// Digits after the radix character
+    double		scale;		// 10 to the power of frac_digits
+    char		*grouping;	// Copy of lconvinfo.mon_grouping
+    wchar_t		*sign[2];	// Sign strings
+    bool		cs_precedes[2];	// Currency symbol precedes value?
+    int			sep_by_space[2];  // Spaces as for localeconv()
+    int			sign_posn[2];	// Position of sign, 0 to 4
+};
 
 
 /************************************************************************
@@ -231,7 +271,27 @@ static const unsigned char xor_table[] = {
 static char *home_directory_str = NULL;		// Full pathname to home
 static char *data_directory_str = NULL;		// Writable data dir pathname
 
+// Phases of starting up, as timed by startup_mark()
+static const char *startup_phase[STARTUP_MAX_PHASES];
+static double startup_time[STARTUP_MAX_PHASES];	// Milliseconds taken
+static int startup_num_phases = 0;
+static struct timespec startup_last;		// Time of the last mark
+static bool startup_done = false;		// True once startup_end() called
+
 static bool is_posix_locale = false;		// Override strfmon()?
+static char *numeric_radix = NULL;		// LC_NUMERIC radix character
+static struct monfmt monfmt;			// Rules used by xwcsfmon()
+
+// Base64 encoding of every 12-bit value, built on first use
+static char b64_pair_table[B64_PAIR_TABLE_SIZE][2];
+static bool b64_pair_table_initialised = false;
+
+// Scratch memory, as blocks that are kept once allocated
+static unsigned char **scratch_blocks = NULL;	// Blocks of memory
+static size_t *scratch_block_size = NULL;	// Size of each block
+static int scratch_num_blocks = 0;		// Number of blocks allocated
+static int scratch_cur = -1;			// Block in use, or -1
+static size_t scratch_used = 0;			// Bytes used in that block
 
 
 /************************************************************************
@@ -239,15 +299,16 @@ static bool is_posix_locale = false;		// Override strfmon()?
 ************************************************************************/
 
 /*
-  Function:   apply_xor - Scramble a buffer using xor_table
+  Function:   apply_xor - Scramble a buffer using xor_keystream
   Parameters: dest      - Location of destination buffer
               src       - Location of source buffer
               n         - Number of bytes to scramble
-              key       - Pointer to xor_table index
+              key       - Pointer to xor_keystream index
   Returns:    (nothing)
 
   This function copies n bytes from *src into *dest, applying a XOR with
-  the contents of xor_table in the process.  It is a reversible function:
+  the contents of xor_keystream[] in the process; *key is advanced by n
+  (modulo XOR_TABLE_SIZE).  It is a reversible function:
   apply_xor(apply_xor(buffer)) == buffer.  It is used by both scramble()
   and unscramble().
 */
@@ -297,6 +358,64 @@ static ssize_t b64decode (const void *restrict in, size_t inlen,
 			  void *restrict out, size_t outlen);
 
 
+/*
+  Function:   init_b64_pair_table - Initialise the Base64 pair table
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function fills in b64_pair_table[] so that b64encode() can convert
+  twelve bits of input into two output characters with a single table
+  lookup, instead of handling each six-bit value separately.
+*/
+static void init_b64_pair_table (void);
+
+
+/*
+  Function:   init_monfmt - Prepare the rules for formatting money
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function fills in monfmt from lconvinfo and the wide-character
+  locale strings, so that xwcsfmon() need not call strfmon() or look at
+  the locale again.  It must be called by init_locale_vars() once those
+  strings have been set.
+*/
+static void init_monfmt (void);
+
+
+/*
+  Function:   wcsfmon_fast - Format a monetary value using monfmt
+  Parameters: buf          - Buffer to receive result
+              maxsize      - Size of buffer, in multiples of wchar_t
+              nosym        - True to leave out the currency symbol
+              val          - Monetary value to convert
+  Returns:    ssize_t      - Length of the string, or -1 if not possible
+
+  This function formats val as strfmon() would with the format "%n" (or
+  "%!n" if nosym is true), using the rules in monfmt.  It does not
+  allocate any memory.  If val is too large or not a finite number, or
+  if it lies too close to halfway between two values for the rounding
+  to be certain, or if monfmt cannot be used, -1 is returned and buf is
+  left unchanged.
+*/
+static ssize_t wcsfmon_fast (wchar_t *restrict buf, size_t maxsize,
+			     bool nosym, double val);
+
+
+/*
+  Function:   wcsappend - Append a wide-character string to a buffer
+  Parameters: p         - Position in the buffer to append to
+              end       - End of the buffer, less room for a NUL
+              str       - String to append
+  Returns:    wchar_t * - Position just after the appended string
+
+  This function copies as much of str to p as fits before end.  The
+  result is not NUL-terminated.
+*/
+static wchar_t *wcsappend (wchar_t *restrict p, const wchar_t *end,
+			   const wchar_t *restrict str);
+
+
 /************************************************************************
 *          Initialisation and environment function definitions          *
 ************************************************************************/
@@ -436,39 +555,131 @@ const char *data_directory (void)
 
 
 /***********************************************************************/
-// game_filename: Convert an integer to a game filename
+// data_filename: Return the full pathname of a file in the data directory
 
-char *game_filename (int gamenum)
+char *data_filename (const char *name)
 {
     /* This implementation assumes a POSIX environment and an ASCII-safe
        character encoding. */
 
     const char *dirsep = DIRSEP;
-
-    char buf[GAME_FILENAME_BUFSIZE];	// Buffer for part of filename
     const char *dd;			// Data directory
 
 
-    if (gamenum < 1 || gamenum > 9) {
-	return NULL;
-    }
+    assert(name != NULL);
 
     dd = data_directory();
-    snprintf(buf, GAME_FILENAME_BUFSIZE, GAME_FILENAME_PROTO, gamenum);
 
     if (dd == NULL) {
-	return xstrdup(buf);
+	return xstrdup(name);
     } else {
-	char *p = xmalloc(strlen(dd) + strlen(dirsep) + strlen(buf) + 1);
+	char *p = xmalloc(strlen(dd) + strlen(dirsep) + strlen(name) + 1);
 
 	strcpy(p, dd);
 	strcat(p, dirsep);
-	strcat(p, buf);
+	strcat(p, name);
 	return p;
     }
 }
 
 
+/***********************************************************************/
+// game_filename: Convert an integer to a game filename
+
+char *game_filename (int gamenum)
+{
+    char buf[GAME_FILENAME_BUFSIZE];	// Buffer for part of filename
+
+
+    if (gamenum < 1 || gamenum > MAX_GAME_NUM) {
+	return NULL;
+    }
+
+    snprintf(buf, GAME_FILENAME_BUFSIZE, GAME_FILENAME_PROTO, gamenum);
+    return data_filename(buf);
+}
+
+
+/***********************************************************************/
+// game_filename_num: Convert a game filename to an integer
+
+int game_filename_num (const char *name)
+{
+    char buf[GAME_FILENAME_BUFSIZE];
+    int gamenum;
+
+
+    assert(name != NULL);
+
+    if (sscanf(name, GAME_FILENAME_PROTO, &gamenum) != 1
+	|| gamenum < 1 || gamenum > MAX_GAME_NUM) {
+	return 0;
+    }
+
+    // Only accept the canonical form of the filename
+    snprintf(buf, GAME_FILENAME_BUFSIZE, GAME_FILENAME_PROTO, gamenum);
+    return (strcmp(name, buf) == 0) ? gamenum : 0;
+}
+
+
+/***********************************************************************/
+// startup_mark: Note that a phase of starting up has finished
+
+void startup_mark (const char *phase)
+{
+    struct timespec now;
+
+
+    if (startup_done || startup_num_phases == STARTUP_MAX_PHASES) {
+	return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (phase != NULL) {
+	startup_phase[startup_num_phases] = phase;
+	startup_time[startup_num_phases] =
+	    (now.tv_sec - startup_last.tv_sec) * 1000.0
+	    + (now.tv_nsec - startup_last.tv_nsec) / 1000000.0;
+	startup_num_phases++;
+    }
+
+    startup_last = now;
+}
+
+
+/***********************************************************************/
+// startup_end: Note that the program has started up
+
+void startup_end (void)
+{
+    startup_mark("showing the first screen");
+    startup_done = true;
+}
+
+
+/***********************************************************************/
+// startup_report: Show how long starting up took
+
+void startup_report (void)
+{
+    double total = 0.0;
+
+
+    if (! option_startup_profile) {
+	return;
+    }
+
+    fprintf(stderr, _("%s: time taken to start up, in milliseconds:\n"),
+	    program_name);
+    for (int i = 0; i < startup_num_phases; i++) {
+	fprintf(stderr, "%10.3f  %s\n", startup_time[i], startup_phase[i]);
+	total += startup_time[i];
+    }
+    fprintf(stderr, "%10.3f  %s\n", total, _("total"));
+}
+
+
 /************************************************************************
 *                 Error-reporting function definitions                  *
 ************************************************************************/
@@ -552,6 +763,7 @@ void init_rand (void)
     gettimeofday(&tv, NULL);		// If this fails, tv is random enough!
     seed = tv.tv_sec + tv.tv_usec;
 
+    random_seed = seed;
     srand48(seed);
 }
 
@@ -574,6 +786,35 @@ extern int randi (int limit)
 }
 
 
+/***********************************************************************/
+// get_rand_state: Return the state of the random number generator
+
+void get_rand_state (unsigned short int state[3])
+{
+    unsigned short int tmp[3] = { 0, 0, 0 };
+    unsigned short int *cur;
+
+
+    // seed48() returns the previous state; put it straight back
+    cur = seed48(tmp);
+    memcpy(state, cur, 3 * sizeof(unsigned short int));
+    seed48(state);
+}
+
+
+/***********************************************************************/
+// set_rand_state: Restore the state of the random number generator
+
+void set_rand_state (const unsigned short int state[3])
+{
+    unsigned short int tmp[3];
+
+
+    memcpy(tmp, state, sizeof(tmp));
+    seed48(tmp);
+}
+
+
 /************************************************************************
 *                   Locale-aware function definitions                   *
 ************************************************************************/
@@ -620,6 +861,10 @@ void init_locale_vars (void)
     is_posix_locale = false;
     lconvinfo = *lc;
 
+    // Remember the real radix character for xdtostr() and xstrtod()
+    free(numeric_radix);
+    numeric_radix = xstrdup(lc->decimal_point);
+
     /* Are we in the POSIX locale?  The string returned by setlocale() is
        supposed to be opaque, but in practise is not.  To be on the safe
        side, we explicitly set the locale to "C", then test the returned
@@ -656,8 +901,21 @@ void init_locale_vars (void)
     xmbstowcs(buf, lconvinfo.mon_thousands_sep, BUFSIZE);
     mon_thousands_sep = xwcsdup(buf);
 
+    free(monfmt.sign[0]);
+    xmbstowcs(buf, lconvinfo.positive_sign, BUFSIZE);
+    monfmt.sign[0] = xwcsdup(buf);
+
+    free(monfmt.sign[1]);
+    xmbstowcs(buf, lconvinfo.negative_sign, BUFSIZE);
+    monfmt.sign[1] = xwcsdup(buf);
+
+    free(monfmt.grouping);
+    monfmt.grouping = xstrdup(lconvinfo.mon_grouping);
+
     free(buf);
 
+    init_monfmt();
+
     setlocale(LC_MONETARY, cur);
     free(cur);
 }
@@ -670,9 +928,24 @@ ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
 		  const char *restrict format, double val)
 {
     ssize_t n;
-    char *s = xmalloc(BUFSIZE);
+    char *s;
 
 
+    // Nearly all values can be formatted without calling strfmon()
+    if (format[0] == '%' && format[1] == 'n' && format[2] == '\0') {
+	n = wcsfmon_fast(buf, maxsize, false, val);
+	if (n >= 0) {
+	    return n;
+	}
+    } else if (strcmp(format, "%!n") == 0) {
+	n = wcsfmon_fast(buf, maxsize, true, val);
+	if (n >= 0) {
+	    return n;
+	}
+    }
+
+    s = xmalloc(BUFSIZE);
+
     /* Current and previous versions of ISO/IEC 9945-1 (POSIX), namely
        SUSv3 (2001) and SUSv4 (2008), require strfmon() to return rather
        meaningless strings when used with the POSIX "C" locale.  In
@@ -753,6 +1026,368 @@ ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
 }
 
 
+/***********************************************************************/
+// init_monfmt: Prepare the rules for formatting money
+
+void init_monfmt (void)
+{
+    const char cs_precedes[2] = {
+	lconvinfo.p_cs_precedes,   lconvinfo.n_cs_precedes
+    };
+    const char sep_by_space[2] = {
+	lconvinfo.p_sep_by_space,  lconvinfo.n_sep_by_space
+    };
+    const char sign_posn[2] = {
+	lconvinfo.p_sign_posn,     lconvinfo.n_sign_posn
+    };
+
+
+    // Use the same defaults as strfmon() for unspecified values
+
+    monfmt.frac_digits = (lconvinfo.frac_digits == CHAR_MAX) ?
+	2 : lconvinfo.frac_digits;
+    monfmt.valid = (monfmt.frac_digits >= 0
+		    && monfmt.frac_digits <= MONFMT_MAX_FRAC_DIGITS);
+
+    monfmt.scale = 1.0;
+    for (int i = 0; i < monfmt.frac_digits; i++) {
+	monfmt.scale *= 10.0;
+    }
+
+    for (int i = 0; i < 2; i++) {
+	monfmt.cs_precedes[i]  = (cs_precedes[i] != 0);
+	monfmt.sep_by_space[i] = (sep_by_space[i] < 0 || sep_by_space[i] > 2) ?
+	    0 : sep_by_space[i];
+	monfmt.sign_posn[i]    = (sign_posn[i] < 0 || sign_posn[i] > 4) ?
+	    1 : sign_posn[i];
+    }
+
+    // A negative value must be shown as such, even if no sign is given
+    if (*monfmt.sign[1] == L'\0') {
+	free(monfmt.sign[1]);
+	monfmt.sign[1] = xwcsdup(L"-");
+    }
+}
+
+
+/***********************************************************************/
+// wcsfmon_fast: Format a monetary value using monfmt
+
+ssize_t wcsfmon_fast (wchar_t *restrict buf, size_t maxsize, bool nosym,
+		      double val)
+{
+    wchar_t numbuf[MONFMT_NUMBUFSIZE];
+    wchar_t *num, *p, *end;
+    const wchar_t *sign, *cs;
+    unsigned long long int q;
+    double frac;
+    int neg, group, left, i;
+    const char *grouping;
+    size_t seplen;
+    bool cs_first, sign_first;
+    int sep, posn;
+
+
+    if (! monfmt.valid || maxsize == 0) {
+	return -1;
+    }
+
+    neg = (val < 0.0);
+    val = neg ? -val : val;
+    val *= monfmt.scale;
+    if (! (val < MONFMT_MAX_SCALED)) {
+	// Too large, infinite or not a number: let strfmon() handle it
+	return -1;
+    }
+
+    q = (unsigned long long int) val;
+    frac = val - (double) q;
+    if (frac - 0.5 < val * MONFMT_ROUND_MARGIN
+	&& 0.5 - frac < val * MONFMT_ROUND_MARGIN) {
+	// Too close to call: let strfmon() round it exactly
+	return -1;
+    }
+    if (frac > 0.5) {
+	q++;
+    }
+
+    // Build the number backwards from the end of numbuf
+
+    num = numbuf + MONFMT_NUMBUFSIZE;
+    *--num = L'\0';
+
+    for (i = 0; i < monfmt.frac_digits; i++) {
+	*--num = L'0' + (wchar_t) (q % 10);
+	q /= 10;
+    }
+    if (monfmt.frac_digits > 0) {
+	size_t len = wcslen(mon_decimal_point);
+	num -= len;
+	wmemcpy(num, mon_decimal_point, len);
+    }
+
+    grouping = monfmt.grouping;
+    seplen = wcslen(mon_thousands_sep);
+    group = (seplen > 0 && *grouping > 0 && *grouping != CHAR_MAX) ?
+	*grouping : -1;
+    left = group;
+
+    do {
+	if (left == 0) {
+	    if (num - numbuf < (ptrdiff_t) seplen + 1) {
+		return -1;
+	    }
+	    num -= seplen;
+	    wmemcpy(num, mon_thousands_sep, seplen);
+
+	    // Move on to the next group size, repeating the last one
+	    if (grouping[1] != '\0') {
+		grouping++;
+		group = (*grouping > 0 && *grouping != CHAR_MAX) ?
+		    *grouping : -1;
+	    }
+	    left = group;
+	}
+
+	if (num == numbuf) {
+	    return -1;
+	}
+	*--num = L'0' + (wchar_t) (q % 10);
+	q /= 10;
+	left--;
+    } while (q > 0);
+
+    // Place the sign and currency symbol around the number
+
+    sign = monfmt.sign[neg];
+    cs = nosym ? L"" : currency_symbol;
+    cs_first = monfmt.cs_precedes[neg];
+    sep = nosym ? 0 : monfmt.sep_by_space[neg];
+    posn = monfmt.sign_posn[neg];
+
+    p = buf;
+    end = buf + maxsize - 1;
+
+    if (posn == 0) {
+	// Parentheses surround the number and currency symbol
+	p = wcsappend(p, end, L"(");
+	if (cs_first) {
+	    p = wcsappend(p, end, cs);
+	    p = wcsappend(p, end, (sep != 0) ? L" " : L"");
+	}
+	p = wcsappend(p, end, num);
+	if (! cs_first) {
+	    p = wcsappend(p, end, (sep != 0) ? L" " : L"");
+	    p = wcsappend(p, end, cs);
+	}
+	p = wcsappend(p, end, L")");
+    } else if (cs_first) {
+	// Currency symbol before the number: the sign may be first (1, 3),
+	// last (2) or between the two (4)
+	sign_first = (posn == 1 || posn == 3);
+	if (sign_first) {
+	    p = wcsappend(p, end, sign);
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	}
+	p = wcsappend(p, end, cs);
+	if (posn == 4) {
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	    p = wcsappend(p, end, sign);
+	}
+	p = wcsappend(p, end, (sep == 1) ? L" " : L"");
+	p = wcsappend(p, end, num);
+	if (posn == 2) {
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	    p = wcsappend(p, end, sign);
+	}
+    } else {
+	// Currency symbol after the number: the sign may be first (1),
+	// last (2, 4) or between the two (3)
+	if (posn == 1) {
+	    p = wcsappend(p, end, sign);
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	}
+	p = wcsappend(p, end, num);
+	if (posn == 3) {
+	    p = wcsappend(p, end, (sep == 1) ? L" " : L"");
+	    p = wcsappend(p, end, sign);
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	} else {
+	    p = wcsappend(p, end, (sep == 1) ? L" " : L"");
+	}
+	p = wcsappend(p, end, cs);
+	if (posn == 2 || posn == 4) {
+	    p = wcsappend(p, end, (sep == 2) ? L" " : L"");
+	    p = wcsappend(p, end, sign);
+	}
+    }
+
+    *p = L'\0';
+    return p - buf;
+}
+
+
+/***********************************************************************/
+// wcsappend: Append a wide-character string to a buffer
+
+wchar_t *wcsappend (wchar_t *restrict p, const wchar_t *end,
+		    const wchar_t *restrict str)
+{
+    while (*str != L'\0' && p < end) {
+	*p++ = *str++;
+    }
+
+    return p;
+}
+
+
+/***********************************************************************/
+// xdtostr: Convert a double to a locale-independent string
+
+char *xdtostr (char *restrict buf, size_t bufsize, double val)
+{
+    char tmp[DTOSTR_BUFSIZE];
+    char out[DTOSTR_BUFSIZE];
+    const char *radix = (numeric_radix != NULL) ? numeric_radix
+	: localeconv()->decimal_point;	// Not yet set by init_locale_vars()
+    size_t radixlen = strlen(radix);
+    char *p, *q, *fracend;
+    int prec;
+
+
+    assert(buf != NULL);
+    assert(bufsize > 0);
+
+    if (! isfinite(val)) {
+	snprintf(buf, bufsize, "%e", val);
+	return buf;
+    }
+
+    /* Any decimal number of DBL_DIG or fewer significant digits that
+       reads back as val is found by rounding to DBL_DIG digits and then
+       dropping trailing zeros; only if that fails are more digits
+       needed.  snprintf() and strtod() use the same locale, so the
+       round trip check can be done on the unconverted string. */
+    for (prec = DBL_DIG - 1; prec < DBL_DIG + 1; prec++) {
+	snprintf(tmp, sizeof(tmp), "%.*e", prec, val);
+	if (strtod(tmp, NULL) == val) {
+	    break;
+	}
+    }
+    if (prec == DBL_DIG + 1) {
+	snprintf(tmp, sizeof(tmp), "%.*e", prec, val);
+    }
+
+    // Copy the sign and leading digit, then the fraction, if any
+    p = tmp;
+    q = out;
+    if (*p == '-') {
+	*q++ = *p++;
+    }
+    *q++ = *p++;
+
+    if (strncmp(p, radix, radixlen) == 0) {
+	p += radixlen;
+    }
+
+    *q++ = '.';
+    for (fracend = q; *p >= '0' && *p <= '9'; p++) {
+	*q++ = *p;
+	if (*p != '0') {
+	    fracend = q;
+	}
+    }
+
+    // Drop trailing zeros (and the radix character if nothing is left)
+    q = fracend;
+    if (q[-1] == '.') {
+	q--;
+    }
+
+    // Copy the exponent as is
+    strcpy(q, p);
+
+    snprintf(buf, bufsize, "%s", out);
+    return buf;
+}
+
+
+/***********************************************************************/
+// xdtofixed: Convert a double to a locale-independent fixed-point string
+
+char *xdtofixed (char *restrict buf, size_t bufsize, double val, int places)
+{
+    const char *radix = (numeric_radix != NULL) ? numeric_radix
+	: localeconv()->decimal_point;	// Not yet set by init_locale_vars()
+    size_t radixlen = strlen(radix);
+    char *p;
+
+
+    assert(buf != NULL);
+    assert(bufsize > 0);
+    assert(places >= 0);
+
+    snprintf(buf, bufsize, "%.*f", places, val);
+
+    if (strcmp(radix, ".") != 0 && (p = strstr(buf, radix)) != NULL) {
+	*p = '.';
+	memmove(p + 1, p + radixlen, strlen(p + radixlen) + 1);
+    }
+
+    return buf;
+}
+
+
+/***********************************************************************/
+// xstrtod: Convert a locale-independent string to a double
+
+double xstrtod (const char *restrict str, char **restrict endptr)
+{
+    char tmp[DTOSTR_BUFSIZE];
+    const char *radix = (numeric_radix != NULL) ? numeric_radix
+	: localeconv()->decimal_point;	// Not yet set by init_locale_vars()
+    size_t radixlen = strlen(radix);
+    const char *dot;
+    size_t dotpos, endpos;
+    char *end;
+    double val;
+
+
+    assert(str != NULL);
+
+    // Nothing to do if the locale already uses "."
+    dot = strchr(str, '.');
+    if (dot == NULL || strcmp(radix, ".") == 0) {
+	return strtod(str, endptr);
+    }
+
+    // Otherwise, replace "." with the locale's radix character
+    dotpos = dot - str;
+    if (dotpos + radixlen + strlen(dot + 1) >= sizeof(tmp)) {
+	// Far too long to be a number: let strtod() reject or truncate it
+	return strtod(str, endptr);
+    }
+
+    memcpy(tmp, str, dotpos);
+    memcpy(tmp + dotpos, radix, radixlen);
+    strcpy(tmp + dotpos + radixlen, dot + 1);
+
+    val = strtod(tmp, &end);
+
+    if (endptr != NULL) {
+	endpos = end - tmp;
+	if (endpos >= dotpos + radixlen) {
+	    endpos -= radixlen - 1;
+	} else if (endpos > dotpos) {
+	    endpos = dotpos;
+	}
+	*endptr = (char *) str + endpos;
+    }
+
+    return val;
+}
+
+
 /************************************************************************
 *                    Encryption function definitions                    *
 ************************************************************************/
@@ -765,9 +1400,10 @@ ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
 // scramble: Scramble (encrypt) the buffer
 
 char *scramble (char *restrict dest, const char *restrict src,
-		size_t size, unsigned int *restrict key)
+		size_t size, unsigned int *restrict key,
+		unsigned long int *restrict crc)
 {
-    unsigned long int crc;
+    unsigned long int line_crc;
     unsigned int chksum;
     size_t srclen;
     char *xorbuf, *midxor;
@@ -793,6 +1429,16 @@ char *scramble (char *restrict dest, const char *restrict src,
 	    dest[srclen] = '\n';
 	    dest[srclen + 1] = '\0';
 	}
+    } else if (crc != NULL) {
+	// Scramble the input, leaving checksums to the caller
+
+	xorbuf = xmalloc(srclen + 1);
+
+	apply_xor(xorbuf, src, srclen, key);
+	*crc = crc32_update(*crc, xorbuf, srclen) & SCRAMBLE_CRC_MASK;
+	b64encode(xorbuf, srclen, dest, size);
+
+	free(xorbuf);
     } else {
 	// Scramble the input
 
@@ -803,8 +1449,8 @@ char *scramble (char *restrict dest, const char *restrict src,
 	apply_xor(midxor, src, srclen, key);
 
 	// Calculate CRC32 checksum of XORed buffer
-	crc = crc32(midxor, srclen) & SCRAMBLE_CRC_MASK;
-	snprintf(crcbuf, SCRAMBLE_CRC_LEN + 1, "%08lx", crc);
+	line_crc = crc32(midxor, srclen) & SCRAMBLE_CRC_MASK;
+	snprintf(crcbuf, SCRAMBLE_CRC_LEN + 1, "%08lx", line_crc);
 	memcpy(xorbuf, crcbuf, SCRAMBLE_CRC_LEN);
 
 	// Encode whole buffer (including CRC32) using Base64
@@ -834,9 +1480,10 @@ char *scramble (char *restrict dest, const char *restrict src,
 // unscramble: Unscramble (decrypt) the buffer
 
 char *unscramble (char *restrict dest, const char *restrict src,
-		  size_t size, unsigned int *restrict key)
+		  size_t size, unsigned int *restrict key,
+		  unsigned long int *restrict crc)
 {
-    unsigned long int crc, crc_input;
+    unsigned long int line_crc, crc_input;
     unsigned int chksum, chksum_input;
     size_t srclen;
     char *xorbuf, *midxor;
@@ -856,6 +1503,23 @@ char *unscramble (char *restrict dest, const char *restrict src,
 	// No decryption required
 	assert(size >= srclen + 1);
 	strcpy(dest, src);
+    } else if (crc != NULL) {
+	// Unscramble the input, leaving checksums to the caller
+
+	xorbuf = xmalloc(size);
+
+	// Leave room in dest for the trailing NUL
+	xorlen = b64decode(src, srclen, xorbuf, size - 1);
+	if (xorlen < 0) {
+	    free(xorbuf);
+	    return NULL;
+	}
+
+	*crc = crc32_update(*crc, xorbuf, xorlen) & SCRAMBLE_CRC_MASK;
+	apply_xor(dest, xorbuf, xorlen, key);
+	dest[xorlen] = '\0';
+
+	free(xorbuf);
     } else {
 	// Unscramble the input
 
@@ -900,8 +1564,9 @@ char *unscramble (char *restrict dest, const char *restrict src,
 
 	// Calculate and compare CRC32 checksums
 	midxor = xorbuf + SCRAMBLE_CRC_LEN;
-	crc = crc32(midxor, xorlen - SCRAMBLE_CRC_LEN) & SCRAMBLE_CRC_MASK;
-	if (crc != crc_input) {
+	line_crc = crc32(midxor, xorlen - SCRAMBLE_CRC_LEN)
+	    & SCRAMBLE_CRC_MASK;
+	if (line_crc != crc_input) {
 	    free(xorbuf);
 	    return NULL;
 	}
@@ -921,7 +1586,7 @@ char *unscramble (char *restrict dest, const char *restrict src,
 
 
 /***********************************************************************/
-// apply_xor: Scramble a buffer using xor_table
+// apply_xor: Scramble a buffer using xor_keystream
 
 void apply_xor (char *restrict dest, const char *restrict src,
 		size_t n, unsigned int *restrict key)
@@ -931,9 +1596,32 @@ void apply_xor (char *restrict dest, const char *restrict src,
     assert(key != NULL);
     assert(*key < XOR_TABLE_SIZE);
 
-    for (size_t i = 0; i < n; i++, dest++, src++) {
-	*(unsigned char *) dest = *(unsigned char *) src ^ xor_table[*key];
-	*key = (*key + 1) % XOR_TABLE_SIZE;
+    while (n > 0) {
+	size_t len = MIN(n, XOR_TABLE_SIZE);
+	const unsigned char *ks = xor_keystream + *key;
+	size_t i = 0;
+
+	// XOR a machine word at a time; memcpy() avoids alignment issues
+	for ( ; i + sizeof(unsigned long int) <= len;
+	     i += sizeof(unsigned long int)) {
+	    unsigned long int w, k;
+
+	    memcpy(&w, src + i, sizeof(w));
+	    memcpy(&k, ks + i, sizeof(k));
+	    w ^= k;
+	    memcpy(dest + i, &w, sizeof(w));
+	}
+
+	// XOR any remaining bytes individually
+	for ( ; i < len; i++) {
+	    ((unsigned char *) dest)[i] = ((const unsigned char *) src)[i]
+		^ ks[i];
+	}
+
+	dest += len;
+	src += len;
+	n -= len;
+	*key = (*key + len) % XOR_TABLE_SIZE;
     }
 }
 
@@ -945,7 +1633,7 @@ size_t b64encode (const void *restrict in, size_t inlen,
 		  void *restrict out, size_t outlen)
 {
     size_t count;
-    size_t padding;
+    size_t i;
 
     // Note that bit manipulations on strings require unsigned char!
     const unsigned char *u_in = in;
@@ -957,53 +1645,43 @@ size_t b64encode (const void *restrict in, size_t inlen,
     assert(outlen > 0);
     assert(outlen > inlen);
 
-    count = 0;
-    padding = inlen % 3;
-
-    for (size_t i = 0; i < inlen; i += 3, u_in += 3) {
-	unsigned long int n;
-	unsigned char n0, n1, n2, n3;
-
-	// Convert three input bytes into a 24-bit number
-	n = u_in[0] << 16;
-	if (i + 1 < inlen) {
-	    n += u_in[1] << 8;
-	}
-	if (i + 2 < inlen) {
-	    n += u_in[2];
-	}
-
-	// Convert the 24-bit number into four Base64 bytes
-	n0 = (unsigned char) (n >> 18) & 0x3F;
-	n1 = (unsigned char) (n >> 12) & 0x3F;
-	n2 = (unsigned char) (n >> 6) & 0x3F;
-	n3 = (unsigned char) n & 0x3F;
+    // Output is four bytes per (possibly partial) group, plus "\n\0"
+    assert(outlen >= (inlen + 2) / 3 * 4 + 2);
 
-	assert(count + 3 < outlen);
+    if (! b64_pair_table_initialised) {
+	init_b64_pair_table();
+    }
 
-	*u_out++ = scramble_table[n0];
-	*u_out++ = scramble_table[n1];
-	count += 2;
+    // Convert complete three-byte groups, twelve bits at a time
+    for (i = 0; i + 3 <= inlen; i += 3, u_in += 3, u_out += 4) {
+	unsigned long int n = (unsigned long int) u_in[0] << 16
+	    | (unsigned long int) u_in[1] << 8 | u_in[2];
 
-	if (i + 1 < inlen) {
-	    *u_out++ = scramble_table[n2];
-	    count++;
-	}
-	if (i + 2 < inlen) {
-	    *u_out++ = scramble_table[n3];
-	    count++;
-	}
+	memcpy(u_out,     b64_pair_table[n >> 12],   2);
+	memcpy(u_out + 2, b64_pair_table[n & 0xFFF], 2);
     }
 
-    if (padding > 0) {
-	assert(count + 2 < outlen);
-	for ( ; padding < 3; padding++) {
-	    *u_out++ = SCRAMBLE_PAD_CHAR;
-	    count++;
-	}
+    // Convert any trailing one or two bytes, padding the output
+    switch (inlen - i) {
+    case 1:
+	*u_out++ = scramble_table[u_in[0] >> 2];
+	*u_out++ = scramble_table[(u_in[0] << 4) & 0x3F];
+	*u_out++ = SCRAMBLE_PAD_CHAR;
+	*u_out++ = SCRAMBLE_PAD_CHAR;
+	break;
+
+    case 2:
+	*u_out++ = scramble_table[u_in[0] >> 2];
+	*u_out++ = scramble_table[((u_in[0] << 4) | (u_in[1] >> 4)) & 0x3F];
+	*u_out++ = scramble_table[(u_in[1] << 2) & 0x3F];
+	*u_out++ = SCRAMBLE_PAD_CHAR;
+	break;
+
+    default:
+	break;
     }
 
-    assert(count + 2 <= outlen);
+    count = u_out - (unsigned char *) out;
 
     *u_out++ = '\n';
     *u_out = '\0';
@@ -1021,6 +1699,7 @@ ssize_t b64decode (const void *restrict in, size_t inlen,
 {
     size_t count;
     unsigned long int n;
+    size_t i;
 
     // Note that bit manipulations on strings require unsigned char!
     // Using char * results in very subtle bugs indeed...
@@ -1036,8 +1715,41 @@ ssize_t b64decode (const void *restrict in, size_t inlen,
     count = 0;
     n = 1;
 
-    for (size_t i = 0; i < inlen && *u_in != '\0'; i++, u_in++) {
-	int v = unscramble_table[*u_in];
+    for (i = 0; i < inlen && *u_in != '\0'; ) {
+	int v;
+
+	/* Fast path: four Base64 characters starting on a group
+	   boundary can be converted in one step.  Anything else
+	   (whitespace, padding, invalid characters or the end of the
+	   string) is handled one character at a time below. */
+	if (n == 1 && i + 4 <= inlen) {
+	    int v0 = unscramble_table[u_in[0]];
+	    int v1 = unscramble_table[u_in[1]];
+	    int v2 = unscramble_table[u_in[2]];
+	    int v3 = unscramble_table[u_in[3]];
+
+	    if ((v0 | v1 | v2 | v3) >= 0) {
+		unsigned long int m = (unsigned long int) v0 << 18
+		    | (unsigned long int) v1 << 12 | v2 << 6 | v3;
+
+		count += 3;
+		if (count > outlen) {
+		    return -1;
+		}
+
+		*u_out++ = m >> 16;
+		*u_out++ = m >> 8;
+		*u_out++ = m;
+
+		i += 4;
+		u_in += 4;
+		continue;
+	    }
+	}
+
+	v = unscramble_table[*u_in];
+	i++;
+	u_in++;
 
 	switch (v) {
 	case UNSCRAMBLE_INVALID:
@@ -1090,6 +1802,185 @@ ssize_t b64decode (const void *restrict in, size_t inlen,
 }
 
 
+/***********************************************************************/
+// init_b64_pair_table: Initialise the Base64 encoding pair table
+
+void init_b64_pair_table (void)
+{
+    for (unsigned int i = 0; i < B64_PAIR_TABLE_SIZE; i++) {
+	b64_pair_table[i][0] = scramble_table[i >> 6];
+	b64_pair_table[i][1] = scramble_table[i & 0x3F];
+    }
+
+    b64_pair_table_initialised = true;
+}
+
+
+/************************************************************************
+*                 Binary encoding function definitions                  *
+************************************************************************/
+
+// These functions are documented in the file "utils.h"
+
+
+/***********************************************************************/
+// put_bytes: Append bytes to a byte buffer
+
+void put_bytes (byte_buf_t *restrict buf, const void *restrict data,
+		size_t len)
+{
+    if (buf->len + len > buf->alloc) {
+	buf->alloc = MAX(buf->alloc * 2, buf->len + len + BUFSIZE);
+	buf->data = xrealloc(buf->data, buf->alloc);
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+
+/***********************************************************************/
+// put_varint: Append an unsigned LEB128 varint to a buffer
+
+void put_varint (byte_buf_t *buf, uint64_t val)
+{
+    unsigned char tmp[VARINT_MAX_LEN];
+    size_t n = 0;
+
+
+    while (val >= 0x80) {
+	tmp[n++] = (val & 0x7F) | 0x80;
+	val >>= 7;
+    }
+    tmp[n++] = val;
+
+    put_bytes(buf, tmp, n);
+}
+
+
+/***********************************************************************/
+// get_varint: Read an unsigned LEB128 varint
+
+bool get_varint (const unsigned char **restrict p,
+		 const unsigned char *restrict end, uint64_t *restrict val)
+{
+    uint64_t v = 0;
+    int shift;
+
+
+    for (shift = 0; shift < VARINT_MAX_LEN * 7; shift += 7) {
+	if (*p >= end) {
+	    return false;
+	}
+
+	unsigned char c = *(*p)++;
+	v |= (uint64_t) (c & 0x7F) << shift;
+	if ((c & 0x80) == 0) {
+	    *val = v;
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+
+/************************************************************************
+*                  Scratch memory function definitions                  *
+************************************************************************/
+
+// These functions are documented in the file "utils.h"
+
+
+/***********************************************************************/
+// scratch_mark: Return the current position in scratch memory
+
+scratch_mark_t scratch_mark (void)
+{
+    scratch_mark_t mark;
+
+
+    mark.block = scratch_cur;
+    mark.used  = scratch_used;
+    return mark;
+}
+
+
+/***********************************************************************/
+// scratch_alloc: Allocate temporary memory from scratch memory
+
+void *scratch_alloc (size_t size)
+{
+    void *p;
+
+
+    size = (MAX(size, 1) + SCRATCH_ALIGN - 1) & ~((size_t) SCRATCH_ALIGN - 1);
+
+    if (   scratch_cur < 0
+	|| scratch_used + size > scratch_block_size[scratch_cur]) {
+	// Move on to the next block, which is not in use
+	scratch_cur++;
+	scratch_used = 0;
+
+	if (scratch_cur == scratch_num_blocks) {
+	    scratch_num_blocks++;
+	    scratch_blocks = xrealloc(scratch_blocks, scratch_num_blocks
+				      * sizeof(scratch_blocks[0]));
+	    scratch_block_size = xrealloc(scratch_block_size, scratch_num_blocks
+					  * sizeof(scratch_block_size[0]));
+	    scratch_blocks[scratch_cur] = NULL;
+	    scratch_block_size[scratch_cur] = 0;
+	}
+
+	if (scratch_block_size[scratch_cur] < size) {
+	    scratch_block_size[scratch_cur] = MAX(size, SCRATCH_BLOCK_SIZE);
+	    free(scratch_blocks[scratch_cur]);
+	    scratch_blocks[scratch_cur] =
+		xmalloc(scratch_block_size[scratch_cur]);
+	}
+    }
+
+    p = scratch_blocks[scratch_cur] + scratch_used;
+    scratch_used += size;
+    return p;
+}
+
+
+/***********************************************************************/
+// scratch_release: Release scratch memory
+
+void scratch_release (scratch_mark_t mark)
+{
+    assert(mark.block < scratch_cur
+	   || (mark.block == scratch_cur && mark.used <= scratch_used));
+
+    scratch_cur  = mark.block;
+    scratch_used = mark.used;
+}
+
+
+/***********************************************************************/
+// scratch_chstrdup: Duplicate a chtype string in scratch memory
+
+chtype *scratch_chstrdup (const chtype *restrict chstr)
+{
+    const chtype *p;
+    int len;
+    chtype *ret;
+
+
+    // Determine chstr length, including ending NUL
+    for (len = 1, p = chstr; *p != '\0'; p++, len++)
+	;
+
+    ret = scratch_alloc(len * sizeof(chtype));
+    memcpy(ret, chstr, len * sizeof(chtype));
+    ret[len - 1] = '\0';	// Terminating NUL, just in case not present
+
+    return ret;
+}
+
+
 /************************************************************************
 *                  Miscellaneous function definitions                   *
 ************************************************************************/
@@ -1178,6 +2069,26 @@ void *xmalloc (size_t size)
 }
 
 
+/***********************************************************************/
+// xrealloc: Resize a block of memory, with checking
+
+void *xrealloc (void *ptr, size_t size)
+{
+    void *p;
+
+
+    if (size < 1)
+	size = 1;
+
+    p = realloc(ptr, size);
+    if (p == NULL) {
+	err_exit_nomem();
+    }
+
+    return p;
+}
+
+
 /***********************************************************************/
 // xstrdup: Duplicate a string, with checking
 
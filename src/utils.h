@@ -45,6 +45,28 @@
 #define EILSEQ_REPL	'?'	// Illegal character sequence replacement
 #define EILSEQ_REPL_WC	L'?'	// ... wide character version
 
+#define DTOSTR_BUFSIZE	64	// Buffer size big enough for xdtostr()
+
+#define VARINT_MAX_LEN	10	// Bytes to encode any uint64_t as a varint
+
+
+/************************************************************************
+*                       Utility type declarations                       *
+************************************************************************/
+
+// A growable buffer of bytes, used for binary file formats
+typedef struct byte_buf {
+    unsigned char	*data;
+    size_t		len;
+    size_t		alloc;
+} byte_buf_t;
+
+// A position in the scratch memory, returned by scratch_mark()
+typedef struct scratch_mark {
+    int			block;		// Block in use
+    size_t		used;		// Bytes used in that block
+} scratch_mark_t;
+
 
 /************************************************************************
 *                     Global variable declarations                      *
@@ -52,6 +74,8 @@
 
 extern const char *program_name;	// Canonical program name
 
+extern unsigned long int random_seed;	// Seed used by init_rand()
+
 
 // Global copy, suitably modified, of localeconv() information
 extern struct lconv lconvinfo;
@@ -115,21 +139,83 @@ extern const char *home_directory (void);
 extern const char *data_directory (void);
 
 
+/*
+  Function:   data_filename - Return the full pathname of a data file
+  Parameters: name          - Filename within the data directory
+  Returns:    char *        - Pointer to full pathname string
+
+  This function returns data_directory() + "/" + name as a malloc()ed
+  string (ie, a string that must be freed at a later time by calling
+  free()).  If data_directory() returns NULL, a copy of name is returned
+  instead.
+*/
+extern char *data_filename (const char *name);
+
+
 /*
   Function:   game_filename - Convert an integer to a game filename
-  Parameters: gamenum       - Game number (1-9) as an integer
+  Parameters: gamenum       - Game number (1 to MAX_GAME_NUM) as an integer
   Returns:    char *        - Pointer to game filename string
 
   This function returns the full game filename as a malloc()ed string
   (ie, a string that must be freed at a later time by calling free()).
 
-  If gamenum is between 1 and 9 inclusive, the string returned is in the
-  form data_directory() + "/" + GAME_FILENAME(gamenum).  If gamenum is
-  any other integer, NULL is returned.
+  If gamenum is between 1 and MAX_GAME_NUM inclusive, the string returned
+  is in the form data_directory() + "/" + GAME_FILENAME(gamenum).  If
+  gamenum is any other integer, NULL is returned.
 */
 extern char *game_filename (int gamenum);
 
 
+/*
+  Function:   game_filename_num - Convert a game filename to an integer
+  Parameters: name              - Filename (without any directory part)
+  Returns:    int               - Game number, or 0 if not a game file
+
+  This function does the reverse of game_filename(): if name is the
+  filename part of a game file, the game number (1 to MAX_GAME_NUM) is
+  returned, otherwise 0 is returned.
+*/
+extern int game_filename_num (const char *name);
+
+
+/*
+  Function:   startup_mark - Note that a phase of starting up has finished
+  Parameters: phase        - Name of the phase, or NULL to start timing
+  Returns:    (nothing)
+
+  This function records how long has passed since the previous call,
+  for startup_report() to show.  It is called with NULL at the very
+  start of the program.  Nothing more is recorded once startup_end() has
+  been called.
+*/
+extern void startup_mark (const char *phase);
+
+
+/*
+  Function:   startup_end - Note that the program has started up
+  Parameters: (none)
+  Returns:    (nothing)
+
+  This function records the end of the last phase of starting up, that
+  of showing the first screen, then stops recording.  It is called when
+  a key is waited for, so only its first call has any effect.
+*/
+extern void startup_end (void);
+
+
+/*
+  Function:   startup_report - Show how long starting up took
+  Parameters: (none)
+  Returns:    (nothing)
+
+  If option_startup_profile is true, this function writes the time
+  taken by each phase of starting up to stderr, in milliseconds.  It
+  must be called after the terminal display has been finalised.
+*/
+extern void startup_report (void);
+
+
 /************************************************************************
 *                  Error-reporting function prototypes                  *
 ************************************************************************/
@@ -196,7 +282,7 @@ extern void err_exit_nomem (void)
 
   This function initialises the pseudo-random number generator.  It
   should be called before any random-number functions declared in this
-  header are called.
+  header are called.  The seed used is kept in random_seed.
 */
 extern void init_rand (void);
 
@@ -225,6 +311,28 @@ extern double randf (void);
 extern int randi (int limit);
 
 
+/*
+  Function:   get_rand_state - Return the state of the random number generator
+  Parameters: state          - Where to store the state (output)
+  Returns:    (nothing)
+
+  This function stores the 48-bit state of the pseudo-random number
+  generator in state[], without disturbing that state.
+*/
+extern void get_rand_state (unsigned short int state[3]);
+
+
+/*
+  Function:   set_rand_state - Restore the state of the random number generator
+  Parameters: state          - State returned by get_rand_state()
+  Returns:    (nothing)
+
+  This function restores the state of the pseudo-random number generator
+  so that it returns the same numbers as when state[] was obtained.
+*/
+extern void set_rand_state (const unsigned short int state[3]);
+
+
 /************************************************************************
 *                   Locale-aware function prototypes                    *
 ************************************************************************/
@@ -267,15 +375,68 @@ extern void init_locale_vars (void);
               val      - Monetary value to convert
   Returns:    ssize_t  - Size of returned string
 
-  This function calls strfmon() to convert val to a suitable monetary
-  value string, then converts the result to a wide-character string and
-  places it in buf.  It makes appropriate adjustments to the output if
-  the POSIX locale is in effect or if the locale uses no-break spaces.
+  This function converts val to a suitable monetary value string, as
+  strfmon() would, and places it in buf as a wide-character string.  For
+  the formats "%n" and "%!n", the value is normally formatted directly
+  using rules prepared by init_locale_vars(), without allocating memory;
+  otherwise strfmon() is called and the result converted.  Appropriate
+  adjustments are made to the output if the POSIX locale is in effect or
+  if the locale uses no-break spaces.
 */
 extern ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
 			 const char *restrict format, double val);
 
 
+/*
+  Function:   xdtostr - Convert a double to a locale-independent string
+  Parameters: buf     - Buffer to receive result
+              bufsize - Size of buffer, in bytes
+              val     - Value to convert
+  Returns:    char *  - Pointer to buf
+
+  This function converts val to a string in the same form as "%e" does
+  in the POSIX locale, always using "." as the radix character no matter
+  what the current locale may be.  The fewest digits needed to read val
+  back exactly (with xstrtod()) are used: at most DBL_DIG + 2.
+
+  Unlike calling setlocale(LC_NUMERIC, "C") around printf(), this
+  function does not change any process-wide state.
+*/
+extern char *xdtostr (char *restrict buf, size_t bufsize, double val);
+
+
+/*
+  Function:   xdtofixed - Convert a double to a locale-independent string
+  Parameters: buf       - Buffer to receive result
+              bufsize   - Size of buffer, in bytes
+              val       - Value to convert
+              places    - Number of digits after the radix character
+  Returns:    char *    - Pointer to buf
+
+  This function converts val to a string in the same form as "%.*f" does
+  in the POSIX locale, with places digits after the radix character,
+  always using "." as the radix character no matter what the current
+  locale may be.  The result is truncated if it does not fit in buf;
+  DTOSTR_BUFSIZE is enough for any value shown by the game.
+*/
+extern char *xdtofixed (char *restrict buf, size_t bufsize, double val,
+			int places);
+
+
+/*
+  Function:   xstrtod - Convert a locale-independent string to a double
+  Parameters: str     - String to convert
+              endptr  - Pointer to end of converted string, or NULL
+  Returns:    double  - Converted value
+
+  This function behaves like strtod(), except that "." is always taken
+  as the radix character, as in the POSIX locale, no matter what the
+  current locale may be.  It reads both the output of xdtostr() and of
+  printf("%e") in the POSIX locale.
+*/
+extern double xstrtod (const char *restrict str, char **restrict endptr);
+
+
 /************************************************************************
 *                    Encryption function prototypes                     *
 ************************************************************************/
@@ -291,12 +452,18 @@ extern ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
               src      - Pointer to input buffer to encrypt
               size     - Size of output buffer
               key      - Pointer to encryption/decryption key
+              crc      - Pointer to running whole-file CRC32, or NULL
   Returns:    char *   - Pointer to output buffer
 
   This function scrambles (encrypts) the buffer *src and places the
   result in *dest.  It uses *key to keep a running encryption key.  If
   the key is NULL, no encryption is performed.
 
+  If crc is NULL, each scrambled line carries its own CRC32 and simple
+  checksum.  Otherwise, these are omitted and *crc is updated instead,
+  so that a single checksum can protect a whole file.  The crc parameter
+  is ignored if key is NULL.
+
   The input buffer should contain a C-style string terminated by '\0'.
   The output buffer will be terminated with '\n\0', even if the input
   does not have a terminating '\n'.  The pointer dest is returned as the
@@ -307,7 +474,8 @@ extern ssize_t xwcsfmon (wchar_t *restrict buf, size_t maxsize,
   initialised to zero before calling scramble() for the first time.
 */
 extern char *scramble (char *restrict dest, const char *restrict src,
-		       size_t size, unsigned int *restrict key);
+		       size_t size, unsigned int *restrict key,
+		       unsigned long int *restrict crc);
 
 
 /*
@@ -316,12 +484,15 @@ extern char *scramble (char *restrict dest, const char *restrict src,
               src        - Pointer to input buffer to decrypt
               size       - Size of output buffer
               key        - Pointer to encryption/decryption key
+              crc        - Pointer to running whole-file CRC32, or NULL
   Returns:    char *     - Pointer to output buffer or NULL on error
 
   This function does the reverse of scramble(): it unscrambles (decrypts)
   the buffer *src and places the result in *dest.  If key is NULL, no
   decryption takes place: the input buffer is copied to the output buffer
-  without changes.
+  without changes.  If crc is not NULL, the line is expected to have been
+  scrambled in whole-file checksum mode: *crc is updated and it is up to
+  the caller to check the final value.
 
   The buffer should contain a C-style string terminated by '\0'.  Note
   that src and dest MUST point to different buffers.  The pointer dest is
@@ -332,7 +503,108 @@ extern char *scramble (char *restrict dest, const char *restrict src,
   for the first time.
 */
 extern char *unscramble (char *restrict dest, const char *restrict src,
-			 size_t size, unsigned int *restrict key);
+			 size_t size, unsigned int *restrict key,
+			 unsigned long int *restrict crc);
+
+
+/************************************************************************
+*                  Binary encoding function prototypes                  *
+************************************************************************/
+
+/*
+  Function:   put_bytes - Append bytes to a byte buffer
+  Parameters: buf       - Buffer to append to
+              data      - Bytes to append
+              len       - Number of bytes
+  Returns:    (nothing)
+
+  This function appends len bytes to buf, enlarging it as needed.  A
+  byte_buf_t is empty when all its members are zero; its data must be
+  freed with free() when no longer needed.
+*/
+extern void put_bytes (byte_buf_t *restrict buf,
+		       const void *restrict data, size_t len);
+
+
+/*
+  Function:   put_varint - Append an unsigned LEB128 varint to a buffer
+  Parameters: buf        - Buffer to append to
+              val        - Value to append
+  Returns:    (nothing)
+
+  This function appends val to buf seven bits at a time, least
+  significant first, with the top bit of each byte set if more follow.
+  Values below 128 take just one byte.
+*/
+extern void put_varint (byte_buf_t *buf, uint64_t val);
+
+
+/*
+  Function:   get_varint - Read an unsigned LEB128 varint
+  Parameters: p          - Pointer to current position (updated)
+              end        - End of the available data
+              val        - Resulting value (output)
+  Returns:    bool       - True if a valid varint was read
+
+  This function reads a varint written by put_varint() from *p, never
+  reading at or beyond end.  On success, *p is advanced past the varint.
+*/
+extern bool get_varint (const unsigned char **restrict p,
+			const unsigned char *restrict end,
+			uint64_t *restrict val);
+
+
+/************************************************************************
+*                  Scratch memory function prototypes                   *
+************************************************************************/
+
+/*
+  Function:   scratch_mark - Return the current position in scratch memory
+  Parameters: (none)
+  Returns:    scratch_mark_t - Position to pass to scratch_release()
+*/
+extern scratch_mark_t scratch_mark (void);
+
+
+/*
+  Function:   scratch_alloc - Allocate temporary memory from scratch memory
+  Parameters: size          - Size of memory needed in bytes
+  Returns:    void *        - Pointer to memory, suitably aligned
+
+  This function returns memory for temporary use, such as formatting a
+  string for display, by bumping a pointer within a few large blocks
+  that are kept for the life of the program.  It is much faster than
+  malloc(): once the blocks have grown to the largest size needed, no
+  memory is ever allocated or freed.  The memory is released, together
+  with everything allocated after it, by calling scratch_release() with
+  the value scratch_mark() returned before it was allocated.  If memory
+  cannot be found, the program terminates with an "Out of memory" error.
+*/
+extern void *scratch_alloc (size_t size);
+
+
+/*
+  Function:   scratch_release - Release scratch memory
+  Parameters: mark            - Value previously returned by scratch_mark()
+  Returns:    (nothing)
+
+  This function releases all scratch memory allocated since mark was
+  returned.  Functions using scratch memory must release it before
+  returning, in the opposite order to allocation, just like local
+  variables.
+*/
+extern void scratch_release (scratch_mark_t mark);
+
+
+/*
+  Function:   scratch_chstrdup - Duplicate a chtype string in scratch memory
+  Parameters: chstr            - String to duplicate
+  Returns:    chtype *         - Pointer to new (duplicated) string
+
+  This function is the same as xchstrdup(), except that the new string
+  is allocated with scratch_alloc() and must not be freed.
+*/
+extern chtype *scratch_chstrdup (const chtype *restrict chstr);
 
 
 /************************************************************************
@@ -365,6 +637,19 @@ extern int xmkdir (const char *pathname, mode_t mode);
 extern void *xmalloc (size_t size);
 
 
+/*
+  Function:   xrealloc - Resize a block of memory, with checking
+  Parameters: ptr      - Pointer to existing block of memory, or NULL
+              size     - New size of block of memory in bytes
+  Returns:    void *   - Pointer to resized block of memory
+
+  This wrapper function resizes a block of memory by calling realloc(),
+  then checks if a NULL pointer has been returned.  If so, the program
+  terminates with an "Out of memory" error.
+*/
+extern void *xrealloc (void *ptr, size_t size);
+
+
 /*
   Function:   xstrdup - Duplicate a string, with checking
   Parameters: str     - String to duplicate